@@ -29,6 +29,9 @@
 //#include "transformer.h"
 #include "boomerang.h"
 #include "log.h"
+#include "profiler.h"
+#include "proccache.h"
+#include "snapshot.h"
 #if USE_XML
 #include "xmlprogparser.h"
 #endif
@@ -71,7 +74,8 @@ Boomerang::Boomerang() : logger(NULL), vFlag(false), printRtl(false),
 	loadBeforeDecompile(false), saveBeforeDecompile(false),
 	noProve(false), noChangeSignatures(false), conTypeAnalysis(false), dfaTypeAnalysis(true),
 	propMaxDepth(3), generateCallGraph(false), generateSymbols(false), noGlobals(false), assumeABI(false),
-	experimental(false), minsToStopAfter(0)
+	experimental(false), minsToStopAfter(0), internExps(false),
+	noPrecompiled(false), profiler(NULL), procCache(NULL)
 {
 	progPath = DATADIR "/";
 	outputPath = OUTPUTDIR "/";
@@ -152,16 +156,16 @@ void Boomerang::help()
 	std::cout << "  -E <addr>        : Decode the procedure at addr, no callees\n";
 	std::cout << "                     Use -e and -E repeatedly for multiple entry points\n";
 	std::cout << "  -ic              : Decode through type 0 Indirect Calls\n";
+	std::cout << "  -ie              : Intern (share) identical location Expressions in dataflow analysis\n";
 	std::cout << "  -S <min>         : Stop decompilation after specified number of minutes\n";
 	std::cout << "  -t               : Trace (print address of) every instruction decoded\n";
 	std::cout << "  -Tc              : Use old constraint-based type analysis\n";
 	std::cout << "  -Td              : Use data-flow-based type analysis\n";
-#if USE_XML
-	std::cout << "  -LD              : Load before decompile (<program> becomes xml input file)\n";
-	std::cout << "  -SD              : Save before decompile\n";
-#endif
+	std::cout << "  -LD              : Load before decompile (<program> becomes snapshot input file)\n";
+	std::cout << "  -SD              : Save a snapshot before decompile\n";
 	std::cout << "  -a               : Assume ABI compliance\n";
 	std::cout << "  -W               : Windows specific decompilation mode (requires pdb information)\n";
+	std::cout << "  -C <dir>         : Keep decompiled procs in dir, and reuse them while unchanged\n";
 	//std::cout << "  -pa              : only propagate if can propagate to all\n";
 	std::cout << "Output\n";
 	std::cout << "  -v               : Verbose\n";
@@ -172,6 +176,8 @@ void Boomerang::help()
 	std::cout << "  -gd <dot file>   : Generate a dotty graph of the program's CFG and DFG\n";
 	std::cout << "  -gc              : Generate a call graph (callgraph.out and callgraph.dot)\n";
 	std::cout << "  -gs              : Generate a symbol file (symbols.h)\n";
+	std::cout << "  -gp <file>       : Write the time and allocations of each phase of each proc to file\n";
+	std::cout << "                     (CSV if file ends in .csv, otherwise JSON)\n";
 	std::cout << "  -iw              : Write indirect call report to output/indirect.txt\n";
 	std::cout << "Misc.\n";
 	std::cout << "  -k               : Command mode, for available commands see -h cmd\n";
@@ -203,6 +209,7 @@ void Boomerang::help()
 	std::cout << "                     DriverMain)\n";
 	std::cout << "  -nr              : No removal of unneeded labels\n";
 	std::cout << "  -nR              : No removal of unused Returns\n";
+	std::cout << "  -nS              : No precompiled SSL or signature files (always parse them)\n";
 	std::cout << "  -l <depth>       : Limit multi-propagations to expressions with depth <depth>\n";
 	std::cout << "  -p <num>         : Only do num propagations\n";
 	std::cout << "  -m <num>         : Max memory depth\n";
@@ -301,19 +308,18 @@ int Boomerang::parseCmd(int argc, const char *argv[])
 			return 1;
 		}
 		prog = p;
-#if USE_XML
 	} else if (!strcmp(argv[0], "load")) {
 		if (argc <= 1) {
 			std::cerr << "not enough arguments for cmd\n";
 			return 1;
 		}
 		const char *fname = argv[1];
-		Prog *p = loadFromXML(fname);
+		Prog *p = loadSnapshot(fname);
 		if (p == NULL) {
 			// try guessing
-			p = loadFromXML((outputPath + fname + "/" + fname + ".xml").c_str());
+			p = loadSnapshot((outputPath + fname + "/" + fname + ".snap").c_str());
 			if (p == NULL) {
-				std::cerr << "failed to read xml " << fname << "\n";
+				std::cerr << "failed to read snapshot " << fname << "\n";
 				return 1;
 			}
 		}
@@ -323,8 +329,10 @@ int Boomerang::parseCmd(int argc, const char *argv[])
 			std::cerr << "need to load or decode before save!\n";
 			return 1;
 		}
-		persistToXML(prog);
-#endif
+		if (!saveSnapshot(prog)) {
+			std::cerr << "failed to save snapshot\n";
+			return 1;
+		}
 	} else if (!strcmp(argv[0], "decompile")) {
 		if (argc > 1) {
 			Proc *proc = prog->findProc(argv[1]);
@@ -714,6 +722,14 @@ int Boomerang::commandLine(int argc, const char *argv[])
 				generateSymbols = true;
 				stopBeforeDecompile = true;
 			}
+			else if (argv[i][2] == 'p') {
+				if (++i == argc) {
+					usage();
+					return 1;
+				}
+				profiler = new Profiler(argv[i]);
+				addWatcher(profiler);
+			}
 			break;
 		case 'o': {
 			outputPath = argv[++i];
@@ -766,6 +782,9 @@ int Boomerang::commandLine(int argc, const char *argv[])
 			case 'R':
 				noRemoveReturns = true;
 				break;
+			case 'S':
+				noPrecompiled = true;
+				break;
 			case 'g':
 				noGlobals = true;
 				break;
@@ -871,6 +890,8 @@ int Boomerang::commandLine(int argc, const char *argv[])
 		case 'i':
 			if (argv[i][2] == 'c')  // -ic;
 				decodeThruIndCall = true;
+			if (argv[i][2] == 'e')  // -ie
+				internExps = true;
 			if (argv[i][2] == 'w')  // -iw
 				if (ofsIndCallReport) {
 					std::string fname = getOutputPath() + "indirect.txt";
@@ -879,19 +900,11 @@ int Boomerang::commandLine(int argc, const char *argv[])
 			break;
 		case 'L':
 			if (argv[i][2] == 'D')
-#if USE_XML
 				loadBeforeDecompile = true;
-#else
-				std::cerr << "LD command not enabled since compiled without USE_XML\n";
-#endif
 			break;
 		case 'S':
 			if (argv[i][2] == 'D')
-#if USE_XML
 				saveBeforeDecompile = true;
-#else
-				std::cerr << "SD command not enabled since compiled without USE_XML\n";
-#endif
 			else {
 				sscanf(argv[++i], "%i", &minsToStopAfter);
 			}
@@ -907,6 +920,18 @@ int Boomerang::commandLine(int argc, const char *argv[])
 		case 'a':
 			assumeABI = true;
 			break;
+		case 'C': {
+			if (++i == argc || *argv[i] == '\0') {
+				usage();
+				return 1;
+			}
+			procCache = new ProcCache(argv[i]);
+			if (!createDirectory(procCache->getDir())) {
+				std::cerr << "could not create directory " << procCache->getDir() << " for the proc cache\n";
+				return 1;
+			}
+			break;
+		}
 		case 'l':
 			if (++i == argc) {
 				usage();
@@ -1063,6 +1088,8 @@ Prog *Boomerang::loadAndDecode(const char *fname, const char *pname)
 void stopProcess(int n)
 {
 	std::cerr << "\n\n Stopping process, timeout.\n";
+	if (Boomerang::get()->profiler)
+		Boomerang::get()->profiler->writeReport();  // The phases that were going show where the time went
 	exit(1);
 }
 
@@ -1090,24 +1117,26 @@ int Boomerang::decompile(const char *fname, const char *pname)
 	//std::cout << "setting up transformers...\n";
 	//ExpTransformer::loadAll();
 
-#if USE_XML
 	if (loadBeforeDecompile) {
 		std::cout << "loading persisted state...\n";
-		prog = loadFromXML(fname);
-	} else
-#endif
-	{
+		prog = loadSnapshot(fname);
+		if (prog == NULL) {
+			std::cerr << "failed to read snapshot " << fname << "\n";
+			return 1;
+		}
+	} else {
+		alert_start_phase(NULL, "decode");
 		prog = loadAndDecode(fname, pname);
+		alert_end_phase(NULL, "decode");
 		if (prog == NULL)
 			return 1;
 	}
 
-#if USE_XML
 	if (saveBeforeDecompile) {
 		std::cout << "saving persistable state...\n";
-		persistToXML(prog);
+		if (!saveSnapshot(prog))
+			std::cerr << "failed to save snapshot\n";
 	}
-#endif
 
 	if (stopBeforeDecompile)
 		return 0;
@@ -1137,6 +1166,11 @@ int Boomerang::decompile(const char *fname, const char *pname)
 	if (Boomerang::get()->ofsIndCallReport)
 		ofsIndCallReport->close();
 
+	if (profiler && !profiler->writeReport())
+		std::cerr << "could not write the profile\n";
+	if (procCache)
+		procCache->report();
+
 	time_t end;
 	time(&end);
 	int hours = (int)((end - start) / 60 / 60);
@@ -1152,6 +1186,27 @@ int Boomerang::decompile(const char *fname, const char *pname)
 	return 0;
 }
 
+/**
+ * Saves the state of the Prog object to a snapshot file, named after the program, in the output directory.
+ * \param prog The Prog object to save.
+ * \return True if saved.
+ */
+bool Boomerang::saveSnapshot(Prog *prog)
+{
+	LOG << "saving persistable state...\n";
+	return Snapshot::save(prog, prog->getRootCluster()->getOutPath("snap"));
+}
+/**
+ * Loads the state of a Prog object from a snapshot file, and loads the binary file it was decompiled from.
+ * \param fname The name of the snapshot file.
+ * \return The loaded Prog object, or NULL if it can't be loaded.
+ */
+Prog *Boomerang::loadSnapshot(const char *fname)
+{
+	LOG << "loading persisted state...\n";
+	return Snapshot::load(fname);
+}
+
 #if USE_XML
 /**
  * Saves the state of the Prog object to a XML file.
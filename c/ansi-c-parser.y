@@ -14,6 +14,7 @@
 
 	#include <list>
 	#include <string>
+	#include <utility>
 
 	class AnsiCScanner;
 
@@ -99,6 +100,8 @@
 		std::list<Signature *> signatures; \
 		std::list<Symbol *> symbols; \
 		std::list<SymbolRef *> refs; \
+		std::list<std::pair<std::string, Type *> > namedTypes; \
+		void addNamedType(const char *name, Type *ty); \
 		virtual ~AnsiCParser();
 
 %define CONSTRUCTOR_PARAM std::istream &in, bool trace
@@ -248,7 +251,7 @@ param
 
 type_decl
 	: TYPEDEF type_ident ';' {
-		Type::addNamedType($2->nam.c_str(), $2->ty);
+		addNamedType($2->nam.c_str(), $2->ty);
 	  }
 	| TYPEDEF type '(' '*' IDENTIFIER ')' '(' param_list ')' ';' {
 		Signature *sig = Signature::instantiate(plat, cc, NULL);
@@ -261,7 +264,7 @@ type_decl
 				delete *it;
 			}
 		delete $8;
-		Type::addNamedType($5, new PointerType(new FuncType(sig)));
+		addNamedType($5, new PointerType(new FuncType(sig)));
 	  }
 	| TYPEDEF type_ident '(' param_list ')' ';' {
 		Signature *sig = Signature::instantiate(plat, cc, $2->nam.c_str());
@@ -274,7 +277,7 @@ type_decl
 				delete *it;
 			}
 		delete $4;
-		Type::addNamedType($2->nam.c_str(), new FuncType(sig));
+		addNamedType($2->nam.c_str(), new FuncType(sig));
 	  }
 	| STRUCT IDENTIFIER '{' type_ident_list '}' ';' {
 		CompoundType *t = new CompoundType();
@@ -283,7 +286,7 @@ type_decl
 		}
 		char tmp[1024];
 		sprintf(tmp, "struct %s", $2);
-		Type::addNamedType(tmp, t);
+		addNamedType(tmp, t);
 	  }
 	;
 
@@ -473,6 +476,12 @@ void AnsiCParser::yyerror(const char *s)
 	fprintf(stderr, "%*s\n", theScanner->column, "^");
 }
 
+void AnsiCParser::addNamedType(const char *name, Type *ty)
+{
+	namedTypes.push_back(std::pair<std::string, Type *>(name, ty));
+	Type::addNamedType(name, ty);
+}
+
 AnsiCParser::~AnsiCParser()
 {
 	// Suppress warnings from gcc about lack of virtual destructor
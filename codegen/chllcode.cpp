@@ -25,6 +25,7 @@
 #include "type.h"
 #include "util.h"
 #include "log.h"
+#include "BinaryFile.h"
 
 #include <sstream>
 
@@ -44,9 +45,10 @@ CHLLCode::CHLLCode(UserProc *p) : HLLCode(p)
 {
 }
 
-/// Empty destructor
+/// Frees the generated code
 CHLLCode::~CHLLCode()
 {
+	reset();
 }
 
 /// Output \a indLevel tabs to \a str
@@ -972,7 +974,10 @@ void CHLLCode::appendTypeIdent(std::ostringstream &str, Type *typ, const char *i
 /// Remove all generated code.
 void CHLLCode::reset()
 {
+	for (std::list<char *>::iterator it = lines.begin(); it != lines.end(); it++)
+		free(*it);  // strdup()ed by appendLine()
 	lines.clear();
+	rawGlobals.clear();
 }
 
 /// Adds: while( \a cond) {
@@ -1155,7 +1160,9 @@ void CHLLCode::RemoveUnusedLabels(int maxOrd)
 			char *s = strdup(*it);
 			*strchr(s, ':') = 0;
 			int n = atoi(s + 1);
+			free(s);
 			if (usedLabels.find(n) == usedLabels.end()) {
+				free(*it);
 				it = lines.erase(it);
 				continue;
 			}
@@ -1197,6 +1204,7 @@ void CHLLCode::RemoveLabel(int ord)
 	s << "L" << std::dec << ord << ":";
 	for (std::list<char *>::iterator it = lines.begin(); it != lines.end(); it++) {
 		if (!strcmp(*it, s.str().c_str())) {
+			free(*it);
 			lines.erase(it);
 			break;
 		}
@@ -1661,11 +1669,60 @@ void CHLLCode::AddGlobal(const char *name, Type *type, Exp *init)
 	appendLine(s);
 }
 
+/**
+ * Adds the declaration of an array of unsigned bytes, initialised with the \a size bytes at \a uNative in \a pBF.
+ * This is what AddGlobal() with an opList of byte constants prints, but the bytes are only read by print(), a chunk
+ * at a time, so a whole data section can be output in -noDecompile mode without an Exp per byte.
+ */
+void CHLLCode::AddRawGlobal(const char *name, BinaryFile *pBF, ADDRESS uNative, unsigned size)
+{
+	Type *type = new ArrayType(new IntegerType(8, -1), size);
+	if (size == 0) {
+		AddGlobal(name, type);  // No initialiser, as for an empty list
+		return;
+	}
+	std::ostringstream s;
+	appendType(s, type->asArray()->getBaseType());
+	s << " " << name << "[" << std::dec << size << "] = ";
+	appendLine(s);
+	RawGlobal &g = rawGlobals[lines.back()];
+	g.pBF = pBF;
+	g.uNative = uNative;
+	g.size = size;
+}
+
+/// Print the initialiser of a raw global, laid out as appendExp() lays out an opList.
+void CHLLCode::printRawGlobal(std::ostream &os, const RawGlobal &g)
+{
+	unsigned char chunk[4096];
+	os << "{ " << std::dec;
+	for (unsigned done = 0; done < g.size; ) {
+		unsigned n = g.size - done;
+		if (n > sizeof chunk)
+			n = sizeof chunk;
+		for (unsigned i = 0; i < n; i++)
+			chunk[i] = (unsigned char)g.pBF->readNative1(g.uNative + done + i);
+		for (unsigned i = 0; i < n; i++, done++) {
+			os << (int)chunk[i];
+			if (done + 1 < g.size)
+				os << ((done + 1) % 16 == 0 ? ",\n " : ", ");
+		}
+	}
+	os << " };";
+}
+
 /// Dump all generated code to \a os.
 void CHLLCode::print(std::ostream &os)
 {
-	for (std::list<char *>::iterator it = lines.begin(); it != lines.end(); it++)
-		os << *it << std::endl;
+	for (std::list<char *>::iterator it = lines.begin(); it != lines.end(); it++) {
+		os << *it;
+		if (!rawGlobals.empty()) {
+			std::map<const char *, RawGlobal>::iterator rr = rawGlobals.find(*it);
+			if (rr != rawGlobals.end())
+				printRawGlobal(os, rr->second);
+		}
+		os << std::endl;
+	}
 	if (m_proc == NULL)
 		os << std::endl;
 }
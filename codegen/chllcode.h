@@ -16,6 +16,7 @@
 #ifndef _CHLLCODE_H_
 #define _CHLLCODE_H_
 
+#include <map>
 #include <string>
 #include <sstream>
 
@@ -95,6 +96,15 @@ private:
 	void appendLine(const std::ostringstream &ostr);
 	void appendLine(const std::string &s);
 
+	/// Bytes of the binary file to print after the line that declares them (see AddRawGlobal).
+	struct RawGlobal {
+		BinaryFile *pBF;
+		ADDRESS     uNative;
+		unsigned    size;
+	};
+	std::map<const char *, RawGlobal> rawGlobals;
+	void printRawGlobal(std::ostream &os, const RawGlobal &g);
+
 	/// All locals in a Proc
 	std::map<std::string, Type *> locals;
 
@@ -165,6 +175,7 @@ public:
 	virtual void AddProcEnd();
 	virtual void AddLocal(const char *name, Type *type, bool last = false);
 	virtual void AddGlobal(const char *name, Type *type, Exp *init = NULL);
+	virtual void AddRawGlobal(const char *name, BinaryFile *pBF, ADDRESS uNative, unsigned size);
 	virtual void AddPrototype(UserProc *proc);
 private:
 	        void AddProcDec(UserProc *proc, bool open);  // Implement AddProcStart and AddPrototype
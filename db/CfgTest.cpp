@@ -83,11 +83,22 @@ void CfgTest::testDominators()
 	         << FRONTIER_FIVE << " ";
 	int n5 = df->pbbToNode(bb);
 	std::set<int>::iterator ii;
-	std::set<int> &DFset = df->getDF(n5);
+	std::set<int> DFset = df->getDF(n5);
 	for (ii = DFset.begin(); ii != DFset.end(); ii++)
 		actual << std::hex << (unsigned)df->nodeToBB(*ii)->getLowAddr() << " ";
 	CPPUNIT_ASSERT_EQUAL(expected.str(), actual.str());
 
+	// The same frontier should be found after the working sets (or everything) have been released
+	df->releaseWorkingSets();
+	CPPUNIT_ASSERT_EQUAL(n5, df->pbbToNode(bb));
+	df->releaseAll();
+	df->dominators(cfg);
+	std::ostringstream again;
+	std::set<int> DFset2 = df->getDF(df->pbbToNode(bb));
+	for (ii = DFset2.begin(); ii != DFset2.end(); ii++)
+		again << std::hex << (unsigned)df->nodeToBB(*ii)->getLowAddr() << " ";
+	CPPUNIT_ASSERT_EQUAL(expected.str(), again.str());
+
 	pBF->UnLoad();
 	delete pFE;
 }
@@ -145,7 +156,7 @@ void CfgTest::testSemiDominators()
 #endif
 	expected << std::hex << SEMI_B << " " << SEMI_M << " ";
 	std::set<int>::iterator ii;
-	std::set<int> &DFset = df->getDF(nL);
+	std::set<int> DFset = df->getDF(nL);
 	for (ii = DFset.begin(); ii != DFset.end(); ii++)
 		actual << std::hex << (unsigned)df->nodeToBB(*ii)->getLowAddr() << " ";
 	CPPUNIT_ASSERT_EQUAL(expected.str(), actual.str());
@@ -186,7 +197,7 @@ void CfgTest::testPlacePhi()
 	// A_phi[x] should be the set {7 8 10 15 20 21} (all the join points)
 	std::ostringstream ost;
 	std::set<int>::iterator ii;
-	std::set<int> &A_phi = df->getA_phi(e);
+	std::set<int> A_phi = df->getA_phi(e);
 	for (ii = A_phi.begin(); ii != A_phi.end(); ++ii)
 		ost << *ii << " ";
 	std::string expected("7 8 10 15 20 21 ");
@@ -232,7 +243,7 @@ void CfgTest::testPlacePhi2()
 	    new Binary(opMinus,
 	        Location::regOf(29),
 	        new Const(8)));
-	std::set<int> &s = df->getA_phi(e);
+	std::set<int> s = df->getA_phi(e);
 	std::set<int>::iterator pp;
 	for (pp = s.begin(); pp != s.end(); pp++)
 		actual << *pp << " ";
@@ -247,7 +258,7 @@ void CfgTest::testPlacePhi2()
 	        Location::regOf(29),
 	        new Const(12)));
 
-	std::set<int> &s2 = df->getA_phi(e);
+	std::set<int> s2 = df->getA_phi(e);
 	for (pp = s2.begin(); pp != s2.end(); pp++)
 		actual2 << *pp << " ";
 	CPPUNIT_ASSERT_EQUAL(expected, actual2.str());
@@ -4,11 +4,21 @@
  *        data flow based type analysis code.
  */
 
+#define HELLO_PENTIUM       "test/pentium/hello"
+
 #include "DfaTest.h"
 #include "log.h"
 #include "boomerang.h"
+#include "prog.h"
+#include "proc.h"
+#include "cfg.h"
+#include "dataflow.h"
+#include "rtl.h"
+#include "statement.h"
 
 #include <iostream>     // For std::cerr
+#include <sstream>
+#include <ctime>        // For clock()
 
 class ErrLogger : public Log {
 public:
@@ -243,3 +253,260 @@ void DfaTest::testMeetUnion()
 	expected = "union { /*signed?*/int bow; float wow; }";
 	CPPUNIT_ASSERT_EQUAL(expected, actual);
 }
+
+/*
+ * The std::set based dominance frontier and phi placement code that DataFlow used before the bit sets, kept here to
+ * check the results of, and to time against, the current code
+ */
+static void refComputeDF(DataFlow *df, int n, std::vector<std::set<int> > &DF)
+{
+	std::set<int> S;
+	std::vector<PBB> &outEdges = df->nodeToBB(n)->getOutEdges();
+	std::vector<PBB>::iterator it;
+	for (it = outEdges.begin(); it != outEdges.end(); it++) {
+		int y = df->pbbToNode(*it);
+		if (df->getIdom(y) != n)
+			S.insert(y);
+	}
+	// Note: this is a linear search!
+	int sz = DF.size();
+	for (int c = 0; c < sz; ++c) {
+		if (df->getIdom(c) != n) continue;
+		refComputeDF(df, c, DF);
+		std::set<int> &s = DF[c];
+		std::set<int>::iterator ww;
+		for (ww = s.begin(); ww != s.end(); ww++) {
+			int w = *ww;
+			if (n == w || !df->doesDominate(n, w))
+				S.insert(w);
+		}
+	}
+	DF[n] = S;
+}
+
+static void refPlacePhi(std::vector<std::set<int> > &DF, std::map<Exp *, std::set<int>, lessExpStar> &defsites,
+                        std::vector<std::set<Exp *, lessExpStar> > &A_orig, std::map<Exp *, std::set<int>, lessExpStar> &A_phi)
+{
+	std::map<Exp *, std::set<int>, lessExpStar>::iterator mm;
+	for (mm = defsites.begin(); mm != defsites.end(); mm++) {
+		Exp *a = mm->first;
+		std::set<int> W = mm->second;
+		while (W.size()) {
+			int n = *W.begin();
+			W.erase(W.begin());
+			std::set<int>::iterator yy;
+			for (yy = DF[n].begin(); yy != DF[n].end(); yy++) {
+				int y = *yy;
+				std::set<int> &s = A_phi[a];
+				if (s.find(y) == s.end()) {
+					s.insert(y);
+					if (A_orig[y].find(a) == A_orig[y].end())
+						W.insert(y);
+				}
+			}
+		}
+	}
+}
+
+/*==============================================================================
+ * FUNCTION:        DfaTest::testPhiPlacementBenchmark
+ * OVERVIEW:        Compare the dominance frontiers and phi placement against the old std::set based code, on a
+ *                  synthetic procedure of 6000+ basic blocks, and report the times of both
+ *============================================================================*/
+#define BENCH_DIAMONDS 2000
+
+void DfaTest::testPhiPlacementBenchmark()
+{
+	// The frontend gives the register sizes for the phi functions
+	Prog *prog = new Prog;
+	FrontEnd *pFE = FrontEnd::Load(HELLO_PENTIUM, prog);
+	CPPUNIT_ASSERT(pFE != 0);
+	prog->setFrontEnd(pFE);
+	UserProc *proc = (UserProc *)prog->newProc("bench", 0x1000);
+	Cfg *cfg = proc->getCFG();
+
+	// A chain of diamonds: head -> left, right -> next head, with some loops back from every 7th left. Registers
+	// r24, r25 and r26 are defined in various blocks
+	ADDRESS addr = 0x1000;
+	std::vector<PBB> heads, lefts, rights;
+	for (int i = 0; i <= BENCH_DIAMONDS; i++) {
+		for (int k = 0; k < 3; k++) {
+			if (i == BENCH_DIAMONDS && k != 0) break;
+			int reg = 26;
+			if (k == 0 && i % 11 == 0) reg = 24;
+			if (k == 1 && i % 3 == 0) reg = 24;
+			if (k == 2 && i % 5 == 0) reg = 25;
+			Statement *s = new Assign(Location::regOf(reg), new Const(i));
+			s->setProc(proc);
+			std::list<Statement *> *ls = new std::list<Statement *>;
+			ls->push_back(s);
+			std::list<RTL *> *rtls = new std::list<RTL *>;
+			rtls->push_back(new RTL(addr, ls));
+			addr += 4;
+			if (k == 0)
+				heads.push_back(cfg->newBB(rtls, i == BENCH_DIAMONDS ? RET : TWOWAY, i == BENCH_DIAMONDS ? 0 : 2));
+			else if (k == 1)
+				lefts.push_back(cfg->newBB(rtls, (i % 7 == 6) ? TWOWAY : FALL, (i % 7 == 6) ? 2 : 1));
+			else
+				rights.push_back(cfg->newBB(rtls, FALL, 1));
+		}
+	}
+	for (int i = 0; i < BENCH_DIAMONDS; i++) {
+		cfg->addOutEdge(heads[i], lefts[i]);
+		cfg->addOutEdge(heads[i], rights[i]);
+		cfg->addOutEdge(lefts[i], heads[i + 1]);
+		if (i % 7 == 6)
+			cfg->addOutEdge(lefts[i], heads[i - 3]);
+		cfg->addOutEdge(rights[i], heads[i + 1]);
+	}
+	cfg->setEntryBB(heads[0]);
+	int numBB = cfg->getNumBBs();
+	CPPUNIT_ASSERT(numBB > 5000);
+
+	DataFlow *df = proc->getDataFlow();
+	clock_t start = clock();
+	df->dominators(cfg);
+	clock_t domDone = clock();
+
+	// The old dominance frontiers
+	std::vector<std::set<int> > refDF(numBB);
+	refComputeDF(df, 0, refDF);
+	clock_t refDomDone = clock();
+	for (int n = 0; n < numBB; n++)
+		CPPUNIT_ASSERT(df->getDF(n) == refDF[n]);
+
+	// The old phi placement, from the definitions in the (as yet phi free) BBs
+	std::vector<std::set<Exp *, lessExpStar> > A_orig(numBB);
+	std::map<Exp *, std::set<int>, lessExpStar> defsites;
+	for (int n = 0; n < numBB; n++) {
+		BasicBlock::rtlit rit; StatementList::iterator sit;
+		PBB bb = df->nodeToBB(n);
+		for (Statement *s = bb->getFirstStmt(rit, sit); s; s = bb->getNextStmt(rit, sit)) {
+			Exp *lhs = ((Assign *)s)->getLeft();
+			A_orig[n].insert(lhs);
+			defsites[lhs].insert(n);
+		}
+	}
+	std::map<Exp *, std::set<int>, lessExpStar> refA_phi;
+	clock_t refPhiStart = clock();
+	refPlacePhi(refDF, defsites, A_orig, refA_phi);
+	clock_t refPhiDone = clock();
+
+	clock_t phiStart = clock();
+	CPPUNIT_ASSERT(df->placePhiFunctions(proc));
+	clock_t phiDone = clock();
+
+	for (int reg = 24; reg <= 26; reg++) {
+		Exp *e = Location::regOf(reg);
+		CPPUNIT_ASSERT(!refA_phi[e].empty());
+		CPPUNIT_ASSERT(df->getA_phi(e) == refA_phi[e]);
+	}
+	// Nothing more to place the second time around
+	CPPUNIT_ASSERT(!df->placePhiFunctions(proc));
+
+	std::cerr << "\nDominators and frontiers of " << numBB << " BBs: "
+	          << (double)(domDone - start) / CLOCKS_PER_SEC << "s; std::set frontiers alone "
+	          << (double)(refDomDone - domDone) / CLOCKS_PER_SEC << "s\n";
+	std::cerr << "Phi placement: " << (double)(phiDone - phiStart) / CLOCKS_PER_SEC << "s, with std::set "
+	          << (double)(refPhiDone - refPhiStart) / CLOCKS_PER_SEC << "s\n";
+}
+
+// Make a BB of one RTL with the statements ls
+static PBB newStmtsBB(Cfg *cfg, ADDRESS addr, std::list<Statement *> *ls, BBTYPE type, int numOut)
+{
+	std::list<RTL *> *rtls = new std::list<RTL *>;
+	rtls->push_back(new RTL(addr, ls));
+	PBB bb = cfg->newBB(rtls, type, numOut);
+	for (std::list<Statement *>::iterator it = ls->begin(); it != ls->end(); it++)
+		(*it)->setBB(bb);
+	return bb;
+}
+
+/*==============================================================================
+ * FUNCTION:        DfaTest::testLoopTypes
+ * OVERVIEW:        Test the types that the data flow based type analysis gives a proc with a loop, where the type of
+ *                  a definition before the loop only comes from a use in it (via a phi). These are the types of the
+ *                  round robin analysis
+ *============================================================================*/
+void DfaTest::testLoopTypes()
+{
+	// The analysis looks for globals at the constants, so the prog needs a binary file
+	Prog *prog = new Prog;
+	FrontEnd *pFE = FrontEnd::Load(HELLO_PENTIUM, prog);
+	CPPUNIT_ASSERT(pFE != 0);
+	prog->setFrontEnd(pFE);
+	UserProc *proc = (UserProc *)prog->newProc("loop", 0x1000);
+	Cfg *cfg = proc->getCFG();
+
+	// entry: r24 := 0; r25 := 0
+	// loop:  r24 := phi(r24{1}, r24{5}); r25 := phi(r25{2}, r25{6}); r24 := r24{3} + 1; r25 := r25{4} + 4;
+	//        r27 := m[r25{4}]; if (r24{5} < 10) goto loop
+	// exit:  r26 := r24{5}; r28 := r27{7} * 2
+	// Only the multiply says what m[r25{4}] is, and so what r25{2} points to
+	Assign *s1 = new Assign(Location::regOf(24), new Const(0));
+	Assign *s2 = new Assign(Location::regOf(25), new Const(0));
+	PhiAssign *s3 = new PhiAssign(Location::regOf(24));
+	PhiAssign *s4 = new PhiAssign(Location::regOf(25));
+	Assign *s5 = new Assign(Location::regOf(24), new Binary(opPlus, new RefExp(Location::regOf(24), s3), new Const(1)));
+	Assign *s6 = new Assign(Location::regOf(25), new Binary(opPlus, new RefExp(Location::regOf(25), s4), new Const(4)));
+	Assign *s7 = new Assign(Location::regOf(27), Location::memOf(new RefExp(Location::regOf(25), s4)));
+	BranchStatement *s8 = new BranchStatement;
+	s8->setCondExpr(new Binary(opLess, new RefExp(Location::regOf(24), s5), new Const(10)));
+	Assign *s9 = new Assign(Location::regOf(26), new RefExp(Location::regOf(24), s5));
+	Assign *s10 = new Assign(Location::regOf(28), new Binary(opMult, new RefExp(Location::regOf(27), s7), new Const(2)));
+	s3->putAt(0, s1, Location::regOf(24));
+	s3->putAt(1, s5, Location::regOf(24));
+	s4->putAt(0, s2, Location::regOf(25));
+	s4->putAt(1, s6, Location::regOf(25));
+
+	std::list<Statement *> *ls = new std::list<Statement *>;
+	ls->push_back(s1); ls->push_back(s2);
+	PBB entry = newStmtsBB(cfg, 0x1000, ls, FALL, 1);
+	ls = new std::list<Statement *>;
+	ls->push_back(s3); ls->push_back(s4); ls->push_back(s5); ls->push_back(s6); ls->push_back(s7); ls->push_back(s8);
+	PBB loop = newStmtsBB(cfg, 0x1004, ls, TWOWAY, 2);
+	ls = new std::list<Statement *>;
+	ls->push_back(s9); ls->push_back(s10);
+	PBB exit = newStmtsBB(cfg, 0x1010, ls, RET, 0);
+	cfg->addOutEdge(entry, loop);
+	cfg->addOutEdge(loop, loop);
+	cfg->addOutEdge(loop, exit);
+	cfg->setEntryBB(entry);
+	int n = 1;
+	StatementList stmts;
+	proc->getStatements(stmts);
+	for (StatementList::iterator it = stmts.begin(); it != stmts.end(); it++) {
+		(*it)->setNumber(n++);
+		(*it)->setProc(proc);
+	}
+
+	proc->dfaTypeAnalysis();
+
+	std::ostringstream actual;
+	for (StatementList::iterator it = stmts.begin(); it != stmts.end(); it++) {
+		actual << *it << "\n";
+		std::list<Const *> lc;
+		(*it)->findConstants(lc);
+		for (std::list<Const *>::iterator cc = lc.begin(); cc != lc.end(); cc++)
+			actual << "  " << (*cc)->getType()->getCtype() << " " << *cc << "\n";
+	}
+	std::string expected =
+		"   1 *i0* r24 := 0\n"
+		"  ?int 0\n"
+		"   2 *u0** r25 := 0\n"
+		"  ?unsigned int * 0\n"
+		"   3 *i0* r24 := phi{1 5}\n"
+		"   4 *u0** r25 := phi{2 6}\n"
+		"   5 *i0* r24 := r24{3} + 1\n"
+		"  ?int 1\n"
+		"   6 *u0** r25 := r25{4} + 4\n"
+		"  /*signed?*/int 4\n"
+		"   7 *u0* r27 := m[r25{4}]\n"
+		"   8 BRANCH *no dest*, condition equals\n"
+		"High level: r24{5} < 10\n"
+		"  ?int 10\n"
+		"   9 *i0* r26 := r24{5}\n"
+		"  10 *u0* r28 := r27{7} * 2\n"
+		"  ?unsigned int 2\n";
+	CPPUNIT_ASSERT_EQUAL(expected, actual.str());
+}
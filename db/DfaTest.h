@@ -8,6 +8,8 @@ class DfaTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testMeetSize);
 	CPPUNIT_TEST(testMeetPointer);
 	CPPUNIT_TEST(testMeetUnion);
+	CPPUNIT_TEST(testPhiPlacementBenchmark);
+	CPPUNIT_TEST(testLoopTypes);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -17,4 +19,6 @@ public:
 	void testMeetSize();
 	void testMeetPointer();
 	void testMeetUnion();
+	void testPhiPlacementBenchmark();
+	void testLoopTypes();
 };
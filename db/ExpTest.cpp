@@ -10,6 +10,8 @@
 
 #include <map>
 #include <sstream>      // Gcc >= 3.0 needed
+#include <iostream>     // For std::cerr
+#include <ctime>        // For clock()
 
 /*==============================================================================
  * FUNCTION:        ExpTest::setUp
@@ -1388,3 +1390,210 @@ void ExpTest::testVisitors()
 	CPPUNIT_ASSERT_EQUAL(0, res);
 #endif
 }
+
+/*==============================================================================
+ * FUNCTION:        ExpTest::testIntern
+ * OVERVIEW:        Test hash consing with ExpFactory
+ *============================================================================*/
+void ExpTest::testIntern()
+{
+	ExpFactory fac;
+	Assign s5(new Terminal(opNil), new Terminal(opNil));
+	s5.setNumber(5);
+	// m[r28{5} - 4], built twice
+	Exp *e1 = Location::memOf(new Binary(opMinus, new RefExp(Location::regOf(28), &s5), new Const(4)));
+	Exp *e2 = e1->clone();
+	Exp *i1 = fac.intern(e1);
+	Exp *i2 = fac.intern(e2);
+	CPPUNIT_ASSERT(i1 == i2);
+	CPPUNIT_ASSERT(i1 != e1);
+	CPPUNIT_ASSERT(i1->isInterned());
+	CPPUNIT_ASSERT(!e1->isInterned());
+	CPPUNIT_ASSERT(*i1 == *e1);
+	CPPUNIT_ASSERT(*e1 == *i1);
+	CPPUNIT_ASSERT_EQUAL(e1->hash(), i1->hash());
+	CPPUNIT_ASSERT(fac.intern(i1) == i1);
+	// m, -, r28{5}, r28, 28 and 4
+	CPPUNIT_ASSERT_EQUAL(6U, fac.size());
+	CPPUNIT_ASSERT_EQUAL(6U, fac.getHits());
+
+	// Subexpressions are shared too
+	Exp *i3 = fac.intern(new RefExp(Location::regOf(28), &s5));
+	CPPUNIT_ASSERT(i3 == i1->getSubExp1()->getSubExp1());
+	Exp *i4 = fac.intern(Location::memOf(new Binary(opMinus, new RefExp(Location::regOf(28), &s5), new Const(8))));
+	CPPUNIT_ASSERT(!(*i4 == *i1));
+	CPPUNIT_ASSERT(*i1 < *i4);
+
+	// A set of interned and ordinary expressions stays ordered structurally
+	std::set<Exp *, lessExpStar> es;
+	es.insert(i4);
+	es.insert(i1);
+	es.insert(e2);
+	CPPUNIT_ASSERT_EQUAL(2, (int)es.size());
+	CPPUNIT_ASSERT(*es.begin() == i1);
+
+	// Modifications go to a copy
+	Exp *c1 = i1->clone();
+	CPPUNIT_ASSERT(!c1->isInterned());
+	CPPUNIT_ASSERT(*c1 == *i1);
+	bool change;
+	Exp *r1 = i1->searchReplaceAll(new Const(4), new Const(12), change);
+	CPPUNIT_ASSERT(change);
+	CPPUNIT_ASSERT(r1 != i1);
+	std::ostringstream ost;
+	ost << i1 << " " << r1;
+	CPPUNIT_ASSERT_EQUAL(std::string("m[r28{5} - 4] m[r28{5} - 12]"), ost.str());
+	Exp *r2 = i1->simplify();
+	CPPUNIT_ASSERT(!r2->isInterned());
+	CPPUNIT_ASSERT(*r2 == *i1);
+
+	// Wildcards and wild definitions are not interned
+	Exp *w1 = Location::memOf(new Terminal(opWild));
+	CPPUNIT_ASSERT(!ExpFactory::canIntern(w1));
+	CPPUNIT_ASSERT(fac.intern(w1) == w1);
+	Exp *w2 = new RefExp(Location::regOf(28), (Statement *)-1);
+	CPPUNIT_ASSERT(!ExpFactory::canIntern(w2));
+	CPPUNIT_ASSERT(ExpFactory::canIntern(new RefExp(Location::regOf(28), NULL)));
+}
+
+/*==============================================================================
+ * FUNCTION:        ExpTest::testCanonical
+ * OVERVIEW:        Test that simplify() skips expressions it has already simplified, and that changes are noticed
+ *============================================================================*/
+void ExpTest::testCanonical()
+{
+	// m[r28 + (4 + 8)]
+	Exp *e = Location::memOf(new Binary(opPlus,
+	                                    Location::regOf(28),
+	                                    new Binary(opPlus, new Const(4), new Const(8))));
+	CPPUNIT_ASSERT(!e->isCanonical());
+	unsigned skips = Exp::simplifySkips;
+	e = e->simplify();
+	CPPUNIT_ASSERT_EQUAL(std::string("m[r28 + 12]"), std::string(e->prints()));
+	CPPUNIT_ASSERT(e->isCanonical());
+	CPPUNIT_ASSERT_EQUAL(skips, Exp::simplifySkips);
+	CPPUNIT_ASSERT(e->simplify() == e);
+	CPPUNIT_ASSERT_EQUAL(skips + 1, Exp::simplifySkips);
+
+	// Changing a subexpression makes the whole expression need simplifying again
+	Exp *sum = e->getSubExp1();
+	sum->setSubExp2(new Binary(opMinus, new Const(20), new Const(4)));
+	CPPUNIT_ASSERT(sum->isCanonical() == false);
+	CPPUNIT_ASSERT(e->isCanonical() == false);
+	e = e->simplify();
+	CPPUNIT_ASSERT_EQUAL(std::string("m[r28 + 16]"), std::string(e->prints()));
+	((Const *)e->getSubExp1()->getSubExp2())->setInt(100);
+	CPPUNIT_ASSERT(!e->isCanonical());
+	e = e->simplify();
+	CPPUNIT_ASSERT_EQUAL(std::string("m[r28 + 100]"), std::string(e->prints()));
+	CPPUNIT_ASSERT(e->isCanonical());
+
+	// r0{def} can simplify differently when its definition changes, so it is never marked
+	Exp *m = Location::memOf(new RefExp(Location::regOf(0), NULL));
+	m = m->simplify();
+	CPPUNIT_ASSERT(!m->isCanonical());
+	skips = Exp::simplifySkips;
+	m->simplify();
+	CPPUNIT_ASSERT_EQUAL(skips, Exp::simplifySkips);
+}
+
+/*==============================================================================
+ * FUNCTION:        ExpTest::testMatch
+ * OVERVIEW:        Test matching expressions against textual patterns
+ *============================================================================*/
+void ExpTest::testMatch()
+{
+	// m[r28{-} - 4]
+	Exp *r28 = new RefExp(Location::regOf(28), NULL);
+	Exp *e = Location::memOf(new Binary(opMinus, r28, new Const(4)));
+	std::map<std::string, Exp *> b;
+	CPPUNIT_ASSERT(e->match("m[x{-} - k]", b));
+	CPPUNIT_ASSERT(b["x"] == r28->getSubExp1());
+	CPPUNIT_ASSERT(*b["k"] == Const(4));
+	CPPUNIT_ASSERT(!e->match("m[x + k]", b));
+	CPPUNIT_ASSERT(!e->match("m[x{5} - k]", b));
+	CPPUNIT_ASSERT(!e->match("a[x]", b));
+	CPPUNIT_ASSERT(e->match("m[x]", b));
+	CPPUNIT_ASSERT(b["x"] == e->getSubExp1());
+
+	// The same, through a compiled pattern
+	ExpPattern pat("m[x{-} - k]");
+	CPPUNIT_ASSERT_EQUAL(2, pat.getNumVars());
+	Exp *bound[2] = { NULL, NULL };
+	CPPUNIT_ASSERT(pat.match(e, bound));
+	CPPUNIT_ASSERT(bound[pat.getVarNum("x")] == r28->getSubExp1());
+	CPPUNIT_ASSERT(bound[pat.getVarNum("k")] == e->getSubExp1()->getSubExp2());
+	CPPUNIT_ASSERT_EQUAL(-1, pat.getVarNum("y"));
+
+	// Minus is left associative; constants and terminals are compared with the pattern's literals
+	Exp *d = new Binary(opMinus, new Binary(opMinus, Location::regOf(24), new Terminal(opPC)), new Const(-4));
+	b.clear();
+	CPPUNIT_ASSERT(d->match("x - %pc - -4", b));
+	CPPUNIT_ASSERT_EQUAL(1, (int)b.size());
+	CPPUNIT_ASSERT(!d->match("x - %pc - -8", b));
+	CPPUNIT_ASSERT(!d->match("x - %sp - -4", b));
+	CPPUNIT_ASSERT(!d->match("x - %flags - -4", b));
+	Exp *h = new Binary(opPlus, Location::regOf(24), new Const("abc"));
+	CPPUNIT_ASSERT(h->match("x + \"abc\"", b));
+	CPPUNIT_ASSERT(!h->match("x + \"abd\"", b));
+	CPPUNIT_ASSERT(!h->match("x + %pc", b));
+	CPPUNIT_ASSERT(!h->match("x + y * 2", b));  // No pattern syntax for *
+
+	// Array index and member access
+	Exp *a = new Binary(opMemberAccess,
+	                    new Binary(opArrayIndex, Location::regOf(8), Location::regOf(9)),
+	                    new Const("next"));
+	b.clear();
+	CPPUNIT_ASSERT(a->match("x[i].next", b));
+	CPPUNIT_ASSERT(*b["i"] == *Location::regOf(9));
+	CPPUNIT_ASSERT(a->match("x[i].m", b));
+	CPPUNIT_ASSERT(*b["m"] == Const("next"));
+	CPPUNIT_ASSERT(!a->match("m[x].next", b));
+}
+
+/*==============================================================================
+ * FUNCTION:        ExpTest::testMatchBench
+ * OVERVIEW:        Time matching with a compiled pattern, against compiling the pattern for every match, and against
+ *                    just printing the expression (which the old string matcher did at every level)
+ *============================================================================*/
+#define BENCH_MATCHES 200000
+void ExpTest::testMatchBench()
+{
+	Exp *e = Location::memOf(new Binary(opPlus,
+	                                    new Binary(opMinus, new RefExp(Location::regOf(28), NULL), new Const(4)),
+	                                    Location::regOf(24)));
+	const char *text = "m[x{-} - k + y]";
+	ExpPattern pat(text);
+	Exp *bound[3];
+	int hits = 0;
+
+	clock_t start = clock();
+	for (int i = 0; i < BENCH_MATCHES; i++)
+		if (pat.match(e, bound))
+			hits++;
+	clock_t compiledDone = clock();
+	for (int i = 0; i < BENCH_MATCHES; i++) {
+		std::map<std::string, Exp *> b;
+		if (e->match(text, b))
+			hits++;
+	}
+	clock_t byNameDone = clock();
+	for (int i = 0; i < BENCH_MATCHES; i++) {
+		ExpPattern p(text);
+		if (p.match(e, bound))
+			hits++;
+	}
+	clock_t recompileDone = clock();
+	for (int i = 0; i < BENCH_MATCHES; i++) {
+		std::ostringstream ost;
+		e->print(ost);
+	}
+	clock_t printDone = clock();
+	CPPUNIT_ASSERT_EQUAL(3 * BENCH_MATCHES, hits);
+
+	std::cerr << "\n" << BENCH_MATCHES << " matches: compiled "
+	          << (double)(compiledDone - start) / CLOCKS_PER_SEC << "s; by name "
+	          << (double)(byNameDone - compiledDone) / CLOCKS_PER_SEC << "s; compiling each time "
+	          << (double)(recompileDone - byNameDone) / CLOCKS_PER_SEC << "s; printing only "
+	          << (double)(printDone - recompileDone) / CLOCKS_PER_SEC << "s\n";
+}
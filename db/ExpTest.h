@@ -53,6 +53,10 @@ class ExpTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testAddUsedLocs);
 	CPPUNIT_TEST(testSubscriptVars);
 	CPPUNIT_TEST(testVisitors);
+	CPPUNIT_TEST(testIntern);
+	CPPUNIT_TEST(testCanonical);
+	CPPUNIT_TEST(testMatch);
+	CPPUNIT_TEST(testMatchBench);
 	CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -114,4 +118,8 @@ public:
 	void testAddUsedLocs();
 	void testSubscriptVars();
 	void testVisitors();
+	void testIntern();
+	void testCanonical();
+	void testMatch();
+	void testMatchBench();
 };
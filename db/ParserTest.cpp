@@ -8,9 +8,16 @@
 
 #include "ParserTest.h"
 #include "sslparser.h"
+#include "boomerang.h"
 
+#include <fstream>
 #include <sstream>
 
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+
 /*==============================================================================
  * FUNCTION:        ParserTest::testRead
  * OVERVIEW:        Test reading the SSL file
@@ -41,3 +48,51 @@ void ParserTest::testExp()
 	// Still should print to string s, not s2
 	CPPUNIT_ASSERT_EQUAL("   0 " + s, std::string(ost2.str()));
 }
+
+/*==============================================================================
+ * FUNCTION:        ParserTest::testCache
+ * OVERVIEW:        Test that the precompiled form of an SSL file reads back as the same dictionary
+ *============================================================================*/
+void ParserTest::testCache()
+{
+	// Work on a copy of the SSL file, so that the cache is not written into the source tree
+	char dirName[] = "/tmp/sslcacheXXXXXX";
+	CPPUNIT_ASSERT(mkdtemp(dirName) != NULL);
+	std::string sslFile = std::string(dirName) + "/sparc.ssl";
+	std::string cacheFile = sslFile + ".cache";
+	{
+		std::ifstream src(SPARC_SSL);
+		std::ofstream dst(sslFile.c_str());
+		dst << src.rdbuf();
+	}
+
+	Boomerang *boo = Boomerang::get();
+	bool save = boo->noPrecompiled;
+	boo->noPrecompiled = true;
+	RTLInstDict d;
+	CPPUNIT_ASSERT(d.readSSLFile(sslFile));
+	boo->noPrecompiled = save;
+	bool written = d.writeCache(sslFile);
+
+	RTLInstDict c;
+	bool read = written && c.readCache(sslFile);
+
+	// Clean up before checking
+	remove(cacheFile.c_str());
+	remove(sslFile.c_str());
+	rmdir(dirName);
+
+	CPPUNIT_ASSERT(written);
+	CPPUNIT_ASSERT(read);
+	std::ostringstream o1, o2;
+	d.print(o1);
+	c.print(o2);
+	CPPUNIT_ASSERT_EQUAL(o1.str(), o2.str());
+	CPPUNIT_ASSERT(d.RegMap == c.RegMap);
+	CPPUNIT_ASSERT(d.ParamSet == c.ParamSet);
+	CPPUNIT_ASSERT_EQUAL(d.DetParamMap.size(), c.DetParamMap.size());
+	CPPUNIT_ASSERT_EQUAL(d.DetRegMap.size(), c.DetRegMap.size());
+	CPPUNIT_ASSERT_EQUAL(d.DetRegMap[8].g_size(), c.DetRegMap[8].g_size());
+	CPPUNIT_ASSERT(d.fastMap == c.fastMap);
+	CPPUNIT_ASSERT_EQUAL(d.bigEndian, c.bigEndian);
+}
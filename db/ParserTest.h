@@ -6,6 +6,7 @@ class ParserTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE(ParserTest);
 	CPPUNIT_TEST(testRead);
 	CPPUNIT_TEST(testExp);
+	CPPUNIT_TEST(testCache);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -13,4 +14,5 @@ public:
 
 	void testRead();
 	void testExp();
+	void testCache();
 };
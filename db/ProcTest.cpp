@@ -10,6 +10,7 @@
 #include "BinaryFile.h"
 #include "BinaryFileStub.h"
 #include "pentiumfrontend.h"
+#include "rtl.h"
 
 #include <sstream>
 #include <map>
@@ -62,3 +63,145 @@ void ProcTest::testName()
 	delete prog;
 	//delete pFE;  // No! Deleting the prog deletes the pFE already (which deletes the BinaryFileFactory)
 }
+
+/*==============================================================================
+ * FUNCTION:        ProcTest::testRefCounter
+ * OVERVIEW:        Test the reference counts used to remove unused statements
+ *============================================================================*/
+void ProcTest::testRefCounter()
+{
+	m_proc = NULL;  // Nothing for tearDown
+	Assign a5, a9, other9;
+	a5.setNumber(5);
+	a9.setNumber(9);
+	other9.setNumber(9);  // E.g. from another proc
+	ImplicitAssign imp1(Location::regOf(28));
+	ImplicitAssign imp2(Location::regOf(29));
+
+	UserProc::RefCounter refCounts;
+	refCounts.addStmt(&a9);
+	refCounts.addStmt(&imp1);
+	refCounts[&a5]++;
+	refCounts[&a9] += 2;
+	refCounts[&imp1]++;
+	refCounts[&other9]++;
+	CPPUNIT_ASSERT_EQUAL(1, refCounts[&a5]);
+	CPPUNIT_ASSERT_EQUAL(2, refCounts[&a9]);
+	CPPUNIT_ASSERT_EQUAL(1, refCounts[&other9]);
+	// Implicit assignments are all numbered 0, but have separate counts
+	CPPUNIT_ASSERT_EQUAL(1, refCounts[&imp1]);
+	CPPUNIT_ASSERT_EQUAL(0, refCounts[&imp2]);
+	CPPUNIT_ASSERT( refCounts.inProc(&a9));
+	CPPUNIT_ASSERT( refCounts.inProc(&imp1));
+	CPPUNIT_ASSERT(!refCounts.inProc(&a5));
+	CPPUNIT_ASSERT(!refCounts.inProc(&other9));
+	CPPUNIT_ASSERT(!refCounts.inProc(&imp2));
+}
+
+/*==============================================================================
+ * FUNCTION:        ProcTest::testDefUseIndex
+ * OVERVIEW:        Test that the def-use index follows changes to the uses, and removed statements
+ *============================================================================*/
+void ProcTest::testDefUseIndex()
+{
+	std::string name("test");
+	UserProc *proc = new UserProc(new Prog(), name, 0x1000);
+	m_proc = proc;
+	// 1 r24 := 5
+	// 2 r25 := r24{1} + r24{1}
+	// 3 r26 := r25{2} + r28{-}
+	Assign *a1 = new Assign(Location::regOf(24), new Const(5));
+	Assign *a2 = new Assign(Location::regOf(25), new Binary(opPlus,
+	    new RefExp(Location::regOf(24), a1),
+	    new RefExp(Location::regOf(24), a1)));
+	Assign *a3 = new Assign(Location::regOf(26), new Binary(opPlus,
+	    new RefExp(Location::regOf(25), a2),
+	    new RefExp(Location::regOf(28), NULL)));
+	RTL *rtl = new RTL(0x1000);
+	rtl->appendStmt(a1);
+	rtl->appendStmt(a2);
+	rtl->appendStmt(a3);
+	std::list<RTL *> *pRtls = new std::list<RTL *>;
+	pRtls->push_back(rtl);
+	PBB bb = proc->getCFG()->newBB(pRtls, RET, 0);
+	Assign *stmts[] = {a1, a2, a3};
+	for (int i = 0; i < 3; i++) {
+		stmts[i]->setNumber(i + 1);
+		stmts[i]->setProc(proc);
+		stmts[i]->setBB(bb);
+	}
+
+	DefUseIndex &du = proc->getDefUses();
+	CPPUNIT_ASSERT_EQUAL((size_t)1, du.getUses(a1).size());  // The two uses of r24{1} are the same
+	CPPUNIT_ASSERT(du.getUses(a1)[0].user == a2);
+	CPPUNIT_ASSERT(du.getUses(a3).empty());
+	CPPUNIT_ASSERT(du.getUses(NULL).size() == 1 && du.getUses(NULL)[0].user == a3);
+	std::vector<Statement *> defs;
+	du.getDefsUsedBy(a3, defs);
+	CPPUNIT_ASSERT_EQUAL((size_t)2, defs.size());
+
+	// As if r24{1} was propagated into 3
+	a3->setRight(new Binary(opPlus,
+	    new RefExp(Location::regOf(24), a1),
+	    new RefExp(Location::regOf(28), NULL)));
+	a3->usesChanged();
+	std::vector<Statement *> users;
+	du.getUsers(a1, Location::regOf(24), users);
+	CPPUNIT_ASSERT_EQUAL((size_t)2, users.size());
+	CPPUNIT_ASSERT(users[0] == a2 && users[1] == a3);
+	CPPUNIT_ASSERT(du.getUses(a2).empty());
+
+	// Removing 2 removes its uses
+	proc->removeStatement(a2);
+	users.clear();
+	du.getUsers(a1, Location::regOf(24), users);
+	CPPUNIT_ASSERT(users.size() == 1 && users[0] == a3);
+	du.getDefsUsedBy(a2, defs);
+	CPPUNIT_ASSERT(defs.empty());
+
+	// Rebuilding from scratch gives the same
+	du.invalidate();
+	CPPUNIT_ASSERT(du.getUses(a1).size() == 1 && du.getUses(a1)[0].user == a3);
+}
+
+/*==============================================================================
+ * FUNCTION:        ProcTest::testInternedKeys
+ * OVERVIEW:        Test that with -ie the dataflow keys are shared within a proc, and let go when it reaches PROC_FINAL
+ *============================================================================*/
+void ProcTest::testInternedKeys()
+{
+	std::string name("test");
+	UserProc *proc = new UserProc(new Prog(), name, 0x1000);
+	m_proc = proc;
+	// 1 r24 := 5
+	// 2 r25 := r24 + 1
+	// 3 r24 := r25 + 1
+	Assign *stmts[] = {
+		new Assign(Location::regOf(24), new Const(5)),
+		new Assign(Location::regOf(25), new Binary(opPlus, Location::regOf(24), new Const(1))),
+		new Assign(Location::regOf(24), new Binary(opPlus, Location::regOf(25), new Const(1)))
+	};
+	RTL *rtl = new RTL(0x1000);
+	for (int i = 0; i < 3; i++)
+		rtl->appendStmt(stmts[i]);
+	std::list<RTL *> *pRtls = new std::list<RTL *>;
+	pRtls->push_back(rtl);
+	PBB bb = proc->getCFG()->newBB(pRtls, RET, 0);
+	proc->getCFG()->setEntryBB(bb);
+	for (int i = 0; i < 3; i++) {
+		stmts[i]->setNumber(i + 1);
+		stmts[i]->setProc(proc);
+		stmts[i]->setBB(bb);
+	}
+
+	DataFlow *df = proc->getDataFlow();
+	Boomerang::get()->internExps = true;
+	df->dominators(proc->getCFG());
+	df->placePhiFunctions(proc);
+	Boomerang::get()->internExps = false;
+	// r24 and r25, and their register numbers
+	CPPUNIT_ASSERT_EQUAL(4U, df->numInternedKeys());
+
+	proc->setStatus(PROC_FINAL);
+	CPPUNIT_ASSERT_EQUAL(0U, df->numInternedKeys());
+}
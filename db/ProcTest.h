@@ -12,6 +12,9 @@
 class ProcTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE(ProcTest);
 	CPPUNIT_TEST(testName);
+	CPPUNIT_TEST(testRefCounter);
+	CPPUNIT_TEST(testDefUseIndex);
+	CPPUNIT_TEST(testInternedKeys);
 	CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -23,4 +26,7 @@ public:
 	void tearDown();
 
 	void testName();
+	void testRefCounter();
+	void testDefUseIndex();
+	void testInternedKeys();
 };
@@ -9,10 +9,28 @@
 #include "ProgTest.h"
 #include "BinaryFile.h"
 #include "pentiumfrontend.h"
+#include "proc.h"
+#include "boomerang.h"
+#include "log.h"
+#include "profiler.h"
+#include "snapshot.h"
+#include "proccache.h"
+#include "cfg.h"
+#include "rtl.h"
+#include "statement.h"
+#include "exp.h"
+#include "type.h"
 
+#include <fstream>
 #include <map>
 #include <sstream>
 
+#include <cstdio>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 /*==============================================================================
  * FUNCTION:        ProgTest::setUp
  * OVERVIEW:        Set up some expressions for use with all the tests
@@ -20,9 +38,18 @@
  * PARAMETERS:      <none>
  * RETURNS:         <nothing>
  *============================================================================*/
+class NullLogger : public Log {
+public:
+	virtual Log &operator<<(const char *str) {
+		return *this;
+	}
+	virtual ~NullLogger() { };
+};
+
 void ProgTest::setUp()
 {
 	//prog.setName("default name");
+	Boomerang::get()->setLogger(new NullLogger());
 }
 
 /*==============================================================================
@@ -47,5 +74,289 @@ void ProgTest::testName()
 	delete pFE;
 }
 
+// The proc, phase, calls, allocs and selfAllocs fields of a line of a CSV profile
+static std::string profileFields(const std::string &line)
+{
+	std::string ret;
+	std::istringstream is(line);
+	std::string field;
+	for (int i = 0; std::getline(is, field, ','); i++)
+		if (i <= 2 || i == 5 || i == 6)
+			ret += field + " ";
+	return ret;
+}
+
+/*==============================================================================
+ * FUNCTION:        ProgTest::testProfiler
+ * OVERVIEW:        Test the totals for nested phases in the profile written for -gp
+ *============================================================================*/
+void ProgTest::testProfiler()
+{
+	const char *fileName = "profile-test.csv";
+	Profiler prof(fileName);
+	std::string name("proc1");
+	UserProc *p = new UserProc(new Prog(), name, 0x1000);
+	prof.alert_start_phase(NULL, "decompile");
+	prof.alert_start_phase(p, "decompile");
+	prof.alert_start_phase(p, "middleDecompile");
+	Profiler::numAllocs += 3;
+	prof.alert_start_phase(p, "decompile");  // E.g. restarted after decoding a switch
+	Profiler::numAllocs += 5;
+	prof.alert_end_phase(p, "decompile");
+	prof.alert_end_phase(p, "middleDecompile");
+	prof.alert_end_phase(p, "decompile");
+	prof.alert_start_phase(p, "fromSSAform");  // Never ended
+	CPPUNIT_ASSERT(prof.writeReport());
+
+	std::ifstream in(fileName);
+	std::string line, actual;
+	std::getline(in, line);
+	CPPUNIT_ASSERT_EQUAL(std::string("proc,phase,calls,seconds,selfSeconds,allocs,selfAllocs,bytes,selfBytes"), line);
+	while (std::getline(in, line))
+		actual += profileFields(line) + "\n";
+	in.close();
+	remove(fileName);
+	// The restarted decompile only counts once towards the allocations of decompile, but its own allocations count as
+	// self allocations
+	std::string expected =
+	    "\"\" decompile 1 8 0 \n"
+	    "\"proc1\" decompile 2 8 5 \n"
+	    "\"proc1\" middleDecompile 1 8 3 \n"
+	    "\"proc1\" fromSSAform 1 0 0 \n";
+	CPPUNIT_ASSERT_EQUAL(expected, actual);
+}
+
+/*==============================================================================
+ * FUNCTION:        ProgTest::testSnapshot
+ * OVERVIEW:        Test saving a Prog to a snapshot and reading it back
+ *============================================================================*/
+// Make proc1 at 0x1000 in prog, with rtl as its only BB, its statements numbered from 1, and the given status
+static UserProc *makeTestProc(Prog *prog, RTL *rtl, ProcStatus status)
+{
+	UserProc *proc = (UserProc *)prog->newProc("proc1", 0x1000);
+	std::list<RTL *> *rtls = new std::list<RTL *>;
+	rtls->push_back(rtl);
+	PBB bb = proc->getCFG()->newBB(rtls, FALL, 0);
+	proc->getCFG()->setEntryBB(bb);
+	int n = 1;
+	StatementList stmts;
+	proc->getStatements(stmts);
+	for (StatementList::iterator it = stmts.begin(); it != stmts.end(); it++) {
+		(*it)->setNumber(n++);
+		(*it)->setProc(proc);
+	}
+	proc->setStatus(status);
+	return proc;
+}
+
+void ProgTest::testSnapshot()
+{
+	const char *fileName = "snapshot-test.snap";
+	Prog *prog = new Prog("snaptest");
+	Exp *one = new Const(1);
+	RTL *rtl = new RTL(0x1000);
+	Assign *a1 = new Assign(new IntegerType(32), Location::regOf(24), new Const(5));
+	Assign *a2 = new Assign(Location::regOf(25),
+	                        new Binary(opPlus, new RefExp(Location::regOf(24), a1), one));
+	Assign *a3 = new Assign(Location::memOf(new RefExp(Location::regOf(25), a2)), one);
+	Assign *a4 = new Assign(new PointerType(new CharType()), Location::regOf(26), new Const("hello"));
+	rtl->appendStmt(a1);
+	rtl->appendStmt(a2);
+	rtl->appendStmt(a3);
+	rtl->appendStmt(a4);
+	UserProc *proc = makeTestProc(prog, rtl, PROC_DECODED);
+	CPPUNIT_ASSERT(Snapshot::save(prog, fileName));
+
+	Prog *copy = Snapshot::read(fileName);
+	remove(fileName);
+	CPPUNIT_ASSERT(copy != NULL);
+	CPPUNIT_ASSERT_EQUAL(std::string("snaptest"), std::string(copy->getName()));
+	UserProc *proc2 = (UserProc *)copy->findProc(0x1000);
+	CPPUNIT_ASSERT(proc2 != NULL && proc2 != proc);
+	CPPUNIT_ASSERT_EQUAL(std::string("proc1"), std::string(proc2->getName()));
+	CPPUNIT_ASSERT_EQUAL((int)PROC_DECODED, (int)proc2->getStatus());
+	std::ostringstream expected, actual;
+	proc->print(expected);
+	proc2->print(actual);
+	CPPUNIT_ASSERT_EQUAL(expected.str(), actual.str());
+
+	// The definitions are the new statements, and expressions shared before are shared after
+	StatementList stmts2;
+	proc2->getStatements(stmts2);
+	CPPUNIT_ASSERT_EQUAL(4, (int)stmts2.size());
+	StatementList::iterator it = stmts2.begin();
+	Assign *b1 = (Assign *)*it++;
+	Assign *b2 = (Assign *)*it++;
+	Assign *b3 = (Assign *)*it++;
+	CPPUNIT_ASSERT(b1 != a1);
+	CPPUNIT_ASSERT(((RefExp *)b2->getRight()->getSubExp1())->getDef() == b1);
+	CPPUNIT_ASSERT(b2->getRight()->getSubExp2() == b3->getRight());
+	CPPUNIT_ASSERT(b1->getProc() == proc2);
+
+	// Anything else is not read
+	std::ofstream of(fileName);
+	of << "not a snapshot";
+	of.close();
+	CPPUNIT_ASSERT(Snapshot::read(fileName) == NULL);
+	remove(fileName);
+}
+
 // Pathetic: the second test we had (for readLibraryParams) is now obsolete;
 // the front end does this now.
+
+// A proc at 0x1000 of prog, decoded but not decompiled, that sets r24 to value and then adds it to r25
+static UserProc *cacheTestProc(Prog *prog, int value)
+{
+	RTL *rtl = new RTL(0x1000);
+	Assign *a1 = new Assign(new IntegerType(32), Location::regOf(24), new Const(value));
+	rtl->appendStmt(a1);
+	rtl->appendStmt(new Assign(Location::regOf(25),
+	                           new Binary(opPlus, Location::regOf(25), new RefExp(Location::regOf(24), a1))));
+	return makeTestProc(prog, rtl, PROC_VISITED);
+}
+
+// A proc at 0x1000 of a new prog, decoded but not decompiled, that calls the proc callee at 0x2000
+static UserProc *cacheCallerProc(Proc *&callee)
+{
+	Prog *prog = new Prog("cachetest");
+	callee = prog->newProc("callee", 0x2000);
+	RTL *rtl = new RTL(0x1000);
+	CallStatement *call = new CallStatement;
+	call->setDestProc(callee);
+	rtl->appendStmt(call);
+	return makeTestProc(prog, rtl, PROC_VISITED);
+}
+
+// Remove the cache directory dirName and its entries
+static void removeCacheDir(const char *dirName)
+{
+	DIR *dir = opendir(dirName);
+	if (dir) {
+		while (struct dirent *ent = readdir(dir))
+			if (ent->d_name[0] != '.')
+				remove((std::string(dirName) + "/" + ent->d_name).c_str());
+		closedir(dir);
+	}
+	rmdir(dirName);
+}
+
+/*==============================================================================
+ * FUNCTION:        ProgTest::testProcCache
+ * OVERVIEW:        Test that a proc saved in the ProcCache is restored into another prog with the same proc, and not
+ *                  into one where the proc is different
+ *============================================================================*/
+void ProgTest::testProcCache()
+{
+	const char *dirName = "proccache-test";
+	mkdir(dirName, 0777);
+	ProcCache *cache = new ProcCache(dirName);
+
+	UserProc *proc = cacheTestProc(new Prog("cachetest"), 5);
+	CPPUNIT_ASSERT(!cache->load(proc));
+	proc->setStatus(PROC_FINAL);
+	cache->save(proc);
+
+	UserProc *same = cacheTestProc(new Prog("cachetest"), 5);
+	UserProc *changed = cacheTestProc(new Prog("cachetest"), 6);
+	bool restored = cache->load(same);
+	bool restoredChanged = cache->load(changed);
+
+	// Clean up before checking
+	removeCacheDir(dirName);
+
+	CPPUNIT_ASSERT(restored);
+	CPPUNIT_ASSERT(!restoredChanged);
+	std::ostringstream expected, actual;
+	proc->print(expected);
+	same->print(actual);
+	CPPUNIT_ASSERT_EQUAL(expected.str(), actual.str());
+	StatementList stmts;
+	same->getStatements(stmts);
+	CPPUNIT_ASSERT_EQUAL(2, (int)stmts.size());
+	StatementList::iterator it = stmts.begin();
+	Assign *b1 = (Assign *)*it++;
+	Assign *b2 = (Assign *)*it;
+	CPPUNIT_ASSERT(b2->getProc() == same);
+	CPPUNIT_ASSERT(((RefExp *)b2->getRight()->getSubExp2())->getDef() == b1);
+}
+
+/*==============================================================================
+ * FUNCTION:        ProgTest::testProcCacheCallers
+ * OVERVIEW:        Test that the calls of a proc restored from the ProcCache are callers of their callees, as those
+ *                  of a decompiled proc are, so that the callees' returns are kept for them
+ *============================================================================*/
+void ProgTest::testProcCacheCallers()
+{
+	const char *dirName = "proccache-test";
+	mkdir(dirName, 0777);
+	ProcCache *cache = new ProcCache(dirName);
+
+	Proc *callee;
+	UserProc *proc = cacheCallerProc(callee);
+	CPPUNIT_ASSERT(!cache->load(proc));
+	proc->setStatus(PROC_FINAL);
+	cache->save(proc);
+
+	UserProc *same = cacheCallerProc(callee);
+	bool restored = cache->load(same);
+
+	removeCacheDir(dirName);
+
+	CPPUNIT_ASSERT(restored);
+	StatementList stmts;
+	same->getStatements(stmts);
+	CPPUNIT_ASSERT_EQUAL(1, (int)stmts.size());
+	Statement *call = *stmts.begin();
+	CPPUNIT_ASSERT(call->isCall());
+	std::set<CallStatement *> &callers = callee->getCallers();
+	CPPUNIT_ASSERT_EQUAL(1, (int)callers.size());
+	CPPUNIT_ASSERT(*callers.begin() == call);
+}
+
+// A new prog for the image of HELLO_PENTIUM, and its .rodata section
+static Prog *helloProg(SectionInfo *&rodata)
+{
+	static BinaryFileFactory bff;
+	BinaryFile *pBF = bff.Load(HELLO_PENTIUM);
+	Prog *prog = new Prog;
+	prog->setFrontEnd(new PentiumFrontEnd(pBF, prog, &bff));
+	rodata = pBF->GetSectionInfoByName(".rodata");
+	return prog;
+}
+
+/*==============================================================================
+ * FUNCTION:        ProgTest::testProcCacheImage
+ * OVERVIEW:        Test that a proc which read the image while it was decompiled is only restored if what it read is
+ *                  the same
+ *============================================================================*/
+void ProgTest::testProcCacheImage()
+{
+	const char *dirName = "proccache-test";
+	mkdir(dirName, 0777);
+	ProcCache *cache = new ProcCache(dirName);
+
+	SectionInfo *rodata;
+	Prog *prog = helloProg(rodata);
+	UserProc *proc = cacheTestProc(prog, 5);
+	CPPUNIT_ASSERT(!cache->load(proc));
+	prog->readNative4(rodata->uNativeAddr + 4);  // As the pipeline would, e.g. for a switch table
+	proc->setStatus(PROC_FINAL);
+	cache->save(proc);
+
+	UserProc *same = cacheTestProc(helloProg(rodata), 5);
+	bool restored = cache->load(same);
+	// Change a byte that was read, and one that wasn't
+	UserProc *changed = cacheTestProc(helloProg(rodata), 5);
+	((char *)rodata->uHostAddr)[7] ^= 1;
+	bool restoredChanged = cache->load(changed);
+	((char *)rodata->uHostAddr)[7] ^= 1;
+	UserProc *other = cacheTestProc(helloProg(rodata), 5);
+	((char *)rodata->uHostAddr)[8] ^= 1;
+	bool restoredOther = cache->load(other);
+
+	removeCacheDir(dirName);
+
+	CPPUNIT_ASSERT(restored);
+	CPPUNIT_ASSERT(!restoredChanged);
+	CPPUNIT_ASSERT(restoredOther);
+}
@@ -5,6 +5,11 @@
 class ProgTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE(ProgTest);
 	CPPUNIT_TEST(testName);
+	CPPUNIT_TEST(testProfiler);
+	CPPUNIT_TEST(testSnapshot);
+	CPPUNIT_TEST(testProcCache);
+	CPPUNIT_TEST(testProcCacheImage);
+	CPPUNIT_TEST(testProcCacheCallers);
 	CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -16,4 +21,9 @@ public:
 	void setUp();
 
 	void testName();
+	void testProfiler();
+	void testSnapshot();
+	void testProcCache();
+	void testProcCacheImage();
+	void testProcCacheCallers();
 };
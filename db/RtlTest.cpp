@@ -260,3 +260,51 @@ void RtlTest::testSetConscripts()
 	std::string actual = ost.str();
 	CPPUNIT_ASSERT_EQUAL(expected, actual);
 }
+
+/*==============================================================================
+ * FUNCTION:        RtlTest::testInstantiate
+ * OVERVIEW:        Test that instantiating a compiled template gives the same as the general way
+ *============================================================================*/
+void RtlTest::testInstantiate()
+{
+	// r[rd] := r[rs1] + imm
+	// imm = 0 => r3 := succ(r[rs1])
+	RTL rtl;
+	rtl.appendStmt(new Assign(new IntegerType(32),
+	                          Location::regOf(Location::param("rd")),
+	                          new Binary(opPlus,
+	                                     Location::regOf(Location::param("rs1")),
+	                                     Location::param("imm"))));
+	rtl.appendStmt(new Assign(new IntegerType(32),
+	                          Location::regOf(3),
+	                          new Unary(opSuccessor, Location::regOf(Location::param("rs1"))),
+	                          new Binary(opEquals, Location::param("imm"), new Const(0))));
+	std::list<std::string> params;
+	params.push_back("rd");
+	params.push_back("rs1");
+	params.push_back("imm");
+	RTLInstDict dict;
+	std::string name("ADD");
+	dict.appendToDict(name, params, rtl);
+	dict.compileTemplates();
+	TableEntry &entry = dict.idict[name];
+	CPPUNIT_ASSERT(entry.tmpl.isCompiled());
+	CPPUNIT_ASSERT(!entry.tmpl.hasPostVars());
+
+	std::vector<Exp *> actuals;
+	actuals.push_back(new Const(8));
+	actuals.push_back(new Const(5));
+	actuals.push_back(new Binary(opMinus, Location::regOf(9), new Const(4)));
+	std::list<Statement *> *compiled = dict.instantiateRTL(name, 0x1000, actuals);
+	std::list<Statement *> *general = dict.instantiateRTL(entry.rtl, 0x1000, entry.params, actuals);
+	std::ostringstream o1, o2;
+	std::list<Statement *>::iterator it;
+	for (it = compiled->begin(); it != compiled->end(); it++)
+		o1 << *it << "\n";
+	for (it = general->begin(); it != general->end(); it++)
+		o2 << *it << "\n";
+	std::string expected("   0 *j32* r8 := (r5 + r9) - 4\n"
+	                     "   0 *j32* (r9 - 4) = 0 => r3 := r6\n");
+	CPPUNIT_ASSERT_EQUAL(expected, o1.str());
+	CPPUNIT_ASSERT_EQUAL(expected, o2.str());
+}
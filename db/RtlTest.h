@@ -9,6 +9,7 @@ class RtlTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testVisitor);
 	CPPUNIT_TEST(testIsCompare);
 	CPPUNIT_TEST(testSetConscripts);
+	CPPUNIT_TEST(testInstantiate);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -19,4 +20,5 @@ public:
 	void testVisitor();
 	void testIsCompare();
 	void testSetConscripts();
+	void testInstantiate();
 };
@@ -716,6 +716,75 @@ void StatementTest::testWildLocationSet()
 	CPPUNIT_ASSERT(!ls.findDifferentRef(&r22_10, x));
 }
 
+/*==============================================================================
+ * FUNCTION:        StatementTest::testConnectionGraph
+ * OVERVIEW:        Test the interference graph, and the numbering of live locations that feeds it
+ *============================================================================*/
+void StatementTest::testConnectionGraph()
+{
+	Location rof12(opRegOf, new Const(12), NULL);
+	Location rof13(opRegOf, new Const(13), NULL);
+	Assign a10, a20;
+	a10.setNumber(10);
+	a20.setNumber(20);
+	RefExp r12_10(rof12.clone(), &a10);
+	RefExp r12_20(rof12.clone(), &a20);
+	RefExp r13_10(rof13.clone(), &a10);
+	RefExp r13_20(rof13.clone(), &a20);
+
+	ConnectionGraph cg;
+	cg.connect(&r13_10, &r12_10);
+	cg.connect(&r12_10, &r12_20);
+	cg.connect(r12_20.clone(), r12_10.clone());  // Already there
+	CPPUNIT_ASSERT( cg.isConnected(&r12_20, &r12_10));
+	CPPUNIT_ASSERT( cg.isConnected(r13_10.clone(), &r12_10));
+	CPPUNIT_ASSERT(!cg.isConnected(&r13_10, &r12_20));
+	CPPUNIT_ASSERT(!cg.isConnected(&r13_20, &r12_20));
+	CPPUNIT_ASSERT_EQUAL(2, cg.count(&r12_10));
+	CPPUNIT_ASSERT_EQUAL(0, cg.count(&r13_20));
+
+	// In lessExpStar order of the first location, then in the order connected
+	std::ostringstream ost;
+	ConnectionGraph::iterator cc;
+	for (cc = cg.begin(); cc != cg.end(); ++cc)
+		ost << cc->first << "-" << cc->second << " ";
+	std::string expected("r12{10}-r13{10} r12{10}-r12{20} r12{20}-r12{10} r13{10}-r12{10} ");
+	CPPUNIT_ASSERT_EQUAL(expected, ost.str());
+
+	// r12{10} <-> r12{20} becomes r12{10} <-> r13{20}
+	cg.update(&r12_10, &r12_20, &r13_20);
+	CPPUNIT_ASSERT( cg.isConnected(&r12_10, &r13_20));
+	CPPUNIT_ASSERT( cg.isConnected(&r13_20, &r12_10));
+	CPPUNIT_ASSERT_EQUAL(0, cg.count(&r12_20));
+	// Removing a connection removes both directions
+	for (cc = cg.begin(); cc != cg.end(); ) {
+		if (*cc->second == r13_10)
+			cc = cg.remove(cc);
+		else
+			++cc;
+	}
+	CPPUNIT_ASSERT(!cg.isConnected(&r13_10, &r12_10));
+	CPPUNIT_ASSERT_EQUAL(1, cg.count(&r12_10));
+
+	// The versions of a location are numbered consecutively, so a different live version is quick to find
+	LiveNumbering ln;
+	ln.add(&r13_10);
+	ln.add(&r12_20);
+	ln.add(&r13_20);
+	ln.add(&r12_10);
+	ln.finish();
+	CPPUNIT_ASSERT(*ln.getLoc(0) == r12_10);
+	CPPUNIT_ASSERT(*ln.getLoc(3) == r13_20);
+	BitSet live;
+	live.set(0);  // r12{10}
+	live.set(3);  // r13{20}
+	CPPUNIT_ASSERT_EQUAL(-1, ln.differentVersion(0, live));
+	CPPUNIT_ASSERT_EQUAL(0, ln.differentVersion(1, live));
+	CPPUNIT_ASSERT_EQUAL(3, ln.differentVersion(2, live));
+	live.set(1);  // r12{20}
+	CPPUNIT_ASSERT_EQUAL(1, ln.differentVersion(0, live));
+}
+
 /*==============================================================================
  * FUNCTION:        StatementTest::testRecursion
  * OVERVIEW:        Test push of argument (X86 style), then call self
@@ -13,6 +13,7 @@ class StatementTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE(StatementTest);
 	CPPUNIT_TEST(testLocationSet);
 	CPPUNIT_TEST(testWildLocationSet);
+	CPPUNIT_TEST(testConnectionGraph);
 	CPPUNIT_TEST(testEmpty);
 	CPPUNIT_TEST(testFlow);
 	CPPUNIT_TEST(testKill);
@@ -53,6 +54,7 @@ public:
 	void testEndlessLoop();
 	void testLocationSet();
 	void testWildLocationSet();
+	void testConnectionGraph();
 	void testRecursion();
 	void testExpand();
 	void testClone();
@@ -1706,102 +1706,67 @@ void BasicBlock::prependStmt(Statement *s, UserProc *proc)
 
 ////////////////////////////////////////////////////
 
-// Check for overlap of liveness between the currently live locations (liveLocs) and the set of locations in ls
-// Also check for type conflicts if DFA_TYPE_ANALYSIS
+// Check for overlap of liveness between the currently live locations (liveLocs) and the locations numbered in ls
 // This is a helper function that is not directly declated in the BasicBlock class
-void checkForOverlap(LocationSet &liveLocs, LocationSet &ls, ConnectionGraph &ig, UserProc *proc)
+void checkForOverlap(BitSet &liveLocs, std::vector<int> &ls, ConnectionGraph &ig, LiveNumbering &ln)
 {
 	// For each location to be considered
-	LocationSet::iterator uu;
+	std::vector<int>::iterator uu;
 	for (uu = ls.begin(); uu != ls.end(); uu++) {
-		Exp *u = (Exp *)*uu;
-		if (!u->isSubscript()) continue;  // Only interested in subscripted vars
-		RefExp *r = (RefExp *)u;
+		int u = *uu;
 		// Interference if we can find a live variable which differs only in the reference
-		Exp *dr;
-		if (liveLocs.findDifferentRef(r, dr)) {
-			// We have an interference between r and dr. Record it
-			ig.connect(r, dr);
+		int dr = ln.differentVersion(u, liveLocs);
+		if (dr != -1) {
+			// We have an interference between u and dr. Record it
+			ig.connect(ln.graphNode(u, ig), ln.graphNode(dr, ig));
 			if (VERBOSE || DEBUG_LIVENESS)
-				LOG << "interference of " << dr << " with " << r << "\n";
+				LOG << "interference of " << ln.getLoc(dr) << " with " << ln.getLoc(u) << "\n";
 		}
-		// Add the uses one at a time. Note: don't use makeUnion, because then we don't discover interferences
+		// Add the uses one at a time. Note: don't add them all at once, because then we don't discover interferences
 		// from the same statement, e.g.  blah := r24{2} + r24{3}
-		liveLocs.insert(u);
+		liveLocs.set(u);
 	}
 }
 
-bool BasicBlock::calcLiveness(ConnectionGraph &ig, UserProc *myProc)
+// Number the locations defined and used in this BB, for calcLiveness(). Only subscripted locations take part in the
+// interferences, so the others are left out
+void BasicBlock::numberLiveness(LiveNumbering &ln)
 {
-	// Start with the liveness at the bottom of the BB
-	LocationSet liveLocs, phiLocs;
-	getLiveOut(liveLocs, phiLocs);
-	// Do the livensses that result from phi statements at successors first.
-	// FIXME: document why this is necessary
-	checkForOverlap(liveLocs, phiLocs, ig, myProc);
-	// For each RTL in this BB
+	LiveNumbering::Block &blk = ln.blocks[this];
 	std::list<RTL *>::reverse_iterator rit;
 	if (m_pRtls)  // this can be NULL
 		for (rit = m_pRtls->rbegin(); rit != m_pRtls->rend(); rit++) {
 			std::list<Statement *> &stmts = (*rit)->getList();
 			std::list<Statement *>::reverse_iterator sit;
-			// For each statement this RTL
 			for (sit = stmts.rbegin(); sit != stmts.rend(); sit++) {
 				Statement *s = *sit;
+				blk.stmts.push_back(LiveNumbering::Stmt());
+				LiveNumbering::Stmt &ls = blk.stmts.back();
+				ls.s = s;
 				LocationSet defs;
 				s->getDefinitions(defs);
 				// The definitions don't have refs yet
 				defs.addSubscript(s /* , myProc->getCFG() */);
-#if 0
-				// I used to think it necessary to consider definitions as a special case. However, I now believe that
-				// this was either an error of implementation (e.g. it didn't seem to correctly consider the livenesses
-				// causesd by phis) or something to do with renaming but not propagating certain memory locations.
-				// The idea is now to clearly divide locations into those that can be renamed and propagated, and those
-				// which are not renamed or propagated. (Check this.)
-
-				// Also consider it an interference if we define a location that is the same base variable. This can happen
-				// when there is a definition that is unused but for whatever reason not eliminated
-				// This check is done at the "bottom" of the statement, i.e. before we add s's uses and remove s's
-				// definitions to liveLocs
-				// Note that phi assignments don't count
-				if (!s->isPhi())
-					checkForOverlap(liveLocs, defs, ig, myProc, false);
-#endif
-				// Definitions kill uses. Now we are moving to the "top" of statement s
-				liveLocs.makeDiff(defs);
+				LocationSet::iterator ll;
+				for (ll = defs.begin(); ll != defs.end(); ll++)
+					if ((*ll)->isSubscript())
+						ls.defs.push_back(ln.add(*ll));
 				// Phi functions are a special case. The operands of phi functions are uses, but they don't interfere
 				// with each other (since they come via different BBs). However, we don't want to put these uses into
 				// liveLocs, because then the livenesses will flow to all predecessors. Only the appropriate livenesses
 				// from the appropriate phi parameter should flow to the predecessor. This is done in getLiveOut()
 				if (s->isPhi()) continue;
-				// Check for livenesses that overlap
 				LocationSet uses;
 				s->addUsedLocs(uses);
-				checkForOverlap(liveLocs, uses, ig, myProc);
-				if (DEBUG_LIVENESS)
-					LOG << " ## liveness: at top of " << s << ", liveLocs is " << liveLocs.prints() << "\n";
+				for (ll = uses.begin(); ll != uses.end(); ll++)
+					if ((*ll)->isSubscript())
+						ls.uses.push_back(ln.add(*ll));
 			}
 		}
-	// liveIn is what we calculated last time
-	if (!(liveLocs == liveIn)) {
-		liveIn = liveLocs;
-		return true;  // A change
-	} else
-		// No change
-		return false;
-}
 
-// Locations that are live at the end of this BB are the union of the locations that are live at the start of its
-// successors
-// liveout gets all the livenesses, and phiLocs gets a subset of these, which are due to phi statements at the top of
-// successors
-void BasicBlock::getLiveOut(LocationSet &liveout, LocationSet &phiLocs)
-{
-	liveout.clear();
+	// The phi operands at the tops of the successors that come from this BB
 	for (unsigned i = 0; i < m_OutEdges.size(); i++) {
 		PBB currBB = m_OutEdges[i];
-		// First add the non-phi liveness
-		liveout.makeUnion(currBB->liveIn);
 		int j = currBB->whichPred(this);
 		// The first RTL will have the phi functions, if any
 		if (currBB->m_pRtls == NULL || currBB->m_pRtls->size() == 0)
@@ -1817,12 +1782,56 @@ void BasicBlock::getLiveOut(LocationSet &liveout, LocationSet &phiLocs)
 			// Get the jth operand to the phi function; it has a use from BB *this
 			Statement *def = pa->getStmtAt(j);
 			RefExp *r = new RefExp(pa->getLeft()->clone(), def);
-			liveout.insert(r);
-			phiLocs.insert(r);
+			blk.phiLocs.push_back(ln.add(r));
 			if (DEBUG_LIVENESS)
-				LOG << " ## Liveness: adding " << r << " due to ref to phi " << *it << " in BB at " << getLowAddr() << "\n";
+				LOG << " ## Liveness: " << r << " is live out due to ref to phi " << *it << " in BB at "
+				    << getLowAddr() << "\n";
+		}
+	}
+}
+
+bool BasicBlock::calcLiveness(ConnectionGraph &ig, LiveNumbering &ln)
+{
+	LiveNumbering::Block &blk = ln.blocks[this];
+	// Start with the liveness at the bottom of the BB
+	BitSet liveLocs;
+	getLiveOut(liveLocs, ln);
+	// Do the livensses that result from phi statements at successors first.
+	// FIXME: document why this is necessary
+	checkForOverlap(liveLocs, blk.phiLocs, ig, ln);
+	// For each statement, last first
+	std::vector<LiveNumbering::Stmt>::iterator sit;
+	for (sit = blk.stmts.begin(); sit != blk.stmts.end(); sit++) {
+		// Definitions kill uses. Now we are moving to the "top" of statement s
+		for (unsigned i = 0; i < sit->defs.size(); i++)
+			liveLocs.reset(sit->defs[i]);
+		// Check for livenesses that overlap. Phis have no uses here; see numberLiveness()
+		checkForOverlap(liveLocs, sit->uses, ig, ln);
+		if (DEBUG_LIVENESS) {
+			LocationSet ls;
+			ln.toLocationSet(liveLocs, ls);
+			LOG << " ## liveness: at top of " << sit->s << ", liveLocs is " << ls.prints() << "\n";
 		}
 	}
+	// liveIn is what we calculated last time
+	if (!(liveLocs == blk.liveIn)) {
+		blk.liveIn.swap(liveLocs);
+		return true;  // A change
+	} else
+		// No change
+		return false;
+}
+
+// Locations that are live at the end of this BB are the union of the locations that are live at the start of its
+// successors, and the phi operands at the successors that come from this BB
+void BasicBlock::getLiveOut(BitSet &liveout, LiveNumbering &ln)
+{
+	liveout.clear();
+	for (unsigned i = 0; i < m_OutEdges.size(); i++)
+		liveout |= ln.blocks[m_OutEdges[i]].liveIn;
+	std::vector<int> &phiLocs = ln.blocks[this].phiLocs;
+	for (unsigned i = 0; i < phiLocs.size(); i++)
+		liveout.set(phiLocs[i]);
 }
 
 // Basically the "whichPred" function as per Briggs, Cooper, et al (and presumably "Cryton, Ferante, Rosen, Wegman, and
@@ -1732,6 +1732,13 @@ void Cfg::findInterferences(ConnectionGraph &cg)
 {
 	if (m_listBB.size() == 0) return;
 
+	// Number the locations, so that the iteration below works on bit sets
+	LiveNumbering ln;
+	std::list<PBB>::iterator it;
+	for (it = m_listBB.begin(); it != m_listBB.end(); it++)
+		(*it)->numberLiveness(ln);
+	ln.finish();
+
 	std::list<PBB> workList;  // List of BBs still to be processed
 	// Set of the same; used for quick membership test
 	std::set<PBB> workSet;
@@ -1749,7 +1756,7 @@ void Cfg::findInterferences(ConnectionGraph &cg)
 		workList.erase(--workList.end());
 		workSet.erase(currBB);
 		// Calculate live locations and interferences
-		change = currBB->calcLiveness(cg, myProc);
+		change = currBB->calcLiveness(cg, ln);
 		if (change) {
 			if (DEBUG_LIVENESS) {
 				LOG << "Revisiting BB ending with stmt ";
@@ -1768,6 +1775,9 @@ void Cfg::findInterferences(ConnectionGraph &cg)
 			updateWorkListRev(currBB, workList, workSet);
 		}
 	}
+	// Keep the livenesses as locations, e.g. for saving
+	for (it = m_listBB.begin(); it != m_listBB.end(); it++)
+		ln.toLocationSet(ln.blocks[*it].liveIn, (*it)->liveIn);
 }
 
 void Cfg::appendBBs(std::list<PBB> &worklist, std::set<PBB> &workset)
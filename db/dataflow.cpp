@@ -19,12 +19,167 @@
 #include "log.h"
 #include "frontend.h"
 
+#include <algorithm>  // For std::sort
 #include <sstream>
 
 #include <cstring>
 
 extern char debug_buffer[];  // For prints functions
 
+// Free the storage of a container (clear() alone keeps the capacity of vectors)
+template <class T>
+static void freeStorage(T &c)
+{
+	T().swap(c);
+}
+
+
+bool BitSet::empty() const
+{
+	for (std::vector<Word>::const_iterator it = words.begin(); it != words.end(); ++it)
+		if (*it) return false;
+	return true;
+}
+
+int BitSet::count() const
+{
+	int n = 0;
+	for (std::vector<Word>::const_iterator it = words.begin(); it != words.end(); ++it)
+		for (Word w = *it; w; w &= w - 1)  // Clear the lowest set bit
+			n++;
+	return n;
+}
+
+int BitSet::next(int i) const
+{
+	int nw = words.size();
+	int w = i / BITS;
+	if (w >= nw) return -1;
+	Word cur = words[w] >> (i % BITS);
+	if (cur == 0) {
+		// Skip whole words of zeroes
+		do {
+			if (++w >= nw) return -1;
+		} while (words[w] == 0);
+		cur = words[w];
+		i = w * BITS;
+	}
+	while ((cur & 1) == 0) {
+		cur >>= 1;
+		i++;
+	}
+	return i;
+}
+
+BitSet &BitSet::operator|=(const BitSet &o)
+{
+	if (words.size() < o.words.size())
+		words.resize(o.words.size(), 0);
+	for (unsigned i = 0; i < o.words.size(); i++)
+		words[i] |= o.words[i];
+	return *this;
+}
+
+bool BitSet::operator==(const BitSet &o) const
+{
+	// Trailing zero words don't count
+	const std::vector<Word> &shorter = words.size() < o.words.size() ? words : o.words;
+	const std::vector<Word> &longer  = words.size() < o.words.size() ? o.words : words;
+	for (unsigned i = 0; i < longer.size(); i++)
+		if (longer[i] != (i < shorter.size() ? shorter[i] : 0))
+			return false;
+	return true;
+}
+
+std::set<int> BitSet::toSet() const
+{
+	std::set<int> ret;
+	for (int i = first(); i != -1; i = next(i + 1))
+		ret.insert(i);
+	return ret;
+}
+
+int LiveNumbering::add(Exp *e)
+{
+	std::map<Exp *, int, lessExpStar>::iterator ff = nums.find(e);
+	if (ff != nums.end())
+		return ff->second;
+	int n = locs.size();
+	nums[e] = n;
+	locs.push_back(e);
+	return n;
+}
+
+void LiveNumbering::finish()
+{
+	// The map is in lessExpStar order; number in that order
+	int n = locs.size();
+	std::vector<int> renum(n);
+	std::map<Exp *, int, lessExpStar>::iterator nn;
+	int i = 0;
+	for (nn = nums.begin(); nn != nums.end(); ++nn, ++i) {
+		renum[nn->second] = i;
+		nn->second = i;
+		locs[i] = nn->first;
+	}
+	std::map<PBB, Block>::iterator bb;
+	for (bb = blocks.begin(); bb != blocks.end(); ++bb) {
+		std::vector<Stmt>::iterator ss;
+		for (ss = bb->second.stmts.begin(); ss != bb->second.stmts.end(); ++ss) {
+			for (unsigned j = 0; j < ss->defs.size(); j++)
+				ss->defs[j] = renum[ss->defs[j]];
+			for (unsigned j = 0; j < ss->uses.size(); j++)
+				ss->uses[j] = renum[ss->uses[j]];
+			std::sort(ss->uses.begin(), ss->uses.end());
+		}
+		std::vector<int> &phiLocs = bb->second.phiLocs;
+		for (unsigned j = 0; j < phiLocs.size(); j++)
+			phiLocs[j] = renum[phiLocs[j]];
+		std::sort(phiLocs.begin(), phiLocs.end());
+		phiLocs.erase(std::unique(phiLocs.begin(), phiLocs.end()), phiLocs.end());
+	}
+	// RefExps are ordered by their base location first, so each base has a range of numbers
+	firstVersion.resize(n);
+	endVersion.resize(n);
+	for (i = 0; i < n; i++) {
+		if (i > 0 && *locs[i - 1]->getSubExp1() == *locs[i]->getSubExp1())
+			firstVersion[i] = firstVersion[i - 1];
+		else
+			firstVersion[i] = i;
+	}
+	for (i = n - 1; i >= 0; i--) {
+		if (i + 1 < n && firstVersion[i + 1] == firstVersion[i])
+			endVersion[i] = endVersion[i + 1];
+		else
+			endVersion[i] = i + 1;
+	}
+	graphNodes.assign(n, -1);
+}
+
+int LiveNumbering::differentVersion(int n, const BitSet &live) const
+{
+	int m = live.next(firstVersion[n]);
+	if (m == n)
+		m = live.next(n + 1);
+	if (m == -1 || m >= endVersion[n])
+		return -1;
+	return m;
+}
+
+int LiveNumbering::graphNode(int n, ConnectionGraph &ig)
+{
+	if (graphNodes[n] == -1)
+		graphNodes[n] = ig.node(locs[n]);
+	return graphNodes[n];
+}
+
+void LiveNumbering::toLocationSet(const BitSet &bs, LocationSet &ls)
+{
+	ls.clear();
+	for (int i = bs.first(); i != -1; i = bs.next(i + 1))
+		ls.insert(locs[i]);
+}
+
 
 /*
  * Dominator frontier code largely as per Appel 2002 ("Modern Compiler Implementation in Java")
@@ -100,10 +255,10 @@ void DataFlow::dominators(Cfg *cfg)
 		}
 		semi[n] = s;
 		/* Calculation of n's dominator is deferred until the path from s to n has been linked into the forest */
-		bucket[s].insert(n);
+		bucket[s].push_back(n);  // Each n is in exactly one bucket
 		Link(p, n);
 		// for each v in bucket[p]
-		std::set<int>::iterator jj;
+		std::vector<int>::iterator jj;
 		for (jj = bucket[p].begin(); jj != bucket[p].end(); jj++) {
 			int v = *jj;
 			/* Now that the path from p to v has been linked into the spanning forest, these lines calculate the
@@ -124,7 +279,14 @@ void DataFlow::dominators(Cfg *cfg)
 			idom[n] = idom[samedom[n]];  // Deferred success!
 		}
 	}
-	computeDF(0);  // Finally, compute the dominance frontiers
+	// Finally, compute the dominance frontiers. First find the children of each node in the dominator tree
+	domChildren.clear();
+	domChildren.resize(numBB);
+	for (unsigned c = 0; c < numBB; c++)
+		if (idom[c] != -1)
+			domChildren[idom[c]].push_back(c);
+	computeDF(0);
+	freeStorage(domChildren);
 }
 
 // Basically algorithm 19.10b of Appel 2002 (uses path compression for O(log N) amortised time per operation
@@ -159,7 +321,9 @@ bool DataFlow::doesDominate(int n, int w)
 
 void DataFlow::computeDF(int n)
 {
-	std::set<int> S;
+	BitSet &S = DF[n];
+	S.clear();
+	S.resize(BBs.size());
 	/* THis loop computes DF_local[n] */
 	// for each node y in succ(n)
 	PBB bb = BBs[n];
@@ -168,27 +332,23 @@ void DataFlow::computeDF(int n)
 	for (it = outEdges.begin(); it != outEdges.end(); it++) {
 		int y = indices[*it];
 		if (idom[y] != n)
-			S.insert(y);
+			S.set(y);
 	}
 	// for each child c of n in the dominator tree
-	// Note: this is a linear search!
-	int sz = idom.size();  // ? Was ancestor.size()
-	for (int c = 0; c < sz; ++c) {
-		if (idom[c] != n) continue;
+	std::vector<int> &children = domChildren[n];
+	for (unsigned i = 0; i < children.size(); i++) {
+		int c = children[i];
 		computeDF(c);
 		/* This loop computes DF_up[c] */
 		// for each element w of DF[c]
-		std::set<int> &s = DF[c];
-		std::set<int>::iterator ww;
-		for (ww = s.begin(); ww != s.end(); ww++) {
-			int w = *ww;
-			// if n does not dominate w, or if n = w
-			if (n == w || !doesDominate(n, w)) {
-				S.insert(w);
-			}
+		BitSet &s = DF[c];
+		for (int w = s.first(); w != -1; w = s.next(w + 1)) {
+			// if n does not strictly dominate w. Since c is a child of n and w is in DF[c], this is so unless n is the
+			// immediate dominator of w (Cytron et al), which saves walking up the dominator tree
+			if (idom[w] != n)
+				S.set(w);
 		}
 	}
-	DF[n] = S;
 }
 
 
@@ -216,22 +376,65 @@ bool DataFlow::canRename(Exp *e, UserProc *proc)
 // For debugging
 void DataFlow::dumpA_phi()
 {
-	std::map<Exp *, std::set<int>, lessExpStar>::iterator zz;
+	std::map<Exp *, BitSet, lessExpStar>::iterator zz;
 	std::cerr << "A_phi:\n";
 	for (zz = A_phi.begin(); zz != A_phi.end(); ++zz) {
 		std::cerr << zz->first << " -> ";
-		std::set<int> &si = zz->second;
-		std::set<int>::iterator qq;
-		for (qq = si.begin(); qq != si.end(); ++qq)
-			std::cerr << *qq << ", ";
+		BitSet &si = zz->second;
+		for (int q = si.first(); q != -1; q = si.next(q + 1))
+			std::cerr << q << ", ";
 		std::cerr << "\n";
 	}
 	std::cerr << "end A_phi\n";
 }
 
+// Called when a proc reaches PROC_FINAL: it will not have its dominators recomputed or phi functions placed again,
+// but still needs idom, DF, A_orig etc for renaming, converting implicits and leaving SSA form
+void DataFlow::releaseWorkingSets()
+{
+	freeStorage(dfnum);
+	freeStorage(semi);
+	freeStorage(ancestor);
+	freeStorage(samedom);
+	freeStorage(vertex);
+	freeStorage(parent);
+	freeStorage(best);
+	freeStorage(bucket);
+	freeStorage(defallsites);
+	freeStorage(defStmts);
+	freeStorage(domChildren);
+	keys.clear();  // Keys already handed out stay valid, and go with the tables that hold them
+}
+
+// Called after transforming out of SSA form, so that the garbage collector can reclaim the locations and statements
+// that these tables still refer to
+void DataFlow::releaseAll()
+{
+	releaseWorkingSets();
+	freeStorage(BBs);
+	freeStorage(indices);
+	freeStorage(idom);
+	freeStorage(DF);
+	freeStorage(locs);
+	freeStorage(locNums);
+	freeStorage(A_orig);
+	freeStorage(defsites);
+	freeStorage(A_phi);
+	freeStorage(Stacks);
+}
+
+// Copy a location for use as a key of locNums, A_phi or Stacks. These keys are never modified, so with -ie they can be
+// shared (interned) nodes, and equal keys across blocks and passes of this proc cost one expression
+Exp *DataFlow::keyCopy(Exp *e)
+{
+	if (Boomerang::get()->internExps && ExpFactory::canIntern(e))
+		return keys.intern(e);
+	return e->clone();
+}
 
 bool DataFlow::placePhiFunctions(UserProc *proc)
 {
+	PhaseAlert phase(proc, "placePhiFunctions");
 	// First free some memory no longer needed
 	dfnum.resize(0);
 	semi.resize(0);
@@ -241,10 +444,12 @@ bool DataFlow::placePhiFunctions(UserProc *proc)
 	parent.resize(0);
 	best.resize(0);
 	bucket.resize(0);
-	defsites.clear();   // Clear defsites map,
+	defsites.clear();   // Clear defsites,
 	defallsites.clear();
 	A_orig.clear();     // and A_orig,
 	defStmts.clear();   // and the map from variable to defining Stmt
+	locs.clear();       // and the location numbering
+	locNums.clear();
 
 	bool change = false;
 
@@ -253,10 +458,12 @@ bool DataFlow::placePhiFunctions(UserProc *proc)
 	Cfg *cfg = proc->getCFG();
 	assert(numBB == cfg->getNumBBs());
 	A_orig.resize(numBB);
+	defallsites.resize(numBB);
 
-	// We need to create A_orig[n] for all n, the array of sets of locations defined at BB n
-	// Recreate each call because propagation and other changes make old data invalid
+	// Find the locations that can be renamed, and where they are defined. Recreate each call because propagation and
+	// other changes make old data invalid
 	unsigned n;
+	std::vector<std::vector<Exp *> > defined(numBB);
 	for (n = 0; n < numBB; n++) {
 		BasicBlock::rtlit rit; StatementList::iterator sit;
 		PBB bb = BBs[n];
@@ -265,64 +472,80 @@ bool DataFlow::placePhiFunctions(UserProc *proc)
 			LocationSet::iterator it;
 			s->getDefinitions(ls);
 			if (s->isCall() && ((CallStatement *)s)->isChildless())  // If this is a childless call
-				defallsites.insert(n);  // then this block defines every variable
+				defallsites.set(n);  // then this block defines every variable
 			for (it = ls.begin(); it != ls.end(); it++) {
 				if (canRename(*it, proc)) {
-					A_orig[n].insert((*it)->clone());
+					defined[n].push_back(*it);
+					if (locNums.find(*it) == locNums.end())
+						locNums[keyCopy(*it)] = -1;  // Numbered below
 					defStmts[*it] = s;
 				}
 			}
 		}
 	}
 
-	// For each node n
+	// Number the locations in lessExpStar order, so the phi-functions are inserted in the same order as before
+	std::map<Exp *, int, lessExpStar>::iterator ll;
+	for (ll = locNums.begin(); ll != locNums.end(); ll++) {
+		ll->second = locs.size();
+		locs.push_back(ll->first);
+	}
+	unsigned numLocs = locs.size();
+
+	// Now A_orig[n], the set of locations defined at BB n, and for each location a, defsites[a]
+	defsites.resize(numLocs, BitSet(numBB));
 	for (n = 0; n < numBB; n++) {
-		// For each variable a in A_orig[n]
-		std::set<Exp *, lessExpStar> &s = A_orig[n];
-		std::set<Exp *, lessExpStar>::iterator aa;
-		for (aa = s.begin(); aa != s.end(); aa++) {
-			Exp *a = *aa;
-			defsites[a].insert(n);
+		A_orig[n].resize(numLocs);
+		std::vector<Exp *>::iterator dd;
+		for (dd = defined[n].begin(); dd != defined[n].end(); dd++) {
+			int a = locNums[*dd];
+			A_orig[n].set(a);
+			defsites[a].set(n);
 		}
 	}
 
 	// For each variable a (in defsites, i.e. defined anywhere)
-	std::map<Exp *, std::set<int>, lessExpStar>::iterator mm;
-	for (mm = defsites.begin(); mm != defsites.end(); mm++) {
-		Exp *a = (*mm).first;  // *mm is pair<Exp *, set<int>>
+	std::vector<int> W;                 // The worklist
+	BitSet everInW(numBB);              // Blocks which have been in W while processing a
+	for (unsigned v = 0; v < numLocs; v++) {
+		Exp *a = locs[v];
+		BitSet &phis = A_phi[a];
+		phis.resize(numBB);
 
 		// Special processing for define-alls
-		// for each n in defallsites
-		std::set<int>::iterator da;
-		for (da = defallsites.begin(); da != defallsites.end(); ++da)
-			defsites[a].insert(*da);
+		defsites[v] |= defallsites;
 
 		// W <- defsites[a];
-		std::set<int> W = defsites[a];  // set copy
+		W.clear();
+		everInW.clear();
+		everInW.resize(numBB);
+		BitSet &ds = defsites[v];
+		for (int d = ds.first(); d != -1; d = ds.next(d + 1)) {
+			W.push_back(d);
+			everInW.set(d);
+		}
 		// While W not empty
-		while (W.size()) {
+		while (!W.empty()) {
 			// Remove some node n from W
-			int n = *W.begin();  // Copy first element
-			W.erase(W.begin());  // Remove first element
+			int n = W.back();
+			W.pop_back();
 			// for each y in DF[n]
-			std::set<int>::iterator yy;
-			std::set<int> &DFn = DF[n];
-			for (yy = DFn.begin(); yy != DFn.end(); yy++) {
-				int y = *yy;
+			BitSet &DFn = DF[n];
+			for (int y = DFn.first(); y != -1; y = DFn.next(y + 1)) {
 				// if y not element of A_phi[a]
-				std::set<int> &s = A_phi[a];
-				if (s.find(y) == s.end()) {
+				if (!phis.test(y)) {
 					// Insert trivial phi function for a at top of block y: a := phi()
 					change = true;
 					Statement *as = new PhiAssign(a->clone());
 					PBB Ybb = BBs[y];
 					Ybb->prependStmt(as, proc);
 					// A_phi[a] <- A_phi[a] U {y}
-					s.insert(y);
+					phis.set(y);
 					// if a !elementof A_orig[y]
-					if (A_orig[y].find(a) == A_orig[y].end()) {
+					if (!A_orig[y].test(v) && !everInW.test(y)) {
 						// W <- W U {y}
-						W.insert(y);
+						W.push_back(y);
+						everInW.set(y);
 					}
 				}
 			}
@@ -344,6 +567,80 @@ static Exp *defineAll = new Terminal(opDefineAll);  // An expression representin
 // stack
 #define STACKS_EMPTY(q) (Stacks.find(q) == Stacks.end() || Stacks[q].empty())
 
+// Subscript the uses in statement S with the definitions on top of the Stacks. Return true if any change
+bool DataFlow::renameUses(UserProc *proc, Statement *S)
+{
+	bool changed = false;
+	LocationSet locs;
+	if (S->isPhi()) {
+		PhiAssign *pa = (PhiAssign *)S;
+		Exp *phiLeft = pa->getLeft();
+		if (phiLeft->isMemOf() || phiLeft->isRegOf())
+			phiLeft->getSubExp1()->addUsedLocs(locs);
+		// A phi statement may use a location defined in a childless call, in which case its use collector
+		// needs updating
+		PhiAssign::iterator pp;
+		for (pp = pa->begin(); pp != pa->end(); ++pp) {
+			Statement *def = pp->def;
+			if (def && def->isCall())
+				((CallStatement *)def)->useBeforeDefine(phiLeft->clone());
+		}
+	} else {  // Not a phi assignment
+		S->addUsedLocs(locs);
+	}
+	LocationSet::iterator xx;
+	for (xx = locs.begin(); xx != locs.end(); xx++) {
+		Exp *x = *xx;
+		// Don't rename memOfs that are not renamable according to the current policy
+		if (!canRename(x, proc)) continue;
+		Statement *def = NULL;
+		if (x->isSubscript()) {  // Already subscripted?
+			// No renaming required, but redo the usage analysis, in case this is a new return, and also because
+			// we may have just removed all call livenesses
+			// Update use information in calls, and in the proc (for parameters)
+			Exp *base = ((RefExp *)x)->getSubExp1();
+			def = ((RefExp *)x)->getDef();
+			if (def && def->isCall()) {
+				// Calls have UseCollectors for locations that are used before definition at the call
+				((CallStatement *)def)->useBeforeDefine(base->clone());
+				continue;
+			}
+			// Update use collector in the proc (for parameters)
+			if (def == NULL)
+				proc->useBeforeDefine(base->clone());
+			continue;  // Don't re-rename the renamed variable
+		}
+		// Else x is not subscripted yet
+		if (STACKS_EMPTY(x)) {
+			if (!Stacks[defineAll].empty())
+				def = Stacks[defineAll].top();
+			else {
+				// If the both stacks are empty, use a NULL definition. This will be changed into a pointer
+				// to an implicit definition at the start of type analysis, but not until all the m[...]
+				// have stopped changing their expressions (complicates implicit assignments considerably).
+				def = NULL;
+				// Update the collector at the start of the UserProc
+				proc->useBeforeDefine(x->clone());
+			}
+		} else
+			def = Stacks[x].top();
+		if (def && def->isCall())
+			// Calls have UseCollectors for locations that are used before definition at the call
+			((CallStatement *)def)->useBeforeDefine(x->clone());
+		// Replace the use of x with x{def} in S
+		changed = true;
+		if (S->isPhi()) {
+			Exp *phiLeft = ((PhiAssign *)S)->getLeft();
+			phiLeft->setSubExp1(phiLeft->getSubExp1()->expSubscriptVar(x, def /*, this*/));
+		} else {
+			S->subscriptVar(x, def /*, this */);
+		}
+	}
+	if (changed)
+		proc->getDefUses().markDirty(S);
+	return changed;
+}
+
 // Subscript dataflow variables
 static int progress = 0;
 bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = false */)
@@ -363,75 +660,8 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
 	PBB bb = BBs[n];
 	Statement *S;
 	for (S = bb->getFirstStmt(rit, sit); S; S = bb->getNextStmt(rit, sit)) {
-		// if S is not a phi function (per Appel)
-		/* if (!S->isPhi()) */ {
-			// For each use of some variable x in S (not just assignments)
-			LocationSet locs;
-			if (S->isPhi()) {
-				PhiAssign *pa = (PhiAssign *)S;
-				Exp *phiLeft = pa->getLeft();
-				if (phiLeft->isMemOf() || phiLeft->isRegOf())
-					phiLeft->getSubExp1()->addUsedLocs(locs);
-				// A phi statement may use a location defined in a childless call, in which case its use collector
-				// needs updating
-				PhiAssign::iterator pp;
-				for (pp = pa->begin(); pp != pa->end(); ++pp) {
-					Statement *def = pp->def;
-					if (def && def->isCall())
-						((CallStatement *)def)->useBeforeDefine(phiLeft->clone());
-				}
-			} else {  // Not a phi assignment
-				S->addUsedLocs(locs);
-			}
-			LocationSet::iterator xx;
-			for (xx = locs.begin(); xx != locs.end(); xx++) {
-				Exp *x = *xx;
-				// Don't rename memOfs that are not renamable according to the current policy
-				if (!canRename(x, proc)) continue;
-				Statement *def = NULL;
-				if (x->isSubscript()) {  // Already subscripted?
-					// No renaming required, but redo the usage analysis, in case this is a new return, and also because
-					// we may have just removed all call livenesses
-					// Update use information in calls, and in the proc (for parameters)
-					Exp *base = ((RefExp *)x)->getSubExp1();
-					def = ((RefExp *)x)->getDef();
-					if (def && def->isCall()) {
-						// Calls have UseCollectors for locations that are used before definition at the call
-						((CallStatement *)def)->useBeforeDefine(base->clone());
-						continue;
-					}
-					// Update use collector in the proc (for parameters)
-					if (def == NULL)
-						proc->useBeforeDefine(base->clone());
-					continue;  // Don't re-rename the renamed variable
-				}
-				// Else x is not subscripted yet
-				if (STACKS_EMPTY(x)) {
-					if (!Stacks[defineAll].empty())
-						def = Stacks[defineAll].top();
-					else {
-						// If the both stacks are empty, use a NULL definition. This will be changed into a pointer
-						// to an implicit definition at the start of type analysis, but not until all the m[...]
-						// have stopped changing their expressions (complicates implicit assignments considerably).
-						def = NULL;
-						// Update the collector at the start of the UserProc
-						proc->useBeforeDefine(x->clone());
-					}
-				} else
-					def = Stacks[x].top();
-				if (def && def->isCall())
-					// Calls have UseCollectors for locations that are used before definition at the call
-					((CallStatement *)def)->useBeforeDefine(x->clone());
-				// Replace the use of x with x{def} in S
-				changed = true;
-				if (S->isPhi()) {
-					Exp *phiLeft = ((PhiAssign *)S)->getLeft();
-					phiLeft->setSubExp1(phiLeft->getSubExp1()->expSubscriptVar(x, def /*, this*/));
-				} else {
-					S->subscriptVar(x, def /*, this */);
-				}
-			}
-		}
+		// For each use of some variable x in S (not just assignments), per Appel even if S is a phi function
+		changed |= renameUses(proc, S);
 
 		// MVE: Check for Call and Return Statements; these have DefCollector objects that need to be updated
 		// Do before the below, so CallStatements have not yet processed their defines
@@ -457,7 +687,7 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
 				// Note: we clone a because otherwise it could be an expression that gets deleted through various
 				// modifications. This is necessary because we do several passes of this algorithm to sort out the
 				// memory expressions
-				Stacks[a->clone()].push(S);
+				Stacks[keyCopy(a)].push(S);
 				// Replace definition of a with definition of a_i in S (we don't do this)
 			}
 			// FIXME: MVE: do we need this awful hack?
@@ -467,7 +697,7 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
 				a = a1;
 				// Stacks already has a definition for a (as just the bare local)
 				if (suitable) {
-					Stacks[a->clone()].push(S);
+					Stacks[keyCopy(a)].push(S);
 				}
 			}
 		}
@@ -511,6 +741,7 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
 				def = Stacks[a].top();
 			// "Replace jth operand with a_i"
 			pa->putAt(j, def, a);
+			proc->getDefUses().markDirty(pa);
 		}
 	}
 
@@ -556,6 +787,118 @@ bool DataFlow::renameBlockVars(UserProc *proc, int n, bool clearStacks /* = fals
 	return changed;
 }
 
+// File the uses of statement s
+void DefUseIndex::file(Statement *s)
+{
+	LocationSet refs;
+	s->addUsedLocs(refs);  // Not the uses in collectors
+	std::vector<Statement *> &defs = defsUsed[s];
+	LocationSet::iterator rr;
+	for (rr = refs.begin(); rr != refs.end(); rr++) {
+		if (!(*rr)->isSubscript()) continue;
+		Statement *def = ((RefExp *)*rr)->getDef();
+		Use u;
+		u.user = s;
+		u.ref = (RefExp *)*rr;
+		uses[def].push_back(u);
+		if (std::find(defs.begin(), defs.end(), def) == defs.end())
+			defs.push_back(def);
+	}
+}
+
+// Remove the uses of statement s, as filed last time
+void DefUseIndex::unfile(Statement *s)
+{
+	std::map<Statement *, std::vector<Statement *> >::iterator ff = defsUsed.find(s);
+	if (ff == defsUsed.end())
+		return;
+	std::vector<Statement *>::iterator dd;
+	for (dd = ff->second.begin(); dd != ff->second.end(); ++dd) {
+		iterator uu = uses.find(*dd);
+		if (uu == uses.end())
+			continue;
+		UseList &l = uu->second;
+		unsigned j = 0;
+		for (unsigned i = 0; i < l.size(); i++)
+			if (l[i].user != s)
+				l[j++] = l[i];
+		l.resize(j);
+		if (l.empty())
+			uses.erase(uu);
+	}
+	defsUsed.erase(ff);
+}
+
+void DefUseIndex::invalidate()
+{
+	valid = false;
+	uses.clear();
+	defsUsed.clear();
+	dirty.clear();
+}
+
+void DefUseIndex::remove(Statement *s)
+{
+	if (!valid)
+		return;
+	unfile(s);
+	dirty.remove(s);
+}
+
+void DefUseIndex::refresh()
+{
+	if (!valid) {
+		StatementList stmts;
+		proc->getStatements(stmts);
+		StatementList::iterator it;
+		for (it = stmts.begin(); it != stmts.end(); it++)
+			file(*it);
+		valid = true;
+		return;
+	}
+	StatementSet::iterator it;
+	for (it = dirty.begin(); it != dirty.end(); it++) {
+		unfile(*it);
+		file(*it);
+	}
+	dirty.clear();
+}
+
+DefUseIndex::UseList &DefUseIndex::getUses(Statement *def)
+{
+	static UseList none;
+	refresh();
+	iterator uu = uses.find(def);
+	if (uu == uses.end())
+		return none;
+	return uu->second;
+}
+
+static bool lessNumber(Statement *a, Statement *b)
+{
+	return a->getNumber() < b->getNumber();
+}
+
+void DefUseIndex::getUsers(Statement *def, Exp *base, std::vector<Statement *> &users)
+{
+	UseList &l = getUses(def);
+	UseList::iterator uu;
+	for (uu = l.begin(); uu != l.end(); ++uu)
+		if (*uu->ref->getSubExp1() == *base && std::find(users.begin(), users.end(), uu->user) == users.end())
+			users.push_back(uu->user);
+	std::stable_sort(users.begin(), users.end(), lessNumber);
+}
+
+void DefUseIndex::getDefsUsedBy(Statement *s, std::vector<Statement *> &defs)
+{
+	refresh();
+	std::map<Statement *, std::vector<Statement *> >::iterator ff = defsUsed.find(s);
+	if (ff == defsUsed.end())
+		defs.clear();
+	else
+		defs = ff->second;
+}
+
 void DataFlow::dumpStacks()
 {
 	std::cerr << "Stacks: " << Stacks.size() << " entries\n";
@@ -572,13 +915,11 @@ void DataFlow::dumpStacks()
 
 void DataFlow::dumpDefsites()
 {
-	std::map<Exp *, std::set<int>, lessExpStar>::iterator dd;
-	for (dd = defsites.begin(); dd != defsites.end(); ++dd) {
-		std::cerr << dd->first;
-		std::set<int>::iterator ii;
-		std::set<int> &si = dd->second;
-		for (ii = si.begin(); ii != si.end(); ++ii)
-			std::cerr << " " << *ii;
+	for (unsigned v = 0; v < defsites.size(); ++v) {
+		std::cerr << locs[v];
+		BitSet &si = defsites[v];
+		for (int i = si.first(); i != -1; i = si.next(i + 1))
+			std::cerr << " " << i;
 		std::cerr << "\n";
 	}
 }
@@ -588,10 +929,9 @@ void DataFlow::dumpA_orig()
 	int n = A_orig.size();
 	for (int i = 0; i < n; ++i) {
 		std::cerr << i;
-		std::set<Exp *, lessExpStar>::iterator ee;
-		std::set<Exp *, lessExpStar> &se = A_orig[i];
-		for (ee = se.begin(); ee != se.end(); ++ee)
-			std::cerr << " " << *ee;
+		BitSet &se = A_orig[i];
+		for (int v = se.first(); v != -1; v = se.next(v + 1))
+			std::cerr << " " << locs[v];
 		std::cerr << "\n";
 	}
 }
@@ -760,8 +1100,8 @@ void DefCollector::insert(Assign *a)
 void DataFlow::convertImplicits(Cfg *cfg)
 {
 	// Convert statements in A_phi from m[...]{-} to m[...]{0}
-	std::map<Exp *, std::set<int>, lessExpStar> A_phi_copy = A_phi;  // Object copy
-	std::map<Exp *, std::set<int>, lessExpStar>::iterator it;
+	std::map<Exp *, BitSet, lessExpStar> A_phi_copy = A_phi;  // Object copy
+	std::map<Exp *, BitSet, lessExpStar>::iterator it;
 	ImplicitConverter ic(cfg);
 	A_phi.clear();
 	for (it = A_phi_copy.begin(); it != A_phi_copy.end(); ++it) {
@@ -770,29 +1110,11 @@ void DataFlow::convertImplicits(Cfg *cfg)
 		A_phi[e] = it->second;  // Copy the set (doesn't have to be deep)
 	}
 
-	std::map<Exp *, std::set<int>, lessExpStar> defsites_copy = defsites;  // Object copy
-	std::map<Exp *, std::set<int>, lessExpStar>::iterator dd;
+	// The location numbering, defsites and A_orig are all recreated by the next placePhiFunctions
 	defsites.clear();
-	for (dd = A_phi_copy.begin(); dd != A_phi_copy.end(); ++dd) {
-		Exp *e = dd->first->clone();
-		e = e->accept(&ic);
-		defsites[e] = dd->second;  // Copy the set (doesn't have to be deep)
-	}
-
-	std::vector<std::set<Exp *, lessExpStar> > A_orig_copy;
-	std::vector<std::set<Exp *, lessExpStar> >::iterator oo;
 	A_orig.clear();
-	for (oo = A_orig_copy.begin(); oo != A_orig_copy.end(); ++oo) {
-		std::set<Exp *, lessExpStar> &se = *oo;
-		std::set<Exp *, lessExpStar> se_new;
-		std::set<Exp *, lessExpStar>::iterator ee;
-		for (ee = se.begin(); ee != se.end(); ++ee) {
-			Exp *e = (*ee)->clone();
-			e = e->accept(&ic);
-			se_new.insert(e);
-		}
-		A_orig.insert(A_orig.end(), se_new);  // Copy the set (doesn't have to be a deep copy)
-	}
+	locs.clear();
+	locNums.clear();
 }
 
 
@@ -27,12 +27,16 @@
 #include <map>          // In decideType()
 #include <sstream>      // Need gcc 3.0 or better
 #include <iomanip>      // For std::setw etc
+#include <typeinfo>     // For typeid in ExpFactory
 
 #include <cstring>
 #include <cassert>
 
 extern char debug_buffer[];      ///< For prints functions
 
+unsigned Exp::simplifyCalls = 0;
+unsigned Exp::simplifySkips = 0;
+
 /*==============================================================================
  * FUNCTION:        Const::Const etc
  * OVERVIEW:        Constructors
@@ -200,18 +204,24 @@ TypeVal::~TypeVal()
  *============================================================================*/
 void Unary::setSubExp1(Exp *e)
 {
+	assert(!interned);
+	canonical = false;
 	if (subExp1 != 0) ;//delete subExp1;
 	subExp1 = e;
 	assert(subExp1);
 }
 void Binary::setSubExp2(Exp *e)
 {
+	assert(!interned);
+	canonical = false;
 	if (subExp2 != 0) ;//delete subExp2;
 	subExp2 = e;
 	assert(subExp1 && subExp2);
 }
 void Ternary::setSubExp3(Exp *e)
 {
+	assert(!interned);
+	canonical = false;
 	if (subExp3 != 0) ;//delete subExp3;
 	subExp3 = e;
 	assert(subExp1 && subExp2 && subExp3);
@@ -229,6 +239,8 @@ Exp *Unary::getSubExp1()
 }
 Exp *&Unary::refSubExp1()
 {
+	assert(!interned);
+	canonical = false;  // The caller may change the subexpression through the reference
 	assert(subExp1);
 	return subExp1;
 }
@@ -239,6 +251,8 @@ Exp *Binary::getSubExp2()
 }
 Exp *&Binary::refSubExp2()
 {
+	assert(!interned);
+	canonical = false;
 	assert(subExp1 && subExp2);
 	return subExp2;
 }
@@ -249,6 +263,8 @@ Exp *Ternary::getSubExp3()
 }
 Exp *&Ternary::refSubExp3()
 {
+	assert(!interned);
+	canonical = false;
 	assert(subExp1 && subExp2 && subExp3);
 	return subExp3;
 }
@@ -272,6 +288,7 @@ void Binary::commute()
 	Exp *t = subExp1;
 	subExp1 = subExp2;
 	subExp2 = t;
+	canonical = false;
 	assert(subExp1 && subExp2);
 }
 
@@ -366,6 +383,8 @@ bool Const::operator==(const Exp &o) const
 }
 bool Unary::operator==(const Exp &o) const
 {
+	int ic = internedCompare(o);
+	if (ic != -1) return ic == 1;
 	if (((Unary &)o).op == opWild) return true;
 	if (((Unary &)o).op == opWildRegOf && op == opRegOf) return true;
 	if (((Unary &)o).op == opWildMemOf && op == opMemOf) return true;
@@ -376,6 +395,8 @@ bool Unary::operator==(const Exp &o) const
 bool Binary::operator==(const Exp &o) const
 {
 	assert(subExp1 && subExp2);
+	int ic = internedCompare(o);
+	if (ic != -1) return ic == 1;
 	if (((Binary &)o).op == opWild) return true;
 	if (op != ((Binary &)o).op) return false;
 	if (!( *subExp1 == *((Binary &)o).getSubExp1())) return false;
@@ -383,6 +404,8 @@ bool Binary::operator==(const Exp &o) const
 }
 bool Ternary::operator==(const Exp &o) const
 {
+	int ic = internedCompare(o);
+	if (ic != -1) return ic == 1;
 	if (((Ternary &)o).op == opWild) return true;
 	if (op != ((Ternary &)o).op) return false;
 	if (!( *subExp1 == *((Ternary &)o).getSubExp1())) return false;
@@ -402,6 +425,8 @@ bool Terminal::operator==(const Exp &o) const
 }
 bool TypedExp::operator==(const Exp &o) const
 {
+	int ic = internedCompare(o);
+	if (ic != -1) return ic == 1;
 	if (((TypedExp &)o).op == opWild) return true;
 	if (((TypedExp &)o).op != opTypedExp) return false;
 	// This is the strict type version
@@ -410,6 +435,8 @@ bool TypedExp::operator==(const Exp &o) const
 }
 bool RefExp::operator==(const Exp &o) const
 {
+	int ic = internedCompare(o);
+	if (ic != -1) return ic == 1;
 	if (((RefExp &)o).op == opWild) return true;
 	if (((RefExp &)o).op != opSubscript) return false;
 	if (!(*subExp1 == *((RefExp &)o).subExp1)) return false;
@@ -463,6 +490,7 @@ bool Terminal::operator<(const Exp &o) const
 }
 bool Unary::operator<(const Exp &o) const
 {
+	if (this == &o) return false;  // Common with shared (interned) subexpressions
 	if (op < o.getOper()) return true;
 	if (op > o.getOper()) return false;
 	return *subExp1 < *((Unary &)o).getSubExp1();
@@ -470,6 +498,7 @@ bool Unary::operator<(const Exp &o) const
 bool Binary::operator<(const Exp &o) const
 {
 	assert(subExp1 && subExp2);
+	if (this == &o) return false;
 	if (op < o.getOper()) return true;
 	if (op > o.getOper()) return false;
 	if (*subExp1 < *((Binary &)o).getSubExp1()) return true;
@@ -478,6 +507,7 @@ bool Binary::operator<(const Exp &o) const
 }
 bool Ternary::operator<(const Exp &o) const
 {
+	if (this == &o) return false;
 	if (op < o.getOper()) return true;
 	if (op > o.getOper()) return false;
 	if (*subExp1 < *((Ternary &)o).getSubExp1()) return true;
@@ -502,6 +532,7 @@ bool TypedExp::operator<(const Exp &o) const  // Type sensitive
 }
 bool RefExp::operator<(const Exp &o) const
 {
+	if (this == &o) return false;
 	if (opSubscript < o.getOper()) return true;
 	if (opSubscript > o.getOper()) return false;
 	if (*subExp1 < *((Unary &)o).getSubExp1()) return true;
@@ -1416,192 +1447,258 @@ Exp *TypeVal::match(Exp *pattern)
 #endif
 
 #define ISVARIABLE(x) (strspn((x), "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789") == strlen((x)))
-//#define DEBUG_MATCH
-
-const char *tlstrchr(const char *str, char ch)
-{
-	while (str && *str) {
-		if (*str == ch)
-			return str;
-		if (*str == '[' || *str == '{' || *str == '(') {
-			char close = ']';
-			if (*str == '{')
-				close = '}';
-			if (*str == '(')
-				close = ')';
-			while (*str && *str != close)
-				str++;
-		}
-		if (*str)
-			str++;
-	}
-	return NULL;
-}
 
 /*==============================================================================
  * FUNCTION:        Exp::match
- * OVERVIEW:        Matches this expression to the given patten
+ * OVERVIEW:        Matches this expression to the given patten. Each distinct pattern is compiled only once
  * PARAMETERS:      pattern to match, map of bindings
  * RETURNS:         true if match, false otherwise
  *============================================================================*/
 bool Exp::match(const char *pattern, std::map<std::string, Exp *> &bindings)
 {
-	// most obvious
-	std::ostringstream ostr;
-	this->print(ostr);
-	if (ostr.str() == pattern)
-		return true;
-
-	// alright, is pattern an acceptable variable?
-	if (ISVARIABLE(pattern)) {
-		bindings[pattern] = this;
-		return true;
-	}
-
-	// no, fail
-	return false;
+	static std::map<std::string, ExpPattern *> compiled;
+	ExpPattern *&pat = compiled[pattern];
+	if (pat == NULL)
+		pat = new ExpPattern(pattern);
+	return pat->match(this, bindings);
 }
-bool Unary::match(const char *pattern, std::map<std::string, Exp *> &bindings)
+
+/*==============================================================================
+ * FUNCTION:        ExpPattern::ExpPattern
+ * OVERVIEW:        Compile a textual pattern
+ * PARAMETERS:      pattern: the pattern, in the syntax of printed expressions
+ * RETURNS:         <nothing>
+ *============================================================================*/
+ExpPattern::ExpPattern(const char *pattern)
 {
-	if (Exp::match(pattern, bindings))
-		return true;
-#ifdef DEBUG_MATCH
-	LOG << "unary::match " << this << " to " << pattern << ".\n";
-#endif
-	if (op == opAddrOf && pattern[0] == 'a' && pattern[1] == '['
-	 && pattern[strlen(pattern) - 1] == ']') {
-		char *sub1 = strdup(pattern + 2);
-		sub1[strlen(sub1) - 1] = 0;
-		return subExp1->match(sub1, bindings);
-	}
-	return false;
+	root = compile(pattern);
 }
-bool Binary::match(const char *pattern, std::map<std::string, Exp *> &bindings)
+
+int ExpPattern::newNode(Kind kind, OPER op)
 {
-	if (Exp::match(pattern, bindings))
-		return true;
-#ifdef DEBUG_MATCH
-	LOG << "binary::match " << this << " to " << pattern << ".\n";
-#endif
-	if (op == opMemberAccess && tlstrchr(pattern, '.')) {
-		char *sub1 = strdup(pattern);
-		char *sub2 = (char *)tlstrchr(sub1, '.');
-		*sub2++ = 0;
-		if (subExp1->match(sub1, bindings)) {
-			assert(subExp2->isStrConst());
-			if (!strcmp(sub2, ((Const *)subExp2)->getStr()))
-				return true;
-			if (ISVARIABLE(sub2)) {
-				bindings[sub2] = subExp2;
-				return true;
-			}
-		}
-	}
-	if (op == opArrayIndex) {
-		if (pattern[strlen(pattern) - 1] != ']')
-			return false;
-		char *sub1 = strdup(pattern);
-		char *sub2 = strrchr(sub1, '[');
-		*sub2++ = 0;
-		sub2[strlen(sub2) - 1] = 0;
-		if (subExp1->match(sub1, bindings) && subExp2->match(sub2, bindings))
-			return true;
-	}
-	if (op == opPlus && tlstrchr(pattern, '+')) {
-		char *sub1 = strdup(pattern);
-		char *sub2 = (char *)tlstrchr(sub1, '+');
-		*sub2++ = 0;
-		while (*sub2 == ' ')
-			sub2++;
-		while (sub1[strlen(sub1) - 1] == ' ')
-			sub1[strlen(sub1) - 1] = 0;
-		if (subExp1->match(sub1, bindings) && subExp2->match(sub2, bindings))
-			return true;
-	}
-	if (op == opMinus && tlstrchr(pattern, '-')) {
-		char *sub1 = strdup(pattern);
-		char *sub2 = (char *)tlstrchr(sub1, '-');
-		*sub2++ = 0;
-		while (*sub2 == ' ')
-			sub2++;
-		while (sub1[strlen(sub1) - 1] == ' ')
-			sub1[strlen(sub1) - 1] = 0;
-		if (subExp1->match(sub1, bindings) && subExp2->match(sub2, bindings))
-			return true;
-	}
-	return false;
+	Node nd;
+	nd.kind = kind;
+	nd.op = op;
+	nd.sub1 = nd.sub2 = nd.var = -1;
+	nd.val = 0;
+	nodes.push_back(nd);
+	return nodes.size() - 1;
 }
-bool Ternary::match(const char *pattern, std::map<std::string, Exp *> &bindings)
+
+int ExpPattern::varFor(const std::string &name)
 {
-	if (Exp::match(pattern, bindings))
-		return true;
-#ifdef DEBUG_MATCH
-	LOG << "ternary::match " << this << " to " << pattern << ".\n";
-#endif
-	return false;
+	int v = getVarNum(name.c_str());
+	if (v != -1)
+		return v;
+	vars.push_back(name);
+	return vars.size() - 1;
 }
-bool RefExp::match(const char *pattern, std::map<std::string, Exp *> &bindings)
+
+int ExpPattern::getVarNum(const char *name) const
 {
-	if (Exp::match(pattern, bindings))
-		return true;
-#ifdef DEBUG_MATCH
-	LOG << "refexp::match " << this << " to " << pattern << ".\n";
-#endif
-	const char *end = pattern + strlen(pattern) - 1;
-	if (end > pattern && *end == '}') {
-		end--;
-		if (*end == '-' && def == NULL) {
-			char *sub = strdup(pattern);
-			*(sub + (end - 1 - pattern)) = 0;
-			return subExp1->match(sub, bindings);
-		}
-		end = strrchr(end, '{');
-		if (end) {
-			if (atoi(end + 1) == def->getNumber()) {
-				char *sub = strdup(pattern);
-				*(sub + (end - pattern)) = 0;
-				return subExp1->match(sub, bindings);
+	for (unsigned i = 0; i < vars.size(); i++)
+		if (vars[i] == name)
+			return i;
+	return -1;
+}
+
+/*==============================================================================
+ * FUNCTION:        ExpPattern::compile
+ * OVERVIEW:        Compile (part of) a pattern to a node. + and - bind the loosest and associate to the left, so the
+ *                    pattern is split at the last of them at the top level; otherwise the last postfix ({n}, [x] or
+ *                    .name) is the outermost operator
+ * PARAMETERS:      pat: the text of the pattern
+ * RETURNS:         The index of the new node
+ *============================================================================*/
+int ExpPattern::compile(const std::string &pat)
+{
+	std::string::size_type b = pat.find_first_not_of(' ');
+	std::string t = (b == std::string::npos) ? "" : pat.substr(b, pat.find_last_not_of(' ') - b + 1);
+	int n;
+	if (t.empty())
+		return compileLiteral(t);
+	if (ISVARIABLE(t.c_str())) {
+		n = newNode(VAR);
+		nodes[n].var = varFor(t);
+		return n;
+	}
+
+	// Find the last top level binary + or -, and the last top level .
+	int depth = 0;
+	std::string::size_type split = std::string::npos, dot = std::string::npos;
+	char prev = 0;  // Last non space character
+	for (std::string::size_type i = 0; i < t.size(); i++) {
+		char c = t[i];
+		if (c == '[' || c == '{' || c == '(')
+			depth++;
+		else if (c == ']' || c == '}' || c == ')')
+			depth--;
+		else if (depth == 0 && (c == '+' || c == '-') && prev && !strchr("+-*/", prev))
+			split = i;
+		else if (depth == 0 && c == '.')
+			dot = i;
+		if (c != ' ')
+			prev = c;
+	}
+	if (split != std::string::npos) {
+		int s1 = compile(t.substr(0, split));
+		int s2 = compile(t.substr(split + 1));
+		n = newNode(OP2, t[split] == '+' ? opPlus : opMinus);
+		nodes[n].sub1 = s1;
+		nodes[n].sub2 = s2;
+		return n;
+	}
+
+	char last = t[t.size() - 1];
+	if (last == '}' || last == ']') {
+		// Find the matching open bracket
+		char open = (last == '}') ? '{' : '[';
+		std::string::size_type i = t.size() - 1;
+		depth = 0;
+		do {
+			if (t[i] == last) depth++;
+			else if (t[i] == open) depth--;
+		} while (depth && i-- > 0);
+		if (depth == 0 && i > 0) {
+			std::string inner = t.substr(i + 1, t.size() - i - 2);
+			if (last == '}') {
+				int s1 = compile(t.substr(0, i));
+				n = newNode(SUBSCRIPT);
+				nodes[n].sub1 = s1;
+				nodes[n].val = (inner == "-") ? -1 : atoi(inner.c_str());
+				return n;
+			}
+			if (i == 1 && strchr("amr", t[0])) {
+				int s1 = compile(inner);
+				n = newNode(OP1, t[0] == 'a' ? opAddrOf : t[0] == 'm' ? opMemOf : opRegOf);
+				nodes[n].sub1 = s1;
+				return n;
 			}
+			int s1 = compile(t.substr(0, i));
+			int s2 = compile(inner);
+			n = newNode(OP2, opArrayIndex);
+			nodes[n].sub1 = s1;
+			nodes[n].sub2 = s2;
+			return n;
 		}
+	} else if (dot != std::string::npos && dot > 0) {
+		int s1 = compile(t.substr(0, dot));
+		n = newNode(MEMBER);
+		nodes[n].sub1 = s1;
+		nodes[n].text = t.substr(dot + 1);
+		if (ISVARIABLE(nodes[n].text.c_str()))
+			nodes[n].var = varFor(nodes[n].text);
+		return n;
+	}
+
+	return compileLiteral(t);
+}
+
+// The terminals that a pattern can name, as Terminal::print() prints them
+static const struct {
+	const char *name;
+	OPER        op;
+} patternTerminals[] = {
+	{ "%pc", opPC }, { "%flags", opFlags }, { "%fflags", opFflags }, { "%CF", opCF }, { "%ZF", opZF },
+	{ "%OF", opOF }, { "%NF", opNF }, { "%DF", opDF }, { "%afp", opAFP }, { "%agp", opAGP }, { "%anul", opAnull },
+	{ "FPUSH", opFpush }, { "FPOP", opFpop }, { "true", opTrue }, { "false", opFalse }, { "<all>", opDefineAll },
+	{ "", opNil }
+};
+
+/*==============================================================================
+ * FUNCTION:        ExpPattern::compileLiteral
+ * OVERVIEW:        Compile text that is not a variable or an operator to a test for the constant or terminal it
+ *                    stands for, so that matching never has to print the expression. Only negative integers get here
+ *                    (an unsigned number is alphanumeric, so it is a variable). Text that stands for nothing in
+ *                    particular gives a node that matches nothing
+ * PARAMETERS:      t: the text, with no surrounding spaces
+ * RETURNS:         The index of the new node
+ *============================================================================*/
+int ExpPattern::compileLiteral(const std::string &t)
+{
+	int n;
+	if (t[0] == '-' && t.size() > 1 && strspn(t.c_str() + 1, "0123456789") == t.size() - 1) {
+		n = newNode(INTLIT);
+		nodes[n].val = atoi(t.c_str());
+		return n;
 	}
-	return false;
+	if (t.size() >= 2 && t[0] == '"' && t[t.size() - 1] == '"') {
+		n = newNode(STRLIT);
+		nodes[n].text = t.substr(1, t.size() - 2);
+		return n;
+	}
+	for (unsigned i = 0; i < sizeof(patternTerminals) / sizeof(patternTerminals[0]); i++)
+		if (t == patternTerminals[i].name)
+			return newNode(TERMINAL, patternTerminals[i].op);
+	return newNode(NOMATCH);
 }
-bool Const::match(const char *pattern, std::map<std::string, Exp *> &bindings)
+
+/*==============================================================================
+ * FUNCTION:        ExpPattern::match
+ * OVERVIEW:        Match an expression against the compiled pattern
+ * PARAMETERS:      e: the expression
+ *                  bound: array of getNumVars() expressions, set to the bindings of the variables
+ * RETURNS:         true if match, false otherwise
+ *============================================================================*/
+bool ExpPattern::match(Exp *e, Exp **bound) const
 {
-	if (Exp::match(pattern, bindings))
-		return true;
-#ifdef DEBUG_MATCH
-	LOG << "const::match " << this << " to " << pattern << ".\n";
-#endif
-	return false;
+	return matchNode(root, e, bound);
 }
-bool Terminal::match(const char *pattern, std::map<std::string, Exp *> &bindings)
+
+bool ExpPattern::match(Exp *e, std::map<std::string, Exp *> &bindings) const
 {
-	if (Exp::match(pattern, bindings))
-		return true;
-#ifdef DEBUG_MATCH
-	LOG << "terminal::match " << this << " to " << pattern << ".\n";
-#endif
-	return false;
+	std::vector<Exp *> bound(vars.size(), (Exp *)NULL);
+	if (!matchNode(root, e, vars.empty() ? NULL : &bound[0]))
+		return false;
+	for (unsigned i = 0; i < vars.size(); i++)
+		if (bound[i])
+			bindings[vars[i]] = bound[i];
+	return true;
 }
-bool Location::match(const char *pattern, std::map<std::string, Exp *> &bindings)
+
+bool ExpPattern::matchNode(int n, Exp *e, Exp **bound) const
 {
-	if (Exp::match(pattern, bindings))
+	const Node &nd = nodes[n];
+	switch (nd.kind) {
+	case VAR:
+		bound[nd.var] = e;
 		return true;
-#ifdef DEBUG_MATCH
-	LOG << "location::match " << this << " to " << pattern << ".\n";
-#endif
-	if (op == opMemOf || op == opRegOf) {
-		char ch = 'm';
-		if (op == opRegOf)
-			ch = 'r';
-		if (pattern[0] != ch || pattern[1] != '[')
-			return false;
-		if (pattern[strlen(pattern) - 1] != ']')
-			return false;
-		char *sub = strdup(pattern + 2);
-		*(sub + strlen(sub) - 1) = 0;
-		return subExp1->match(sub, bindings);
+	case OP1:
+		return e->getOper() == nd.op
+		    && matchNode(nd.sub1, e->getSubExp1(), bound);
+	case OP2:
+		return e->getOper() == nd.op
+		    && matchNode(nd.sub1, e->getSubExp1(), bound)
+		    && matchNode(nd.sub2, e->getSubExp2(), bound);
+	case SUBSCRIPT:
+		{
+			if (!e->isSubscript())
+				return false;
+			Statement *def = ((RefExp *)e)->getDef();
+			if (nd.val == -1 ? def != NULL : (def == NULL || def->getNumber() != nd.val))
+				return false;
+			return matchNode(nd.sub1, e->getSubExp1(), bound);
+		}
+	case MEMBER:
+		{
+			if (e->getOper() != opMemberAccess || !e->getSubExp2()->isStrConst()
+			 || !matchNode(nd.sub1, e->getSubExp1(), bound))
+				return false;
+			if (nd.text == ((Const *)e->getSubExp2())->getStr())
+				return true;
+			if (nd.var == -1)
+				return false;
+			bound[nd.var] = e->getSubExp2();
+			return true;
+		}
+	case INTLIT:
+		return e->isIntConst() && ((Const *)e)->getInt() == nd.val;
+	case STRLIT:
+		return e->isStrConst() && nd.text == ((Const *)e)->getStr();
+	case TERMINAL:
+		return e->getOper() == nd.op;
+	case NOMATCH:
+		return false;
 	}
 	return false;
 }
@@ -1701,6 +1798,12 @@ Exp *Exp::searchReplaceAll(Exp *search, Exp *replace, bool &change, bool once /*
 	std::list<Exp **> li;
 	Exp *top = this;  // top may change; that's why we have to return it
 	doSearch(search, top, li, false);
+	if (li.size() && interned) {
+		// Don't modify a shared expression; replace in a private copy instead
+		top = clone();
+		li.clear();
+		doSearch(search, top, li, false);
+	}
 	std::list<Exp **>::iterator it;
 	for (it = li.begin(); it != li.end(); it++) {
 		Exp **pp = *it;
@@ -1833,6 +1936,7 @@ void Exp::partitionTerms(std::list<Exp *> &positives, std::list<Exp *> &negative
  *============================================================================*/
 Exp *Unary::simplifyArith()
 {
+	canonical = false;
 	if (op == opMemOf || op == opRegOf || op == opAddrOf || op == opSubscript) {
 		// assume we want to simplify the subexpression
 		subExp1 = subExp1->simplifyArith();
@@ -1842,6 +1946,7 @@ Exp *Unary::simplifyArith()
 
 Exp *Ternary::simplifyArith()
 {
+	canonical = false;
 	subExp1 = subExp1->simplifyArith();
 	subExp2 = subExp2->simplifyArith();
 	subExp3 = subExp3->simplifyArith();
@@ -1850,6 +1955,7 @@ Exp *Ternary::simplifyArith()
 
 Exp *Binary::simplifyArith()
 {
+	canonical = false;
 	assert(subExp1 && subExp2);
 	subExp1 = subExp1->simplifyArith();  // FIXME: does this make sense?
 	subExp2 = subExp2->simplifyArith();  // FIXME: ditto
@@ -1979,8 +2085,13 @@ Exp *Exp::simplify()
 #if DEBUG_SIMP
 	Exp *save = clone();
 #endif
+	simplifyCalls++;
+	if (!interned && isCanonical()) {  // Interned expressions still give a modifiable copy
+		simplifySkips++;  // Already simplified, and not changed since
+		return this;
+	}
 	bool bMod = false;  // True if simplified at this or lower level
-	Exp *res = this;
+	Exp *res = interned ? clone() : this;  // Simplification is done in place
 	//res = ExpTransformer::applyAllTo(res, bMod);
 	//return res;
 	do {
@@ -2002,9 +2113,71 @@ Exp *Exp::simplify()
 	if (!(*res == *save)) std::cout << "simplified " << save << "  to  " << res << "\n";
 	;//delete save;
 #endif
+	res->setCanonical();
 	return res;
 }
 
+/*==============================================================================
+ * FUNCTION:        Exp::isCanonical
+ * OVERVIEW:        Check whether this expression is already fully simplified, i.e. simplify() has left it (and every
+ *                    subexpression) as it is, and nothing has changed it since. Any change to a node clears its flag,
+ *                    and the subexpressions are checked too, since a child can be changed without its parent knowing.
+ * PARAMETERS:      <none>
+ * RETURNS:         True if simplify() would return this expression unchanged
+ *============================================================================*/
+bool Exp::isCanonical()
+{
+	if (!canonical)
+		return false;
+	switch (getArity()) {
+	case 3:
+		if (!getSubExp3()->isCanonical()) return false;
+		// Fall through
+	case 2:
+		if (!getSubExp2()->isCanonical()) return false;
+		// Fall through
+	case 1:
+		return getSubExp1()->isCanonical();
+	}
+	return true;
+}
+
+/*==============================================================================
+ * FUNCTION:        Exp::setCanonical
+ * OVERVIEW:        Mark this expression and its subexpressions as simplified. A few simplifications depend on more
+ *                    than the expression itself (the defining statement of a subscript, or the program's data), so
+ *                    nodes they could apply to are never marked, and are always simplified again.
+ * PARAMETERS:      <none>
+ * RETURNS:         <nothing>
+ *============================================================================*/
+void Exp::setCanonical()
+{
+	int n = getArity();
+	if (n >= 1) getSubExp1()->setCanonical();
+	if (n >= 2) getSubExp2()->setCanonical();
+	if (n >= 3) getSubExp3()->setCanonical();
+	switch (op) {
+	case opSubscript:
+		// %DF{-} and r0{def} depend on the definition
+		if (getSubExp1()->getOper() == opDF || getSubExp1()->isRegN(0))
+			return;
+		break;
+	case opPlus:
+		// x{def} + K depends on the type of the definition
+		if (getSubExp1()->isSubscript() && getSubExp2()->isIntConst())
+			return;
+		break;
+	case opFsize:
+		// fsize(a, b, m[K]) depends on the floating point constants in the program
+		if (getSubExp3()->isMemOf() && getSubExp3()->getSubExp1()->isIntConst())
+			return;
+		break;
+	default:
+		break;
+	}
+	canonical = true;
+}
+
 /*==============================================================================
  * FUNCTION:        Unary::polySimplify etc
  * OVERVIEW:        Do the work of simplification
@@ -2015,6 +2188,7 @@ Exp *Exp::simplify()
  *============================================================================*/
 Exp *Unary::polySimplify(bool &bMod)
 {
+	canonical = false;  // Set again by simplify() if this node survives to the result
 	Exp *res = this;
 	subExp1 = subExp1->polySimplify(bMod);
 
@@ -2132,6 +2306,7 @@ Exp *Unary::polySimplify(bool &bMod)
 
 Exp *Binary::polySimplify(bool &bMod)
 {
+	canonical = false;
 	assert(subExp1 && subExp2);
 
 	Exp *res = this;
@@ -2884,6 +3059,7 @@ Exp *Binary::polySimplify(bool &bMod)
 
 Exp *Ternary::polySimplify(bool &bMod)
 {
+	canonical = false;
 	Exp *res = this;
 
 	subExp1 = subExp1->polySimplify(bMod);
@@ -3018,6 +3194,7 @@ Exp *Ternary::polySimplify(bool &bMod)
 
 Exp *TypedExp::polySimplify(bool &bMod)
 {
+	canonical = false;
 	Exp *res = this;
 
 	if (subExp1->getOper() == opRegOf) {
@@ -3033,6 +3210,7 @@ Exp *TypedExp::polySimplify(bool &bMod)
 
 Exp *RefExp::polySimplify(bool &bMod)
 {
+	canonical = false;
 	Exp *res = this;
 
 	Exp *tmp = subExp1->polySimplify(bMod);
@@ -3076,6 +3254,7 @@ Exp *RefExp::polySimplify(bool &bMod)
  *============================================================================*/
 Exp *Unary::simplifyAddr()
 {
+	canonical = false;
 	Exp *sub;
 	if (op == opMemOf && subExp1->isAddrOf()) {
 		Unary *s = (Unary *)getSubExp1();
@@ -3109,6 +3288,7 @@ Exp *Unary::simplifyAddr()
 
 Exp *Binary::simplifyAddr()
 {
+	canonical = false;
 	assert(subExp1 && subExp2);
 
 	subExp1 = subExp1->simplifyAddr();
@@ -3118,6 +3298,7 @@ Exp *Binary::simplifyAddr()
 
 Exp *Ternary::simplifyAddr()
 {
+	canonical = false;
 	subExp1 = subExp1->simplifyAddr();
 	subExp2 = subExp2->simplifyAddr();
 	subExp3 = subExp3->simplifyAddr();
@@ -3294,6 +3475,7 @@ Exp *Exp::fromSSAleft(UserProc *proc, Statement *d)
 // A helper class for comparing Exp*'s sensibly
 bool lessExpStar::operator()(const Exp *x, const Exp *y) const
 {
+	if (x == y) return false;  // Same (e.g. interned) expression
 	return (*x < *y);  // Compare the actual Exps
 }
 
@@ -3302,6 +3484,232 @@ bool lessTI::operator()(const Exp *x, const Exp *y) const
 	return (*x << *y);  // Compare the actual Exps
 }
 
+// Mix one more value into a hash (FNV style)
+static inline unsigned hashMix(unsigned h, unsigned v)
+{
+	return (h ^ v) * 16777619u;
+}
+
+/*==============================================================================
+ * FUNCTION:        Exp::hash
+ * OVERVIEW:        Compute a structural hash of this expression. Expressions that are equal according to operator==
+ *                  have the same hash, provided neither has wildcards. Types of typed expressions and type values are
+ *                  not hashed, and neither are Location procs.
+ * PARAMETERS:      <none>
+ * RETURNS:         The hash value (cached for interned expressions)
+ *============================================================================*/
+unsigned Exp::hash()
+{
+	if (interned) return hashVal;
+	unsigned h = hashMix(2166136261u, op);
+	switch (op) {
+	case opIntConst:
+		h = hashMix(h, ((Const *)this)->getInt());
+		break;
+	case opFltConst:
+		{
+			double d = ((Const *)this)->getFlt();
+			if (d == 0.0) d = 0.0;  // -0.0 == 0.0
+			unsigned char *p = (unsigned char *)&d;
+			for (unsigned i = 0; i < sizeof(d); i++)
+				h = hashMix(h, p[i]);
+			break;
+		}
+	case opStrConst:
+		for (const char *p = ((Const *)this)->getStr(); *p; p++)
+			h = hashMix(h, *p);
+		break;
+	case opSubscript:
+		{
+			// A NULL definition compares equal to an implicit one, so these must hash the same
+			Statement *def = ((RefExp *)this)->getDef();
+			if (def != NULL && def != (Statement *)-1 && !def->isImplicit())
+				h = hashMix(h, (unsigned)(size_t)def);
+			break;
+		}
+	default:
+		break;
+	}
+	int n = getArity();
+	if (n >= 1) h = hashMix(h, getSubExp1()->hash());
+	if (n >= 2) h = hashMix(h, getSubExp2()->hash());
+	if (n >= 3) h = hashMix(h, getSubExp3()->hash());
+	return h;
+}
+
+//  //  //  //  //  //
+//  ExpFactory  //
+//  //  //  //  //  //
+
+#define EXPFACTORY_INIT_BUCKETS 1024
+
+ExpFactory::ExpFactory() : count(0), hits(0), misses(0)
+{
+	buckets.resize(EXPFACTORY_INIT_BUCKETS);
+}
+
+/*==============================================================================
+ * FUNCTION:        ExpFactory::canIntern
+ * OVERVIEW:        Check whether an expression can be interned. Wildcards, constants with conscripts, and wild
+ *                  subscripts would make pointer identity disagree with operator== (which is not symmetric for these),
+ *                  and a FlagDef refers to an RTL, so these are all excluded.
+ * PARAMETERS:      e: the expression to check
+ * RETURNS:         True if e and all of its subexpressions can be interned
+ *============================================================================*/
+bool ExpFactory::canIntern(Exp *e)
+{
+	if (e->isInterned()) return true;
+	switch (e->getOper()) {
+	case opWild:
+	case opWildIntConst:
+	case opWildStrConst:
+	case opWildMemOf:
+	case opWildRegOf:
+	case opWildAddrOf:
+	case opFlagDef:
+		return false;
+	case opIntConst:
+	case opFltConst:
+	case opStrConst:
+		return ((Const *)e)->getConscript() == 0;
+	case opSubscript:
+		{
+			if (((RefExp *)e)->getDef() == (Statement *)-1) return false;
+			break;
+		}
+	default:
+		if (dynamic_cast<Const *>(e)) return false;  // E.g. opFuncConst, opLongConst: operator== can't compare these
+		break;
+	}
+	int n = e->getArity();
+	if (n >= 1 && !canIntern(e->getSubExp1())) return false;
+	if (n >= 2 && !canIntern(e->getSubExp2())) return false;
+	if (n >= 3 && !canIntern(e->getSubExp3())) return false;
+	return true;
+}
+
+/*==============================================================================
+ * FUNCTION:        ExpFactory::intern
+ * OVERVIEW:        Find or create the shared node for e. Subexpressions are interned first, so structurally identical
+ *                  expressions end up as the same DAG of shared nodes.
+ * PARAMETERS:      e: the expression to intern. It is not retained, so the caller may go on modifying it
+ * RETURNS:         The interned equivalent of e, or e itself if it can't be interned
+ *============================================================================*/
+Exp *ExpFactory::intern(Exp *e)
+{
+	if (e->isInterned() || !canIntern(e))
+		return e;
+	return internNode(e);
+}
+
+Exp *ExpFactory::internNode(Exp *e)
+{
+	if (e->isInterned()) return e;
+	Exp *c1 = NULL, *c2 = NULL, *c3 = NULL;
+	int n = e->getArity();
+	if (n >= 1) c1 = internNode(e->getSubExp1());
+	if (n >= 2) c2 = internNode(e->getSubExp2());
+	if (n >= 3) c3 = internNode(e->getSubExp3());
+	Exp *node = makeNode(e, c1, c2, c3);
+	unsigned h = node->hash();  // Cheap: the subexpressions have cached hashes
+	std::vector<Exp *> &bucket = buckets[h % buckets.size()];
+	for (std::vector<Exp *>::iterator it = bucket.begin(); it != bucket.end(); it++) {
+		if ((*it)->hashVal == h && sameNode(*it, node)) {
+			hits++;
+			return *it;
+		}
+	}
+	misses++;
+	node->hashVal = h;
+	node->interned = true;
+	bucket.push_back(node);
+	if (++count > buckets.size())
+		grow();
+	return node;
+}
+
+// Make a new node like e, but with the given subexpressions
+Exp *ExpFactory::makeNode(Exp *e, Exp *c1, Exp *c2, Exp *c3)
+{
+	OPER op = e->getOper();
+	if (op == opIntConst || op == opFltConst || op == opStrConst)
+		return new Const(*(Const *)e);
+	switch (op) {
+	case opSubscript:
+		return new RefExp(c1, ((RefExp *)e)->getDef());
+	case opTypedExp:
+		return new TypedExp(((TypedExp *)e)->getType(), c1);
+	case opTypeVal:
+		return new TypeVal(((TypeVal *)e)->getType());
+	default:
+		break;
+	}
+	Location *loc = dynamic_cast<Location *>(e);
+	if (loc) {
+		Location *l = new Location(op, c1, loc->getProc());
+		l->setProc(loc->getProc());  // The constructor may find a proc from c1 if NULL
+		return l;
+	}
+	switch (e->getArity()) {
+	case 0: return new Terminal(op);
+	case 1: return new Unary(op, c1);
+	case 2: return new Binary(op, c1, c2);
+	default: return new Ternary(op, c1, c2, c3);
+	}
+}
+
+// Check if node a can stand in for b. Subexpressions are already interned, so they are compared by pointer
+bool ExpFactory::sameNode(Exp *a, Exp *b)
+{
+	OPER op = a->getOper();
+	if (op != b->getOper()) return false;
+	if (typeid(*a) != typeid(*b)) return false;
+	int n = a->getArity();
+	if (n >= 1 && a->getSubExp1() != b->getSubExp1()) return false;
+	if (n >= 2 && a->getSubExp2() != b->getSubExp2()) return false;
+	if (n >= 3 && a->getSubExp3() != b->getSubExp3()) return false;
+	if (op == opIntConst || op == opFltConst || op == opStrConst) {
+		Const *ca = (Const *)a, *cb = (Const *)b;
+		if (ca->getType() != cb->getType()) return false;
+		if (op == opStrConst) return ca->getStr() == cb->getStr();
+		if (op == opFltConst) {
+			double da = ca->getFlt(), db = cb->getFlt();
+			return memcmp(&da, &db, sizeof(double)) == 0;  // Keep -0.0 and 0.0 apart
+		}
+		return ca->getInt() == cb->getInt();
+	}
+	switch (op) {
+	case opSubscript:
+		return ((RefExp *)a)->getDef() == ((RefExp *)b)->getDef();
+	case opTypedExp:
+		return *((TypedExp *)a)->getType() == *((TypedExp *)b)->getType();
+	case opTypeVal:
+		return *((TypeVal *)a)->getType() == *((TypeVal *)b)->getType();
+	default:
+		break;
+	}
+	if (a->isLocation())
+		return ((Location *)a)->getProc() == ((Location *)b)->getProc();
+	return true;
+}
+
+void ExpFactory::grow()
+{
+	std::vector<std::vector<Exp *> > old;
+	old.swap(buckets);
+	buckets.resize(old.size() * 2);
+	for (std::vector<std::vector<Exp *> >::iterator bb = old.begin(); bb != old.end(); bb++)
+		for (std::vector<Exp *>::iterator it = bb->begin(); it != bb->end(); it++)
+			buckets[(*it)->hashVal % buckets.size()].push_back(*it);
+}
+
+void ExpFactory::clear()
+{
+	buckets.clear();
+	buckets.resize(EXPFACTORY_INIT_BUCKETS);
+	count = 0;
+}
+
 //  //  //  //  //  //
 //  genConstraints  //
 //  //  //  //  //  //
@@ -3723,12 +4131,14 @@ const char *Const::getFuncName()
 
 Exp *Unary::simplifyConstraint()
 {
+	canonical = false;
 	subExp1 = subExp1->simplifyConstraint();
 	return this;
 }
 
 Exp *Binary::simplifyConstraint()
 {
+	canonical = false;
 	assert(subExp1 && subExp2);
 
 	subExp1 = subExp1->simplifyConstraint();
@@ -3865,6 +4275,8 @@ Exp *Exp::stripSizes()
 
 Exp *Unary::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);  // Copy on write
+	canonical = false;  // The modifier may change this node in place
 	// This Unary will be changed in *either* the pre or the post visit. If it's changed in the preVisit step, then
 	// postVisit doesn't care about the type of ret. So let's call it a Unary, and the type system is happy
 	bool recur;
@@ -3874,6 +4286,8 @@ Exp *Unary::accept(ExpModifier *v)
 }
 Exp *Binary::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);
+	canonical = false;
 	assert(subExp1 && subExp2);
 
 	bool recur;
@@ -3884,6 +4298,8 @@ Exp *Binary::accept(ExpModifier *v)
 }
 Exp *Ternary::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);
+	canonical = false;
 	bool recur;
 	Ternary *ret = (Ternary *)v->preVisit(this, recur);
 	if (recur) subExp1 = subExp1->accept(v);
@@ -3893,6 +4309,8 @@ Exp *Ternary::accept(ExpModifier *v)
 }
 Exp *Location::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);
+	canonical = false;
 	// This looks to be the same source code as Unary::accept, but the type of "this" is different, which is all
 	// important here!  (it makes a call to a different visitor member function).
 	bool recur;
@@ -3902,6 +4320,8 @@ Exp *Location::accept(ExpModifier *v)
 }
 Exp *RefExp::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);
+	canonical = false;
 	bool recur;
 	RefExp *ret = (RefExp *)v->preVisit(this, recur);
 	if (recur) subExp1 = subExp1->accept(v);
@@ -3909,6 +4329,8 @@ Exp *RefExp::accept(ExpModifier *v)
 }
 Exp *FlagDef::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);
+	canonical = false;
 	bool recur;
 	FlagDef *ret = (FlagDef *)v->preVisit(this, recur);
 	if (recur) subExp1 = subExp1->accept(v);
@@ -3916,6 +4338,8 @@ Exp *FlagDef::accept(ExpModifier *v)
 }
 Exp *TypedExp::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);
+	canonical = false;
 	bool recur;
 	TypedExp *ret = (TypedExp *)v->preVisit(this, recur);
 	if (recur) subExp1 = subExp1->accept(v);
@@ -3923,15 +4347,21 @@ Exp *TypedExp::accept(ExpModifier *v)
 }
 Exp *Terminal::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);
+	canonical = false;
 	// This is important if we need to modify terminals
 	return v->postVisit((Terminal *)v->preVisit(this));
 }
 Exp *Const::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);
+	canonical = false;
 	return v->postVisit((Const *)v->preVisit(this));
 }
 Exp *TypeVal::accept(ExpModifier *v)
 {
+	if (interned) return clone()->accept(v);
+	canonical = false;
 	return v->postVisit((TypeVal *)v->preVisit(this));
 }
 
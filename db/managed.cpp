@@ -19,9 +19,11 @@
 #include "boomerang.h"
 #include "proc.h"
 
+#include <algorithm>  // For std::find
 #include <sstream>
 
 #include <cstring>
+#include <cassert>
 
 extern char debug_buffer[];  // For prints functions
 
@@ -973,20 +975,38 @@ bool RangeMap::isSubset(RangeMap &other)
 
 // class ConnectionGraph
 
-void ConnectionGraph::add(Exp *a, Exp *b)
+void ConnectionGraph::iterator::settle()
 {
-	iterator ff = emap.find(a);
-	while (ff != emap.end() && *ff->first == *a) {
-		if (*ff->second == *b) return;  // Don't add a second entry
-		++ff;
+	while (key != g->nodeNums.end() && i >= g->adj[key->second].size()) {
+		++key;
+		i = 0;
 	}
-	std::pair<Exp *, Exp *> pr;
-	pr.first = a;
-	pr.second = b;
-	emap.insert(pr);
+	if (key != g->nodeNums.end()) {
+		pr.first = g->nodes[key->second];
+		pr.second = g->nodes[g->adj[key->second][i]];
+	}
+}
+
+int ConnectionGraph::node(Exp *e)
+{
+	std::map<Exp *, int, lessExpStar>::iterator ff = nodeNums.find(e);
+	if (ff != nodeNums.end())
+		return ff->second;
+	int n = nodes.size();
+	nodeNums[e] = n;
+	nodes.push_back(e);
+	adj.resize(n + 1);
+	return n;
 }
 
-void ConnectionGraph::connect(Exp *a, Exp *b)
+void ConnectionGraph::add(int a, int b)
+{
+	std::vector<int> &l = adj[a];
+	if (std::find(l.begin(), l.end(), b) != l.end()) return;  // Don't add a second entry
+	l.push_back(b);
+}
+
+void ConnectionGraph::connect(int a, int b)
 {
 	add(a, b);
 	add(b, a);
@@ -994,61 +1014,63 @@ void ConnectionGraph::connect(Exp *a, Exp *b)
 
 int ConnectionGraph::count(Exp *e)
 {
-	iterator ff = emap.find(e);
-	int n = 0;
-	while (ff != emap.end() && *ff->first == *e) {
-		++n;
-		++ff;
-	}
-	return n;
+	std::map<Exp *, int, lessExpStar>::iterator ff = nodeNums.find(e);
+	if (ff == nodeNums.end())
+		return 0;
+	return adj[ff->second].size();
 }
 
 bool ConnectionGraph::isConnected(Exp *a, Exp *b)
 {
-	iterator ff = emap.find(a);
-	while (ff != emap.end() && *ff->first == *a) {
-		if (*ff->second == *b)
-			return true;  // Found the connection
-		++ff;
-	}
-	return false;
+	std::map<Exp *, int, lessExpStar>::iterator fa = nodeNums.find(a);
+	std::map<Exp *, int, lessExpStar>::iterator fb = nodeNums.find(b);
+	if (fa == nodeNums.end() || fb == nodeNums.end())
+		return false;
+	std::vector<int> &l = adj[fa->second];
+	return std::find(l.begin(), l.end(), fb->second) != l.end();
 }
 
 // Modify the map so that a <-> b becomes a <-> c
 void ConnectionGraph::update(Exp *a, Exp *b, Exp *c)
 {
+	std::map<Exp *, int, lessExpStar>::iterator fa = nodeNums.find(a);
+	std::map<Exp *, int, lessExpStar>::iterator fb = nodeNums.find(b);
+	if (fa == nodeNums.end() || fb == nodeNums.end())
+		return;
+	int na = fa->second, nb = fb->second;
+	int nc = node(c);  // Before taking references into adj
 	// find a->b
-	iterator ff = emap.find(a);
-	while (ff != emap.end() && *ff->first == *a) {
-		if (*ff->second == *b) {
-			ff->second = c;  // Now a->c
-			break;
-		}
-		++ff;
+	std::vector<int> &la = adj[na];
+	std::vector<int>::iterator ff = std::find(la.begin(), la.end(), nb);
+	if (ff != la.end()) {
+		if (std::find(la.begin(), la.end(), nc) == la.end())
+			*ff = nc;  // Now a->c
+		else
+			la.erase(ff);
 	}
 	// find b -> a
-	ff = emap.find(b);
-	while (ff != emap.end() && *ff->first == *b) {
-		if (*ff->second == *a) {
-			emap.erase(ff);
-			add(c, a);  // Now c->a
-			break;
-		}
-		++ff;
+	std::vector<int> &lb = adj[nb];
+	ff = std::find(lb.begin(), lb.end(), na);
+	if (ff != lb.end()) {
+		lb.erase(ff);
+		add(nc, na);  // Now c->a
 	}
 }
 
 // Remove the mapping at *aa, and return a valid iterator for looping
 ConnectionGraph::iterator ConnectionGraph::remove(iterator aa)
 {
-	assert(aa != emap.end());
-	Exp *b = aa->second;
-	emap.erase(aa++);
-	iterator bb = emap.find(b);
-	assert(bb != emap.end());
-	if (bb == aa)
-		++aa;
-	emap.erase(bb);
+	assert(aa != end());
+	int a = aa.key->second;
+	int b = adj[a][aa.i];
+	adj[a].erase(adj[a].begin() + aa.i);
+	if (b != a) {
+		std::vector<int> &lb = adj[b];
+		std::vector<int>::iterator bb = std::find(lb.begin(), lb.end(), a);
+		assert(bb != lb.end());
+		lb.erase(bb);
+	}
+	aa.settle();  // aa.i now indexes the connection after the removed one
 	return aa;
 }
 
@@ -37,6 +37,7 @@
 #include "constraint.h"
 #include "visitor.h"
 #include "log.h"
+#include "proccache.h"
 
 #include <algorithm>  // For find()
 #include <iomanip>    // For std::setw etc
@@ -44,8 +45,6 @@
 
 #include <cstring>
 
-typedef std::map<Statement *, int> RefCounter;
-
 extern char debug_buffer[];  // Defined in basicblock.cpp, size DEBUG_BUFSIZE
 
 /************************
@@ -92,6 +91,19 @@ void Proc::setName(const char *nam)
 {
 	assert(signature);
 	signature->setName(nam);
+	if (prog) prog->procNamesChanged();
+}
+
+/*==============================================================================
+ * FUNCTION:        Proc::setSignature
+ * OVERVIEW:        Replaces the signature of this procedure, which may also change its name
+ * PARAMETERS:      sig: the new signature
+ * RETURNS:         <nothing>
+ *============================================================================*/
+void Proc::setSignature(Signature *sig)
+{
+	signature = sig;
+	if (prog) prog->procNamesChanged();
 }
 
 /*==============================================================================
@@ -189,6 +201,7 @@ void UserProc::renameLocal(const char *oldName, const char *newName)
 	mapSymbolToRepl(oldExp, oldLoc, newLoc);
 	locals[strdup(newName)] = ty;
 	cfg->searchAndReplace(oldLoc, newLoc);
+	defUses.invalidate();  // The uses are now of the new local
 }
 
 bool UserProc::searchAll(Exp *search, std::list<Exp *> &result)
@@ -415,6 +428,7 @@ UserProc::UserProc() : Proc(), cfg(NULL), status(PROC_UNDECODED),
 	cycleGrp(NULL), theReturnStatement(NULL)
 {
 	localTable.setProc(this);
+	defUses.setProc(this);
 }
 
 UserProc::UserProc(Prog *prog, std::string &name, ADDRESS uNative) :
@@ -427,6 +441,7 @@ UserProc::UserProc(Prog *prog, std::string &name, ADDRESS uNative) :
 {
 	cfg->setProc(this);  // Initialise cfg.myProc
 	localTable.setProc(this);
+	defUses.setProc(this);
 }
 
 UserProc::~UserProc()
@@ -609,6 +624,7 @@ void UserProc::addCallee(Proc *callee)
 
 void UserProc::generateCode(HLLCode *hll)
 {
+	PhaseAlert phase(this, "generateCode");
 	assert(cfg);
 	assert(getEntryBB());
 
@@ -684,6 +700,8 @@ void UserProc::print(std::ostream &out, bool html)
 void UserProc::setStatus(ProcStatus s)
 {
 	status = s;
+	if (s == PROC_FINAL)
+		df.releaseWorkingSets();  // Don't keep dominator and phi placement scratch data for the rest of the run
 	Boomerang::get()->alert_proc_status_change(this);
 }
 
@@ -827,6 +845,8 @@ void UserProc::getStatements(StatementList &stmts)
 // Should use iterators or other context to find out how to erase "in place" (without having to linearly search)
 void UserProc::removeStatement(Statement *stmt)
 {
+	defUses.remove(stmt);
+
 	// remove anything proven about this statement
 	for (std::map<Exp *, Exp *, lessExpStar>::iterator it = provenTrue.begin(); it != provenTrue.end(); ) {
 		LocationSet refs;
@@ -888,6 +908,7 @@ void UserProc::insertAssignAfter(Statement *s, Exp *left, Exp *right)
 	Assign *as = new Assign(left, right);
 	as->setProc(this);
 	stmts->insert(it, as);
+	defUses.markDirty(as);
 	return;
 }
 
@@ -908,6 +929,7 @@ void UserProc::insertStatementAfter(Statement *s, Statement *a)
 				if (*ss == s) {
 					ss++;  // This is the point to insert before
 					stmts.insert(ss, a);
+					defUses.markDirty(a);
 					return;
 				}
 			}
@@ -968,6 +990,7 @@ void UserProc::insertStatementAfter(Statement *s, Statement *a)
 // Decompile this UserProc
 ProcSet *UserProc::decompile(ProcList *path, int &indent)
 {
+	PhaseAlert phase(this, "decompile");
 	Boomerang::get()->alert_considering(path->empty() ? NULL : path->back(), this);
 	std::cout << std::setw(++indent) << " " << (status >= PROC_VISITED ? "re" : "") << "considering " << getName() << "\n";
 	if (VERBOSE)
@@ -1076,22 +1099,33 @@ ProcSet *UserProc::decompile(ProcList *path, int &indent)
 
 
 	// if child is empty, i.e. no child involved in recursion
+	ProcCache *cache = Boomerang::get()->procCache;
+	bool cached = false;
 	if (child->size() == 0) {
-		Boomerang::get()->alert_decompiling(this);
-		std::cout << std::setw(indent) << " " << "decompiling " << getName() << "\n";
-		initialiseDecompile();  // Sort the CFG, number statements, etc
-		earlyDecompile();
-		child = middleDecompile(path, indent);
-		// If there is a switch statement, middleDecompile could contribute some cycles. If so, we need to test for
-		// the recursion logic again
-		if (child->size() != 0)
-			// We've just come back out of decompile(), so we've lost the current proc from the path.
-			path->push_back(this);
+		if (cache && cache->load(this)) {
+			// Neither this proc nor its callees have changed since it was saved
+			std::cout << std::setw(indent) << " " << "reusing " << getName() << " from the cache\n";
+			cached = true;
+		} else {
+			Boomerang::get()->alert_decompiling(this);
+			std::cout << std::setw(indent) << " " << "decompiling " << getName() << "\n";
+			initialiseDecompile();  // Sort the CFG, number statements, etc
+			earlyDecompile();
+			child = middleDecompile(path, indent);
+			// If there is a switch statement, middleDecompile could contribute some cycles. If so, we need to test
+			// for the recursion logic again
+			if (child->size() != 0)
+				// We've just come back out of decompile(), so we've lost the current proc from the path.
+				path->push_back(this);
+		}
 	}
 	if (child->size() == 0) {
-		remUnusedStmtEtc();  // Do the whole works
+		if (!cached)
+			remUnusedStmtEtc();  // Do the whole works
 		setStatus(PROC_FINAL);
 		Boomerang::get()->alert_end_decompile(this);
+		if (cache && !cached)
+			cache->save(this);
 	} else {
 		// this proc's children, and hence this proc, is/are involved in recursion
 		// find first element f in path that is also in cycleGrp
@@ -1131,6 +1165,7 @@ ProcSet *UserProc::decompile(ProcList *path, int &indent)
 
 void UserProc::initialiseDecompile()
 {
+	PhaseAlert phase(this, "initialiseDecompile");
 	Boomerang::get()->alert_start_decompile(this);
 
 	Boomerang::get()->alert_decompile_debug_point(this, "before initialise");
@@ -1176,6 +1211,7 @@ void UserProc::initialiseDecompile()
 // Can merge these two now
 void UserProc::earlyDecompile()
 {
+	PhaseAlert phase(this, "earlyDecompile");
 	if (status >= PROC_EARLYDONE)
 		return;
 
@@ -1226,6 +1262,7 @@ void UserProc::earlyDecompile()
 
 ProcSet *UserProc::middleDecompile(ProcList *path, int indent)
 {
+	PhaseAlert phase(this, "middleDecompile");
 	Boomerang::get()->alert_decompile_debug_point(this, "before middle");
 
 	// The call bypass logic should be staged as well. For example, consider m[r1{11}]{11} where 11 is a call.
@@ -1505,6 +1542,7 @@ ProcSet *UserProc::middleDecompile(ProcList *path, int indent)
 
 void UserProc::remUnusedStmtEtc()
 {
+	PhaseAlert phase(this, "remUnusedStmtEtc");
 	// NO! Removing of unused statements is an important part of the global removing unused returns analysis, which
 	// happens after UserProc::decompile is complete
 #if 0
@@ -1610,77 +1648,58 @@ void UserProc::remUnusedStmtEtc()
 
 void UserProc::remUnusedStmtEtc(RefCounter &refCounts)
 {
+	PhaseAlert phase(this, "removeUnusedStatements");
 	Boomerang::get()->alert_decompile_debug_point(this, "before remUnusedStmtEtc");
 
+	// Start with the statements that nothing uses. Removing one decrements the counts of the definitions it uses, and
+	// those that get to zero are then considered in turn, so no statement is looked at more than twice
 	StatementList stmts;
 	getStatements(stmts);
-	bool change;
-	do {  // FIXME: check if this is ever needed
-		change = false;
-		StatementList::iterator ll = stmts.begin();
-		while (ll != stmts.end()) {
-			Statement *s = *ll;
-			if (!s->isAssignment()) {
-				// Never delete a statement other than an assignment (e.g. nothing "uses" a Jcond)
-				ll++;
-				continue;
-			}
-			Assignment *as = (Assignment *)s;
-			Exp *asLeft = as->getLeft();
-			// If depth < 0, consider all depths
-#if 0
-			if (asLeft && depth >= 0 && asLeft->getMemDepth() > depth) {
-				ll++;
-				continue;
-			}
-#endif
-			if (asLeft && asLeft->getOper() == opGlobal) {
-				// assignments to globals must always be kept
-				ll++;
-				continue;
-			}
-			// If it's a memof and renameable it can still be deleted
-			if (asLeft->getOper() == opMemOf && !canRename(asLeft)) {
-				// Assignments to memof-anything-but-local must always be kept.
-				ll++;
-				continue;
-			}
-			if (asLeft->getOper() == opMemberAccess || asLeft->getOper() == opArrayIndex) {
-				// can't say with these; conservatively never remove them
-				ll++;
-				continue;
-			}
-			if (refCounts.find(s) == refCounts.end() || refCounts[s] == 0) {  // Care not to insert unnecessarily
-				// First adjust the counts, due to statements only referenced by statements that are themselves unused.
-				// Need to be careful not to count two refs to the same def as two; refCounts is a count of the number
-				// of statements that use a definition, not the total number of refs
-				StatementSet stmtsRefdByUnused;
-				LocationSet components;
-				s->addUsedLocs(components, false);  // Second parameter false to ignore uses in collectors
-				LocationSet::iterator cc;
-				for (cc = components.begin(); cc != components.end(); cc++) {
-					if ((*cc)->isSubscript()) {
-						stmtsRefdByUnused.insert(((RefExp *)*cc)->getDef());
-					}
-				}
-				StatementSet::iterator dd;
-				for (dd = stmtsRefdByUnused.begin(); dd != stmtsRefdByUnused.end(); dd++) {
-					if (*dd == NULL) continue;
-					if (DEBUG_UNUSED)
-						LOG << "decrementing ref count of " << (*dd)->getNumber()
-						    << " because " << s->getNumber() << " is unused\n";
-					refCounts[*dd]--;
-				}
-				if (DEBUG_UNUSED)
-					LOG << "removing unused statement " << s->getNumber() << " " << s << "\n";
-				removeStatement(s);
-				ll = stmts.erase(ll);  // So we don't try to re-remove it
-				change = true;
-				continue;  // Don't call getNext this time
-			}
-			ll++;
+	std::list<Statement *> workList;
+	StatementList::iterator ll;
+	for (ll = stmts.begin(); ll != stmts.end(); ll++)
+		if (refCounts[*ll] == 0)
+			workList.push_back(*ll);
+	while (!workList.empty()) {
+		Statement *s = workList.front();
+		workList.pop_front();
+		if (!s->isAssignment()) {
+			// Never delete a statement other than an assignment (e.g. nothing "uses" a Jcond)
+			continue;
+		}
+		Assignment *as = (Assignment *)s;
+		Exp *asLeft = as->getLeft();
+		if (asLeft && asLeft->getOper() == opGlobal) {
+			// assignments to globals must always be kept
+			continue;
+		}
+		// If it's a memof and renameable it can still be deleted
+		if (asLeft->getOper() == opMemOf && !canRename(asLeft)) {
+			// Assignments to memof-anything-but-local must always be kept.
+			continue;
+		}
+		if (asLeft->getOper() == opMemberAccess || asLeft->getOper() == opArrayIndex) {
+			// can't say with these; conservatively never remove them
+			continue;
+		}
+		// First adjust the counts, due to statements only referenced by statements that are themselves unused.
+		// Need to be careful not to count two refs to the same def as two; refCounts is a count of the number
+		// of statements that use a definition, not the total number of refs
+		std::vector<Statement *> stmtsRefdByUnused;
+		defUses.getDefsUsedBy(s, stmtsRefdByUnused);  // Each once, and not the uses in collectors
+		std::vector<Statement *>::iterator dd;
+		for (dd = stmtsRefdByUnused.begin(); dd != stmtsRefdByUnused.end(); dd++) {
+			if (*dd == NULL) continue;
+			if (DEBUG_UNUSED)
+				LOG << "decrementing ref count of " << (*dd)->getNumber()
+				    << " because " << s->getNumber() << " is unused\n";
+			if (--refCounts[*dd] == 0 && *dd != s && refCounts.inProc(*dd))
+				workList.push_back(*dd);  // Now unused as well
 		}
-	} while (change);
+		if (DEBUG_UNUSED)
+			LOG << "removing unused statement " << s->getNumber() << " " << s << "\n";
+		removeStatement(s);
+	}
 	// Recaluclate at least the livenesses. Example: first call to printf in test/pentium/fromssa2, eax used only in a
 	// removed statement, so liveness in the call needs to be removed
 	removeCallLiveness();   // Kill all existing livenesses
@@ -1692,6 +1711,7 @@ void UserProc::remUnusedStmtEtc(RefCounter &refCounts)
 
 void UserProc::recursionGroupAnalysis(ProcList *path, int indent)
 {
+	PhaseAlert phase(this, "recursionGroupAnalysis");
 	/* Overall algorithm:
 		for each proc in the group
 			initialise
@@ -1773,6 +1793,8 @@ void UserProc::updateCalls()
 
 void UserProc::branchAnalysis()
 {
+	PhaseAlert phase(this, "branchAnalysis");
+	defUses.invalidate();
 	Boomerang::get()->alert_decompile_debug_point(this, "before branch analysis.");
 
 	StatementList stmts;
@@ -1838,6 +1860,8 @@ void UserProc::branchAnalysis()
 
 void UserProc::fixUglyBranches()
 {
+	PhaseAlert phase(this, "fixUglyBranches");
+	defUses.invalidate();
 	if (VERBOSE)
 		LOG << "### fixUglyBranches for " << getName() << " ###\n";
 
@@ -1880,6 +1904,7 @@ void UserProc::fixUglyBranches()
 
 bool UserProc::doRenameBlockVars(int pass, bool clearStacks)
 {
+	PhaseAlert phase(this, "doRenameBlockVars");
 	if (VERBOSE)
 		LOG << "### rename block vars for " << getName() << " pass " << pass << ", clear = " << clearStacks << " ###\n";
 	bool b = df.renameBlockVars(this, 0, clearStacks);
@@ -1890,6 +1915,7 @@ bool UserProc::doRenameBlockVars(int pass, bool clearStacks)
 
 void UserProc::findSpPreservation()
 {
+	PhaseAlert phase(this, "findSpPreservation");
 	if (VERBOSE)
 		LOG << "finding stack pointer preservation for " << getName() << "\n";
 
@@ -1922,6 +1948,7 @@ void UserProc::findSpPreservation()
 
 void UserProc::findPreserveds()
 {
+	PhaseAlert phase(this, "findPreserveds");
 	std::set<Exp *> removes;
 
 	if (VERBOSE)
@@ -2148,6 +2175,7 @@ static RefExp *regOfWild = new RefExp(Location::regOf(new Terminal(opWildIntCons
 #define DEBUG_PARAMS 1
 void UserProc::findFinalParameters()
 {
+	PhaseAlert phase(this, "findFinalParameters");
 	Boomerang::get()->alert_decompile_debug_point(this, "before find final parameters.");
 
 	parameters.clear();
@@ -2525,6 +2553,8 @@ Exp *UserProc::getSymbolExp(Exp *le, Type *ty, bool lastPass)
 // Not used with DFA Type Analysis; the equivalent thing happens in mapLocalsAndParams() now
 void UserProc::mapExpressionsToLocals(bool lastPass)
 {
+	PhaseAlert phase(this, "mapExpressionsToLocals");
+	defUses.invalidate();
 	StatementList stmts;
 	getStatements(stmts);
 
@@ -2634,7 +2664,8 @@ void UserProc::mapExpressionsToLocals(bool lastPass)
 			                                          result->getSubExp1()->getSubExp1()->getSubExp2()->clone()), this);
 			if (VERBOSE)
 				LOG << "replacing " << result << " with " << replace << " in " << s << "\n";
-			s->searchAndReplace(result->clone(), replace);
+			if (s->searchAndReplace(result->clone(), replace))
+				s->usesChanged();
 		}
 	}
 
@@ -2709,6 +2740,7 @@ bool UserProc::removeNullStatements()
 // Return true if change; set convert if an indirect call is converted to direct (else clear)
 bool UserProc::propagateStatements(bool &convert, int pass)
 {
+	PhaseAlert phase(this, "propagateStatements");
 	if (VERBOSE)
 		LOG << "--- begin propagating statements pass " << pass << " ---\n";
 	StatementList stmts;
@@ -2772,6 +2804,7 @@ Statement *UserProc::getStmtAtLex(unsigned int begin, unsigned int end)
 
 void UserProc::promoteSignature()
 {
+	PhaseAlert phase(this, "promoteSignature");
 	signature = signature->promote(this);
 }
 
@@ -2934,43 +2967,56 @@ void UserProc::countRefs(RefCounter &refCounts)
 	StatementList stmts;
 	getStatements(stmts);
 	StatementList::iterator it;
-	for (it = stmts.begin(); it != stmts.end(); it++) {
-		Statement *s = *it;
-		// Don't count uses in implicit statements. There is no RHS of course, but you can still have x from m[x] on the
-		// LHS and so on, and these are not real uses
-		if (s->isImplicit()) continue;
-		if (DEBUG_UNUSED)
-			LOG << "counting references in " << s << "\n";
-		LocationSet refs;
-		s->addUsedLocs(refs, false);  // Ignore uses in collectors
-		LocationSet::iterator rr;
-		for (rr = refs.begin(); rr != refs.end(); rr++) {
-			if (((Exp *)*rr)->isSubscript()) {
-				Statement *def = ((RefExp *)*rr)->getDef();
-				// Used to not count implicit refs here (def->getNumber() == 0), meaning that implicit definitions get
-				// removed as dead code! But these are the ideal place to read off final parameters, and it is
-				// guaranteed now that implicit statements are sorted out for us by now (for dfa type analysis)
-				if (def /* && def->getNumber() */) {
-					refCounts[def]++;
-					if (DEBUG_UNUSED)
-						LOG << "counted ref to " << *rr << "\n";
-				}
-			}
+	// Give the statements of this proc their entries first
+	for (it = stmts.begin(); it != stmts.end(); it++)
+		refCounts.addStmt(*it);
+	defUses.refresh();
+	DefUseIndex::iterator dd;
+	for (dd = defUses.begin(); dd != defUses.end(); ++dd) {
+		Statement *def = dd->first;
+		// Used to not count implicit refs here (def->getNumber() == 0), meaning that implicit definitions get
+		// removed as dead code! But these are the ideal place to read off final parameters, and it is
+		// guaranteed now that implicit statements are sorted out for us by now (for dfa type analysis)
+		if (def == NULL /* || def->getNumber() == 0 */) continue;
+		DefUseIndex::UseList::iterator uu;
+		for (uu = dd->second.begin(); uu != dd->second.end(); ++uu) {
+			// Don't count uses in implicit statements. There is no RHS of course, but you can still have x from m[x]
+			// on the LHS and so on, and these are not real uses
+			if (uu->user->isImplicit() || !refCounts.inProc(uu->user)) continue;
+			refCounts[def]++;
+			if (DEBUG_UNUSED)
+				LOG << "counted ref to " << uu->ref << " in " << uu->user->getNumber() << "\n";
 		}
 	}
 	if (DEBUG_UNUSED) {
-		RefCounter::iterator rr;
 		LOG << "### reference counts for " << getName() << ":\n";
-		for (rr = refCounts.begin(); rr != refCounts.end(); ++rr)
-			LOG << "  " << rr->first->getNumber() << ":" << rr->second << "\t";
+		for (it = stmts.begin(); it != stmts.end(); it++)
+			if (refCounts[*it])
+				LOG << "  " << (*it)->getNumber() << ":" << refCounts[*it] << "\t";
 		LOG << "\n### end reference counts\n";
 	}
 }
 
+UserProc::RefCounter::Entry &UserProc::RefCounter::entry(Statement *s)
+{
+	int n = s->getNumber();
+	if (n > 0) {
+		if (n >= (int)numbered.size())
+			numbered.resize(n + 1);
+		Entry &e = numbered[n];
+		if (e.stmt == NULL)
+			e.stmt = s;  // First statement seen with this number
+		if (e.stmt == s)
+			return e;
+	}
+	return unnumbered[s];
+}
+
 // Note: call the below after translating from SSA form
 // FIXME: this can be done before transforming out of SSA form now, surely...
 void UserProc::removeUnusedLocals()
 {
+	PhaseAlert phase(this, "removeUnusedLocals");
 	Boomerang::get()->alert_decompile_debug_point(this, "before removing unused locals");
 	if (VERBOSE)
 		LOG << "removing unused locals (final) for " << getName() << "\n";
@@ -3072,6 +3118,8 @@ void UserProc::removeUnusedLocals()
 
 void UserProc::fromSSAform()
 {
+	PhaseAlert phase(this, "fromSSAform");
+	defUses.invalidate();
 	Boomerang::get()->alert_decompiling(this);
 
 	if (VERBOSE)
@@ -3363,6 +3411,9 @@ void UserProc::fromSSAform()
 	if (cfg->getNumBBs() >= 100)  // Only for the larger procs
 		std::cout << "\n";
 
+	// Out of SSA form now, so the dataflow tables (and the expressions they hold) are garbage
+	df.releaseAll();
+
 	Boomerang::get()->alert_decompile_debug_point(this, "after transforming from SSA form");
 }
 
@@ -3788,6 +3839,7 @@ void UserProc::addCallees(std::list<UserProc *> &callees)
 
 void UserProc::conTypeAnalysis()
 {
+	defUses.invalidate();
 	if (DEBUG_TA)
 		LOG << "type analysis for procedure " << getName() << "\n";
 	Constraints consObj;
@@ -3895,6 +3947,8 @@ bool UserProc::searchAndReplace(Exp *search, Exp *replace)
 		Statement *s = *it;
 		ch |= s->searchAndReplace(search, replace);
 	}
+	if (ch)
+		defUses.invalidate();
 	return ch;
 }
 
@@ -4128,6 +4182,7 @@ void UserProc::dumpLocals()
 
 void UserProc::updateArguments()
 {
+	PhaseAlert phase(this, "updateArguments");
 	Boomerang::get()->alert_decompiling(this);
 	if (VERBOSE)
 		LOG << "### update arguments for " << getName() << " ###\n";
@@ -4154,6 +4209,7 @@ void UserProc::updateArguments()
 
 void UserProc::updateCallDefines()
 {
+	PhaseAlert phase(this, "updateCallDefines");
 	if (VERBOSE)
 		LOG << "### update call defines for " << getName() << " ###\n";
 	StatementList stmts;
@@ -4168,6 +4224,7 @@ void UserProc::updateCallDefines()
 
 void UserProc::reverseStrengthReduction()
 {
+	PhaseAlert phase(this, "reverseStrengthReduction");
 	Boomerang::get()->alert_decompile_debug_point(this, "before reversing strength reduction");
 
 	StatementList stmts;
@@ -4205,8 +4262,8 @@ void UserProc::reverseStrengthReduction()
 							getStatements(stmts2);
 							StatementList::iterator it2;
 							for (it2 = stmts2.begin(); it2 != stmts2.end(); it2++)
-								if (*it2 != as)
-									(*it2)->searchAndReplace(r, new Binary(opMult, r->clone(), new Const(c)));
+								if (*it2 != as && (*it2)->searchAndReplace(r, new Binary(opMult, r->clone(), new Const(c))))
+									(*it2)->usesChanged();
 							// that done we can replace c with 1 in as
 							((Const *)as->getRight()->getSubExp2())->setInt(1);
 						}
@@ -4384,6 +4441,8 @@ const char *UserProc::findFirstSymbol(Exp *e)
 
 void UserProc::fixCallAndPhiRefs()
 {
+	PhaseAlert phase(this, "fixCallAndPhiRefs");
+	defUses.invalidate();
 	if (VERBOSE)
 		LOG << "### start fix call and phi bypass analysis for " << getName() << " ###\n";
 
@@ -4716,28 +4775,12 @@ bool UserProc::doesParamChainToCall(Exp *param, UserProc *p, ProcSet *visited)
 
 bool UserProc::isRetNonFakeUsed(CallStatement *c, Exp *retLoc, UserProc *p, ProcSet *visited)
 {
-	// Ick! This algorithm has to search every statement for uses of the return location retLoc defined at call c that
-	// are not arguments of calls to p. If we had def-use information, it would be much more efficient
-	StatementList stmts;
-	getStatements(stmts);
-	StatementList::iterator it;
+	// Look at the uses of the return location retLoc defined at call c, for any that are not arguments of calls to p
+	std::vector<Statement *> stmts;
+	defUses.getUsers(c, retLoc, stmts);
+	std::vector<Statement *>::iterator it;
 	for (it = stmts.begin(); it != stmts.end(); it++) {
 		Statement *s = *it;
-		LocationSet ls;
-		LocationSet::iterator ll;
-		s->addUsedLocs(ls);
-		bool found = false;
-		for (ll = ls.begin(); ll != ls.end(); ++ll) {
-			if (!(*ll)->isSubscript()) continue;
-			Statement *def = ((RefExp *)*ll)->getDef();
-			if (def != c) continue;  // Not defined at c, ignore
-			Exp *base = ((RefExp *)*ll)->getSubExp1();
-			if (!(*base == *retLoc)) continue;  // Defined at c, but not the right location
-			found = true;
-			break;
-		}
-		if (!found)
-			continue;
 		if (!s->isCall())
 			// This non-call uses the return; return true as it is non-fake used
 			return true;
@@ -4771,10 +4814,13 @@ bool UserProc::isRetNonFakeUsed(CallStatement *c, Exp *retLoc, UserProc *p, Proc
 bool UserProc::checkForGainfulUse(Exp *bparam, ProcSet &visited)
 {
 	visited.insert(this);  // Prevent infinite recursion
-	StatementList::iterator pp;
-	StatementList stmts;
-	getStatements(stmts);
-	StatementList::iterator it;
+	// Only the statements that use bparam{-} or bparam{0} could use it gainfully
+	std::vector<Statement *> stmts;
+	defUses.getUsers(NULL, bparam, stmts);
+	Statement *imp = cfg->findTheImplicitAssign(bparam);
+	if (imp)
+		defUses.getUsers(imp, bparam, stmts);
+	std::vector<Statement *>::iterator it;
 	for (it = stmts.begin(); it != stmts.end(); it++) {
 		Statement *s = *it;
 		// Special checking for recursive calls
@@ -4839,6 +4885,7 @@ bool UserProc::checkForGainfulUse(Exp *bparam, ProcSet &visited)
 // See comments three procedures above
 bool UserProc::removeRedundantParameters()
 {
+	PhaseAlert phase(this, "removeRedundantParameters");
 	if (signature->isForced())
 		// Assume that no extra parameters would have been inserted... not sure always valid
 		return false;
@@ -4850,7 +4897,6 @@ bool UserProc::removeRedundantParameters()
 
 	if (DEBUG_UNUSED)
 		LOG << "%%% removing unused parameters for " << getName() << "\n";
-	// Note: this would be far more efficient if we had def-use information
 	StatementList::iterator pp;
 	for (pp = parameters.begin(); pp != parameters.end(); ++pp) {
 		Exp *param = ((Assign *)*pp)->getLeft();
@@ -4905,6 +4951,7 @@ bool UserProc::removeRedundantParameters()
 // Return true if any change
 bool UserProc::removeRedundantReturns(std::set<UserProc *> &removeRetSet)
 {
+	PhaseAlert phase(this, "removeRedundantReturns");
 	Boomerang::get()->alert_decompiling(this);
 	Boomerang::get()->alert_decompile_debug_point(this, "before removing unused returns");
 	// First remove the unused parameters
@@ -5103,6 +5150,8 @@ void UserProc::clearUses()
 
 void UserProc::typeAnalysis()
 {
+	PhaseAlert phase(this, "typeAnalysis");
+	defUses.invalidate();
 	if (VERBOSE)
 		LOG << "### type analysis for " << getName() << " ###\n";
 
@@ -5155,6 +5204,7 @@ void UserProc::clearRanges()
 
 void UserProc::rangeAnalysis()
 {
+	defUses.invalidate();
 	std::cout << "performing range analysis on " << getName() << "\n";
 
 	// this helps
@@ -5343,6 +5393,7 @@ void UserProc::setImplicitRef(Statement *s, Exp *a, Type *ty)
 
 void UserProc::eliminateDuplicateArgs()
 {
+	PhaseAlert phase(this, "eliminateDuplicateArgs");
 	if (VERBOSE)
 		LOG << "### eliminate duplicate args for " << getName() << " ###\n";
 	BB_IT it;
@@ -5409,6 +5460,26 @@ void Proc::setProvenTrue(Exp *fact)
 	provenTrue[lhs] = rhs;
 }
 
+/*==============================================================================
+ * FUNCTION:        Proc::printSummary
+ * OVERVIEW:        Print what the callers of this proc depend on: its signature, the locations it preserves, and for
+ *                  a UserProc its return statement (with the returns and modifieds). See ProcCache
+ * PARAMETERS:      os: stream to print to
+ * RETURNS:         <nothing>
+ *============================================================================*/
+void Proc::printSummary(std::ostream &os)
+{
+	os << "platform " << signature->getPlatform() << " convention " << signature->getConvention()
+	   << (signature->hasEllipsis() ? " ellipsis\n" : "\n");
+	signature->print(os);
+	for (std::map<Exp *, Exp *, lessExpStar>::iterator it = provenTrue.begin(); it != provenTrue.end(); it++)
+		os << "preserves " << it->first << " = " << it->second << "\n";
+	if (!isLib() && ((UserProc *)this)->getTheReturnStatement()) {
+		((UserProc *)this)->getTheReturnStatement()->print(os);
+		os << "\n";
+	}
+}
+
 void UserProc::mapLocalsAndParams()
 {
 	Boomerang::get()->alert_decompile_debug_point(this, "before mapping locals from dfa type analysis");
@@ -0,0 +1,238 @@
+/**
+ * \file
+ * \brief Implementation of the ProcCache class.
+ *
+ * \copyright
+ * See the file "LICENSE.TERMS" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#include "proccache.h"
+
+#include "snapshot.h"
+#include "serializer.h"
+#include "proc.h"
+#include "prog.h"
+#include "cfg.h"
+#include "statement.h"
+#include "boomerang.h"
+#include "log.h"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include <cstdio>
+
+ProcCache::ProcCache(const std::string &dir) : dir(dir), hits(0), misses(0), saved(0)
+{
+	if (this->dir.empty() || this->dir[this->dir.length() - 1] != '/')
+		this->dir += '/';
+}
+
+std::string ProcCache::fileName(QWord key)
+{
+	char buf[32];
+	sprintf(buf, "%08x%08x.proc", (unsigned)(key >> 32), (unsigned)key);
+	return dir + buf;
+}
+
+// 64 bit FNV-1a
+static QWord hash(const std::string &s)
+{
+	QWord h = 14695981039346656037ULL;
+	for (unsigned i = 0; i < s.size(); i++) {
+		h ^= (unsigned char)s[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+/*==============================================================================
+ * FUNCTION:        ProcCache::hashImage
+ * OVERVIEW:        Hash the bytes of the image in the given ranges. A byte outside the sections, or in bss, hashes
+ *                  differently from all the byte values
+ * PARAMETERS:      prog: the prog with the image
+ *                  ranges: the ranges to hash
+ * RETURNS:         The hash
+ *============================================================================*/
+QWord ProcCache::hashImage(Prog *prog, const std::vector<Range> &ranges)
+{
+	QWord h = 14695981039346656037ULL;
+	for (unsigned i = 0; i < ranges.size(); i++) {
+		SectionInfo *si = NULL;
+		for (ADDRESS a = ranges[i].first; a != ranges[i].first + ranges[i].second; a++) {
+			if (si == NULL || a < si->uNativeAddr || a >= si->uNativeAddr + si->uSectionSize)
+				si = prog->getSectionInfoByAddr(a);
+			unsigned b = 0x100;
+			if (si && !si->isAddressBss(a))
+				b = *(unsigned char *)(a + si->uHostAddr - si->uNativeAddr);
+			h ^= b;
+			h *= 1099511628211ULL;
+		}
+	}
+	return h;
+}
+
+/*==============================================================================
+ * FUNCTION:        ProcCache::getKey
+ * OVERVIEW:        Work out the key of a decoded proc: a hash of the switches that change the decompilation, its
+ *                  address and name, its decoded RTLs, and the summaries of its callees
+ * PARAMETERS:      proc: the proc, whose callees are decompiled
+ *                  callees: set to the procs it calls
+ * RETURNS:         The key
+ *============================================================================*/
+QWord ProcCache::getKey(UserProc *proc, std::set<Proc *> &callees)
+{
+	Boomerang *boom = Boomerang::get();
+	std::ostringstream os;
+	os << "entry " << ENTRY_VERSION << " snapshot " << Snapshot::FORMAT_VERSION << "\n";
+	os << "switches " << boom->noBranchSimplify << boom->noRemoveNull << boom->noLocals << boom->noRemoveLabels
+	   << boom->noDataflow << boom->noDecompile << boom->noPromote << boom->propOnlyToAll << boom->noParameterNames
+	   << boom->noProve << boom->noChangeSignatures << boom->conTypeAnalysis << boom->dfaTypeAnalysis
+	   << boom->noGlobals << boom->assumeABI << boom->experimental << boom->decodeThruIndCall
+	   << boom->noDecodeChildren << " " << boom->numToPropagate << " " << boom->propMaxDepth << " "
+	   << boom->maxMemDepth << "\n";
+	os << "proc " << std::hex << proc->getNativeAddress() << std::dec << " " << proc->getName() << "\n";
+	proc->getCFG()->print(os);
+
+	StatementList stmts;
+	proc->getStatements(stmts);
+	for (StatementList::iterator it = stmts.begin(); it != stmts.end(); it++) {
+		if (!(*it)->isCall())
+			continue;
+		Proc *dest = ((CallStatement *)*it)->getDestProc();
+		if (dest == NULL) {
+			os << "callee unknown\n";
+			continue;
+		}
+		os << "callee " << std::hex << dest->getNativeAddress() << std::dec << "\n";
+		if (callees.insert(dest).second)
+			dest->printSummary(os);
+	}
+	return hash(os.str());
+}
+
+/*==============================================================================
+ * FUNCTION:        ProcCache::load
+ * OVERVIEW:        Restore a proc from the cache, if it's there under its key and the image data it read is the same.
+ *                  If not, note the key, so that save() can file the proc under it once decompiled, and start noting
+ *                  the image data read
+ * PARAMETERS:      proc: the proc to restore, with its callees decompiled
+ * RETURNS:         True if restored; the proc is then at PROC_FINAL
+ *============================================================================*/
+bool ProcCache::load(UserProc *proc)
+{
+	if (proc->getStatus() != PROC_VISITED)
+		return false;  // Already partly decompiled
+	Pending p;
+	p.key = getKey(proc, p.callees);
+
+	std::vector<char> buf;
+	std::string name = fileName(p.key);
+	if (Deserializer::readFile(name, buf)) {
+		Deserializer in(&buf[0], buf.size());
+		QWord key = (unsigned)in.word();
+		key |= (QWord)(unsigned)in.word() << 32;
+		ADDRESS addr = in.word();
+		std::string procName = in.str();
+		std::vector<Range> ranges;
+		unsigned n = in.word();
+		for (unsigned i = 0; i < n && in.ok; i++) {
+			ADDRESS a = in.word();
+			ranges.push_back(Range(a, in.word()));
+		}
+		QWord image = (unsigned)in.word();
+		image |= (QWord)(unsigned)in.word() << 32;
+		// Check the key as well as the file name, in case the file was truncated or renamed
+		bool same = in.ok && key == p.key && addr == proc->getNativeAddress() && procName == proc->getName();
+		if (same && image != hashImage(proc->getProg(), ranges)) {
+			if (VERBOSE)
+				LOG << "the image data read by " << proc->getName() << " has changed; decompiling it again\n";
+		} else if (same && Snapshot::loadProc(proc, in)) {
+			hits++;
+			pending.erase(proc);
+			if (VERBOSE)
+				LOG << "restored " << proc->getName() << " from " << name.c_str() << "\n";
+			return true;
+		} else
+			LOG << "can't restore " << proc->getName() << " from " << name.c_str() << "; decompiling it again\n";
+	}
+	misses++;
+	// Note what its decompilation reads of the image
+	p.firstRead = reads.size();
+	proc->getProg()->setReadLog(&reads);
+	pending[proc] = p;
+	return false;
+}
+
+/*==============================================================================
+ * FUNCTION:        ProcCache::save
+ * OVERVIEW:        Save a proc that has just reached PROC_FINAL, under the key noted by load(), with the ranges of the
+ *                  image read since then and a hash of their bytes
+ * PARAMETERS:      proc: the proc to save
+ * RETURNS:         <nothing>
+ *============================================================================*/
+void ProcCache::save(UserProc *proc)
+{
+	std::map<UserProc *, Pending>::iterator pp = pending.find(proc);
+	if (pp == pending.end())
+		return;  // Not looked up, e.g. decompiled as part of a recursion group
+	Pending p = pp->second;
+	pending.erase(pp);
+
+	// The ranges read by its decompilation, and by any procs decompiled in the middle of it, merged
+	std::vector<Range> ranges(reads.begin() + p.firstRead, reads.end());
+	std::sort(ranges.begin(), ranges.end());
+	std::vector<Range> merged;
+	for (unsigned i = 0; i < ranges.size(); i++) {
+		if (merged.size() && ranges[i].first <= merged.back().first + merged.back().second) {
+			ADDRESS end = std::max(merged.back().first + merged.back().second, ranges[i].first + ranges[i].second);
+			merged.back().second = end - merged.back().first;
+		} else
+			merged.push_back(ranges[i]);
+	}
+	if (pending.empty()) {
+		reads.clear();
+		proc->getProg()->setReadLog(NULL);
+	}
+
+	// Callees found by the pipeline would not be decompiled before this proc is restored
+	StatementList stmts;
+	proc->getStatements(stmts);
+	for (StatementList::iterator it = stmts.begin(); it != stmts.end(); it++) {
+		if (!(*it)->isCall())
+			continue;
+		Proc *dest = ((CallStatement *)*it)->getDestProc();
+		if (dest && p.callees.find(dest) == p.callees.end()) {
+			if (VERBOSE)
+				LOG << "not caching " << proc->getName() << ": it has a new callee " << dest->getName() << "\n";
+			return;
+		}
+	}
+
+	Serializer out;
+	out.word((unsigned)p.key);
+	out.word((unsigned)(p.key >> 32));
+	out.word(proc->getNativeAddress());
+	out.str(proc->getName());
+	out.word(merged.size());
+	for (unsigned i = 0; i < merged.size(); i++) {
+		out.word(merged[i].first);
+		out.word(merged[i].second);
+	}
+	QWord image = hashImage(proc->getProg(), merged);
+	out.word((unsigned)image);
+	out.word((unsigned)(image >> 32));
+	if (!Snapshot::saveProc(proc, out) || !out.writeFile(fileName(p.key))) {
+		LOG << "can't save " << proc->getName() << " in the proc cache\n";
+		return;
+	}
+	saved++;
+}
+
+void ProcCache::report()
+{
+	LOG << "proc cache " << dir.c_str() << ": " << hits << " restored, " << misses << " decompiled, " << saved
+	    << " saved\n";
+}
@@ -45,6 +45,7 @@
 #include <sys/stat.h>  // For mkdir
 #include <sys/types.h>
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -58,7 +59,12 @@ Prog::Prog() :
 	pBF(NULL),
 	pFE(NULL),
 	m_iNumberedProc(1),
-	m_rootCluster(new Cluster("prog"))
+	m_rootCluster(new Cluster("prog")),
+	maxGlobalSize(0),
+	globalsIndexed(false),
+	procsIndexed(false),
+	numSymsIndexed(-1),
+	readLog(NULL)
 {
 	// Default constructor
 }
@@ -67,6 +73,7 @@ void Prog::setFrontEnd(FrontEnd *pFE)
 {
 	pBF = pFE->getBinaryFile();
 	this->pFE = pFE;
+	numSymsIndexed = -1;
 	if (pBF && pBF->getFilename()) {
 		m_name = pBF->getFilename();
 		m_rootCluster = new Cluster(getNameNoPathNoExt().c_str());
@@ -78,7 +85,12 @@ Prog::Prog(const char *name) :
 	pFE(NULL),
 	m_name(name),
 	m_iNumberedProc(1),
-	m_rootCluster(new Cluster(getNameNoPathNoExt().c_str()))
+	m_rootCluster(new Cluster(getNameNoPathNoExt().c_str())),
+	maxGlobalSize(0),
+	globalsIndexed(false),
+	procsIndexed(false),
+	numSymsIndexed(-1),
+	readLog(NULL)
 {
 	// Constructor taking a name. Technically, the allocation of the space for the name could fail, but this is unlikely
 	m_path = m_name;
@@ -153,6 +165,7 @@ void Prog::generateDotFile()
 
 void Prog::generateCode(Cluster *cluster, UserProc *proc, bool intermixRTL)
 {
+	PhaseAlert phase(NULL, "generateCode");
 	std::string basedir = m_rootCluster->makeDirs();
 	std::ofstream os;
 	if (cluster) {
@@ -176,14 +189,8 @@ void Prog::generateCode(Cluster *cluster, UserProc *proc, bool intermixRTL)
 					str = sections[j];
 					str += "_size";
 					code->AddGlobal(str.c_str(), new IntegerType(32, -1), new Const(info ? info->uSectionSize : (unsigned int)-1));
-					Exp *l = new Terminal(opNil);
-					for (unsigned int i = 0; info && i < info->uSectionSize; i++) {
-						int n = pBF->readNative1(info->uNativeAddr + info->uSectionSize - 1 - i);
-						if (n < 0)
-							n = 256 + n;
-						l = new Binary(opList, new Const(n), l);
-					}
-					code->AddGlobal(sections[j], new ArrayType(new IntegerType(8, -1), info ? info->uSectionSize : 0), l);
+					// Streamed from the image when printed; a section can be far too big for an Exp per byte
+					code->AddRawGlobal(sections[j], pBF, info ? info->uNativeAddr : 0, info ? info->uSectionSize : 0);
 				}
 				code->AddGlobal("source_endianness", new IntegerType(), new Const(getFrontEndId() != PLAT_PENTIUM));
 				os << "#include \"boomerang.h\"\n\n";
@@ -217,10 +224,12 @@ void Prog::generateCode(Cluster *cluster, UserProc *proc, bool intermixRTL)
 		code->AddPrototype(up);  // May be the wrong signature if up has ellipsis
 		if (cluster == NULL || cluster == m_rootCluster)
 			code->print(os);
+		delete code;
 	}
 	if ((proto && cluster == NULL) || cluster == m_rootCluster)
 		os << "\n";  // Separate prototype(s) from first proc
 
+	std::vector<UserProc *> work;
 	for (it = m_procs.begin(); it != m_procs.end(); it++) {
 		Proc *pProc = *it;
 		if (pProc->isLib()) continue;
@@ -228,9 +237,11 @@ void Prog::generateCode(Cluster *cluster, UserProc *proc, bool intermixRTL)
 		if (!up->isDecoded()) continue;
 		if (proc != NULL && up != proc)
 			continue;
-		up->getCFG()->compressCfg();
-		HLLCode *code = Boomerang::get()->getHLLCode(up);
-		up->generateCode(code);
+		work.push_back(up);
+	}
+	for (unsigned i = 0; i < work.size(); i++) {
+		UserProc *up = work[i];
+		HLLCode *code = generateProcCode(up);
 		if (up->getCluster() == m_rootCluster) {
 			if (cluster == NULL || cluster == m_rootCluster)
 				code->print(os);
@@ -240,6 +251,7 @@ void Prog::generateCode(Cluster *cluster, UserProc *proc, bool intermixRTL)
 				code->print(up->getCluster()->getStream());
 			}
 		}
+		delete code;  // Printed; only one proc's code is held at a time
 	}
 	os.close();
 	m_rootCluster->closeStreams();
@@ -406,14 +418,31 @@ void Prog::generateCode(std::ostream &os)
 		if (pProc->isLib()) continue;
 		UserProc *p = (UserProc *)pProc;
 		if (!p->isDecoded()) continue;
-		p->getCFG()->compressCfg();
-		code = Boomerang::get()->getHLLCode(p);
-		p->generateCode(code);
+		code = generateProcCode(p);
 		code->print(os);
 		delete code;
 	}
 }
 
+/**
+ * Structure \a proc and generate its code into a buffer of its own, for the caller to print and delete.
+ *
+ * This touches only \a proc, its CFG and the new buffer, apart from reading the rest of the Prog (callee signatures,
+ * globals), so it is the unit a parallel code generation stage would hand to each worker; the callers print the
+ * buffers in the order of m_procs, so the output would not depend on the workers.
+ *
+ * \note Workers are not used yet: the garbage collector is not told about other threads, and the logging, the
+ * Profiler (with the allocation counts of operator new), the lazily built indexes of the Prog and some static buffers
+ * (e.g. in BasicBlock) are shared without locks.
+ */
+HLLCode *Prog::generateProcCode(UserProc *proc)
+{
+	proc->getCFG()->compressCfg();
+	HLLCode *code = Boomerang::get()->getHLLCode(proc);
+	proc->generateCode(code);
+	return code;
+}
+
 // Print this program, mainly for debugging
 void Prog::print(std::ostream &out)
 {
@@ -437,6 +466,7 @@ void Prog::clear()
 			delete *it;
 	m_procs.clear();
 	m_procLabels.clear();
+	procsIndexed = false;
 	if (pBF)
 		delete pBF;
 	pBF = NULL;
@@ -505,6 +535,8 @@ Proc *Prog::newProc(const char *name, ADDRESS uNative, bool bLib /*= false*/)
 
 	m_procs.push_back(pProc);  // Append this to list of procs
 	m_procLabels[uNative] = pProc;
+	if (procsIndexed)
+		procsByName.insert(std::pair<std::string, Proc *>(pProc->getName(), pProc));
 	// alert the watchers of a new proc
 	Boomerang::get()->alert_new(pProc);
 	return pProc;
@@ -530,6 +562,7 @@ void Prog::remProc(UserProc *uProc)
 			break;
 		}
 	}
+	procsIndexed = false;
 
 	// Delete the UserProc object as well
 	delete uProc;
@@ -541,6 +574,7 @@ void Prog::removeProc(const char *name)
 		if (std::string(name) == (*it)->getName()) {
 			Boomerang::get()->alert_remove(*it);
 			m_procs.erase(it);
+			procsIndexed = false;
 			break;
 		}
 }
@@ -602,11 +636,16 @@ Proc *Prog::findProc(ADDRESS uAddr) const
 
 Proc *Prog::findProc(const char *name) const
 {
-	std::list<Proc *>::const_iterator it;
-	for (it = m_procs.begin(); it != m_procs.end(); it++)
-		if (!strcmp((*it)->getName(), name))
-			return *it;
-	return NULL;
+	if (!procsIndexed) {
+		procsByName.clear();
+		for (std::list<Proc *>::const_iterator it = m_procs.begin(); it != m_procs.end(); it++)
+			procsByName.insert(std::pair<std::string, Proc *>((*it)->getName(), *it));  // Keeps the first
+		procsIndexed = true;
+	}
+	std::map<std::string, Proc *>::const_iterator it = procsByName.find(name);
+	if (it == procsByName.end())
+		return NULL;
+	return it->second;
 }
 
 // get a library procedure by name; create if does not exist
@@ -662,16 +701,127 @@ bool Prog::isWin32()
 	return pFE->isWin32();
 }
 
-const char *Prog::getGlobalName(ADDRESS uaddr)
+/*==============================================================================
+ * FUNCTION:    Prog::addGlobal
+ * OVERVIEW:    Add a global to the set of globals, and to the lookup indexes if they are current
+ * PARAMETERS:  global: the new global
+ * RETURNS:     <nothing>
+ *============================================================================*/
+void Prog::addGlobal(Global *global)
 {
-	// FIXME: inefficient
-	for (std::set<Global *>::iterator it = globals.begin(); it != globals.end(); it++) {
-		if ((*it)->getAddress() == uaddr)
-			return (*it)->getName();
-		else if ((*it)->getAddress() < uaddr
-		      && (*it)->getAddress() + (*it)->getType()->getSize() / 8 > uaddr)
-			return (*it)->getName();
+	globals.insert(global);
+	if (globalsIndexed)
+		indexGlobal(global);
+}
+
+void Prog::indexGlobal(Global *global)
+{
+	globalsByName.insert(std::pair<std::string, Global *>(global->getName(), global));  // Keeps the first
+	globalsByAddr.insert(std::pair<ADDRESS, Global *>(global->getAddress(), global));
+	if (global->getType()) {
+		unsigned sz = global->getType()->getSize() / 8;
+		if (sz > maxGlobalSize)
+			maxGlobalSize = sz;
+	}
+}
+
+/*==============================================================================
+ * FUNCTION:    Prog::indexGlobals
+ * OVERVIEW:    Rebuild the name and address indexes of the globals, if they are stale
+ * NOTE:        Global types only change through globalUsed() and setGlobalType(), which keep maxGlobalSize up to date
+ * PARAMETERS:  <none>
+ * RETURNS:     <nothing>
+ *============================================================================*/
+void Prog::indexGlobals()
+{
+	if (globalsIndexed) return;
+	globalsByName.clear();
+	globalsByAddr.clear();
+	maxGlobalSize = 0;
+	for (std::set<Global *>::iterator it = globals.begin(); it != globals.end(); it++)
+		indexGlobal(*it);
+	globalsIndexed = true;
+}
+
+/*==============================================================================
+ * FUNCTION:    Prog::findGlobalAt
+ * OVERVIEW:    Find the global starting at uaddr or, failing that, the nearest one below uaddr that contains it
+ * PARAMETERS:  uaddr: native address to look up
+ * RETURNS:     The global, or NULL if none
+ *============================================================================*/
+Global *Prog::findGlobalAt(ADDRESS uaddr)
+{
+	indexGlobals();
+	std::multimap<ADDRESS, Global *>::iterator it = globalsByAddr.lower_bound(uaddr);
+	if (it != globalsByAddr.end() && it->first == uaddr)
+		return it->second;
+	// No global below uaddr - maxGlobalSize can reach it
+	while (it != globalsByAddr.begin()) {
+		--it;
+		if (uaddr - it->first >= maxGlobalSize)
+			break;
+		if (it->first + it->second->getType()->getSize() / 8 > uaddr)
+			return it->second;
 	}
+	return NULL;
+}
+
+/*==============================================================================
+ * FUNCTION:    Prog::indexSymbols
+ * OVERVIEW:    Rebuild the address ranges of the binary file's symbols (in address order, as the map keeps them), if
+ *              symbols have been added since they were built
+ * NOTE:        GetSizeByName() is a search of its own in some loaders, so this is done once rather than per lookup
+ * PARAMETERS:  <none>
+ * RETURNS:     <nothing>
+ *============================================================================*/
+void Prog::indexSymbols()
+{
+	std::map<ADDRESS, std::string> &symbols = pBF->getSymbols();
+	if (numSymsIndexed == (int)symbols.size()) return;
+	symRanges.clear();
+	for (std::map<ADDRESS, std::string>::iterator it = symbols.begin(); it != symbols.end(); it++) {
+		SymRange r;
+		r.start = it->first;
+		r.end = it->first + pBF->GetSizeByName(it->second.c_str());
+		if (r.end <= r.start)
+			continue;  // No size, or wraps (e.g. the fake library addresses); can contain nothing
+		r.name = it->second;
+		symRanges.push_back(r);
+	}
+	ADDRESS reach = 0;
+	for (unsigned i = 0; i < symRanges.size(); i++) {
+		if (symRanges[i].end > reach)
+			reach = symRanges[i].end;
+		symRanges[i].reach = reach;
+	}
+	numSymsIndexed = symbols.size();
+}
+
+/*==============================================================================
+ * FUNCTION:    Prog::findSymbolContaining
+ * OVERVIEW:    Find the symbol with the lowest address below uaddr whose size takes it past uaddr
+ * PARAMETERS:  uaddr: native address to look up
+ *              start: set to the address of the symbol found
+ * RETURNS:     The name of the symbol, or NULL if none
+ *============================================================================*/
+const char *Prog::findSymbolContaining(ADDRESS uaddr, ADDRESS &start)
+{
+	indexSymbols();
+	// The ranges starting below uaddr are those before k; the first of all ranges to reach past uaddr is i, and the
+	// reaches only grow, so if i is below k it is the one wanted
+	std::vector<SymRange>::iterator k = std::lower_bound(symRanges.begin(), symRanges.end(), uaddr, SymRange::startsBelow);
+	std::vector<SymRange>::iterator i = std::upper_bound(symRanges.begin(), k, uaddr, SymRange::reachesPast);
+	if (i == k)
+		return NULL;
+	start = i->start;
+	return i->name.c_str();
+}
+
+const char *Prog::getGlobalName(ADDRESS uaddr)
+{
+	Global *global = findGlobalAt(uaddr);
+	if (global)
+		return global->getName();
 	if (pBF)
 		return pBF->SymbolByAddress(uaddr);
 	return NULL;
@@ -687,34 +837,33 @@ void Prog::dumpGlobals()
 
 ADDRESS Prog::getGlobalAddr(const char *nam)
 {
-	for (std::set<Global *>::iterator it = globals.begin(); it != globals.end(); it++) {
-		if (!strcmp((*it)->getName(), nam))
-			return (*it)->getAddress();
-	}
+	Global *global = getGlobal(nam);
+	if (global)
+		return global->getAddress();
 	return pBF->GetAddressByName(nam);
 }
 
 Global *Prog::getGlobal(const char *nam)
 {
-	for (std::set<Global *>::iterator it = globals.begin(); it != globals.end(); it++) {
-		if (!strcmp((*it)->getName(), nam))
-			return *it;
-	}
-	return NULL;
+	indexGlobals();
+	std::map<std::string, Global *>::iterator it = globalsByName.find(nam);
+	if (it == globalsByName.end())
+		return NULL;
+	return it->second;
 }
 
 bool Prog::globalUsed(ADDRESS uaddr, Type *knownType)
 {
-	Global *global;
+	Global *global = findGlobalAt(uaddr);
 
-	for (std::set<Global *>::iterator it = globals.begin(); it != globals.end(); it++) {
-		if ((*it)->getAddress() == uaddr) {
-			if (knownType) (*it)->meetType(knownType);
-			return true;
-		} else if ((*it)->getAddress() < uaddr && (*it)->getAddress() + (*it)->getType()->getSize() / 8 > uaddr) {
-			if (knownType) (*it)->meetType(knownType);
-			return true;
+	if (global) {
+		if (knownType) {
+			global->meetType(knownType);
+			unsigned sz = global->getType()->getSize() / 8;
+			if (sz > maxGlobalSize)
+				maxGlobalSize = sz;
 		}
+		return true;
 	}
 
 	if (pBF->GetSectionInfoByAddr(uaddr) == NULL) {
@@ -740,7 +889,7 @@ bool Prog::globalUsed(ADDRESS uaddr, Type *knownType)
 		ty = guessGlobalType(nam, uaddr);
 
 	global = new Global(ty, uaddr, nam);
-	globals.insert(global);
+	addGlobal(global);
 
 	if (VERBOSE) {
 		LOG << "globalUsed: name " << nam << ", address " << uaddr;
@@ -793,9 +942,16 @@ const char *Prog::newGlobalName(ADDRESS uaddr)
 {
 	const char *nam = getGlobalName(uaddr);
 	if (nam == NULL) {
-		std::ostringstream os;
-		os << "global" << globals.size();
-		nam = strdup(os.str().c_str());
+		// Procs restored from the ProcCache bring their own globals, so the next number may be taken
+		std::string name;
+		for (size_t n = globals.size(); ; n++) {
+			std::ostringstream os;
+			os << "global" << n;
+			name = os.str();
+			if (getGlobal(name.c_str()) == NULL)
+				break;
+		}
+		nam = strdup(name.c_str());
 		if (VERBOSE)
 			LOG << "naming new global: " << nam << " at address " << uaddr << "\n";
 	}
@@ -804,20 +960,20 @@ const char *Prog::newGlobalName(ADDRESS uaddr)
 
 Type *Prog::getGlobalType(const char *nam)
 {
-	for (std::set<Global *>::iterator it = globals.begin(); it != globals.end(); it++)
-		if (!strcmp((*it)->getName(), nam))
-			return (*it)->getType();
+	Global *global = getGlobal(nam);
+	if (global)
+		return global->getType();
 	return NULL;
 }
 
 void Prog::setGlobalType(const char *nam, Type *ty)
 {
-	// FIXME: inefficient
-	for (std::set<Global *>::iterator it = globals.begin(); it != globals.end(); it++) {
-		if (!strcmp((*it)->getName(), nam)) {
-			(*it)->setType(ty);
-			return;
-		}
+	Global *global = getGlobal(nam);
+	if (global) {
+		global->setType(ty);
+		unsigned sz = ty->getSize() / 8;
+		if (sz > maxGlobalSize)
+			maxGlobalSize = sz;
 	}
 }
 
@@ -832,9 +988,11 @@ const char *Prog::getStringConstant(ADDRESS uaddr, bool knownString /* = false *
 		// At this stage, only support ascii, null terminated, non unicode strings.
 		// At least 4 of the first 6 chars should be printable ascii
 		const char *p = (const char *)(uaddr + si->uHostAddr - si->uNativeAddr);
-		if (knownString)
+		if (knownString) {
 			// No need to guess... this is hopefully a known string
+			noteRead(uaddr, strlen(p) + 1);
 			return p;
+		}
 		int printable = 0;
 		char last = 0;
 		for (int i = 0; i < 6; i++) {
@@ -843,11 +1001,13 @@ const char *Prog::getStringConstant(ADDRESS uaddr, bool knownString /* = false *
 			if (c >= ' ' && c < '\x7F') printable++;
 			last = c;
 		}
-		if (printable >= 4)
-			return p;
-		// Just a hack while type propagations are not yet ready
-		if (last == '\n' && printable >= 2)
+		if (printable >= 4
+		 // Just a hack while type propagations are not yet ready
+		 || (last == '\n' && printable >= 2)) {
+			noteRead(uaddr, strlen(p) + 1);
 			return p;
+		}
+		noteRead(uaddr, 6);
 	}
 	return NULL;
 }
@@ -857,6 +1017,7 @@ double Prog::getFloatConstant(ADDRESS uaddr, bool &ok, int bits)
 	ok = true;
 	SectionInfo *si = pBF->GetSectionInfoByAddr(uaddr);
 	if (si && si->bReadOnly) {
+		noteRead(uaddr, bits / 8);
 		if (bits == 64) {
 			return pBF->readNativeFloat8(uaddr);
 		} else {
@@ -877,14 +1038,22 @@ double Prog::getFloatConstant(ADDRESS uaddr, bool &ok, int bits)
  *============================================================================*/
 Proc *Prog::findContainingProc(ADDRESS uAddr) const
 {
-	for (std::list<Proc *>::const_iterator it = m_procs.begin(); it != m_procs.end(); it++) {
-		Proc *p = (*it);
+	// Try the proc starting at uAddr, then the procs below it nearest first (one of these almost always contains
+	// uAddr), and lastly those above it, since the BBs of a proc need not follow its entry point
+	PROGMAP::const_iterator up = m_procLabels.upper_bound(uAddr);
+	for (PROGMAP::const_reverse_iterator it(up); it != m_procLabels.rend(); it++) {
+		Proc *p = it->second;
+		if (p == NULL || p == (Proc *)-1) continue;
 		if (p->getNativeAddress() == uAddr)
 			return p;
 		if (p->isLib()) continue;
-
-		UserProc *u = (UserProc *)p;
-		if (u->containsAddr(uAddr))
+		if (((UserProc *)p)->containsAddr(uAddr))
+			return p;
+	}
+	for (PROGMAP::const_iterator it = up; it != m_procLabels.end(); it++) {
+		Proc *p = it->second;
+		if (p == NULL || p == (Proc *)-1 || p->isLib()) continue;
+		if (((UserProc *)p)->containsAddr(uAddr))
 			return p;
 	}
 	return NULL;
@@ -1072,6 +1241,7 @@ void Prog::decodeEverythingUndecoded()
 
 void Prog::decompile()
 {
+	PhaseAlert phase(NULL, "decompile");
 	assert(m_procs.size());
 
 	if (VERBOSE)
@@ -1135,6 +1305,15 @@ void Prog::decompile()
 	// Now it is OK to transform out of SSA form
 	fromSSAform();
 
+	// No more redecoding after this
+	if (VERBOSE)
+		LOG << "decode cache: " << (int)pFE->getDecodeCacheHits() << " hits, "
+		    << (int)pFE->getDecodeCacheMisses() << " misses\n";
+	pFE->clearDecodeCache();
+	if (VERBOSE)
+		LOG << "simplify: " << (int)Exp::simplifyCalls << " calls, " << (int)Exp::simplifySkips
+		    << " already simplified\n";
+
 	// Note: removeUnusedLocals() is now in UserProc::generateCode()
 
 	removeUnusedGlobals();
@@ -1175,6 +1354,7 @@ void Prog::removeUnusedGlobals()
 	Global *usedGlobal;
 
 	globals.clear();
+	globalsIndexed = false;
 	for (std::list<Exp *>::iterator it = usedGlobals.begin(); it != usedGlobals.end(); it++) {
 		if (DEBUG_UNUSED)
 			LOG << " " << *it << " is used\n";
@@ -1199,6 +1379,7 @@ void Prog::removeUnusedGlobals()
 // Return true if any change
 bool Prog::removeUnusedReturns()
 {
+	PhaseAlert phase(NULL, "removeUnusedReturns");
 	// For each UserProc. Each proc may process many others, so this may duplicate some work. Really need a worklist of
 	// procedures not yet processed.
 	// Define a workset for the procedures who have to have their returns checked
@@ -1229,6 +1410,7 @@ bool Prog::removeUnusedReturns()
 // Have to transform out of SSA form after the above final pass
 void Prog::fromSSAform()
 {
+	PhaseAlert phase(NULL, "fromSSAform");
 	std::list<Proc *>::iterator pp;
 	for (pp = m_procs.begin(); pp != m_procs.end(); pp++) {
 		UserProc *proc = (UserProc *)(*pp);
@@ -1268,6 +1450,7 @@ void Prog::conTypeAnalysis()
 
 void Prog::globalTypeAnalysis()
 {
+	PhaseAlert phase(NULL, "globalTypeAnalysis");
 	if (VERBOSE || DEBUG_TA)
 		LOG << "### start global data-flow-based type analysis ###\n";
 	std::list<Proc *>::iterator pp;
@@ -1463,7 +1646,7 @@ void Prog::readSymbolFile(const char *fname)
 			if (ty == NULL) {
 				ty = guessGlobalType(nam, (*it)->addr);
 			}
-			globals.insert(new Global(ty, (*it)->addr, nam));
+			addGlobal(new Global(ty, (*it)->addr, nam));
 		}
 	}
 
@@ -1581,6 +1764,7 @@ Exp *Prog::readNativeAs(ADDRESS uaddr, Type *type)
 			size = type->asSize()->getSize();
 		switch (size) {
 		case 8:
+			noteRead(uaddr, 1);
 			e = new Const((int)*(char *)(uaddr + si->uHostAddr - si->uNativeAddr));
 			break;
 		case 16:
@@ -1727,6 +1911,8 @@ void Prog::readMemo(Memo *mm, bool dec)
 	globalMap = m->globalMap;
 	m_iNumberedProc = m->m_iNumberedProc;
 	m_rootCluster = m->m_rootCluster;
+	globalsIndexed = false;
+	procsIndexed = false;
 
 	for (std::list<Proc *>::iterator it = m_procs.begin(); it != m_procs.end(); it++)
 		(*it)->restoreMemo(m->mId, dec);
@@ -1864,7 +2050,7 @@ Exp *Prog::addReloc(Exp *e, ADDRESS lc)
 			unsigned int sz = pBF->GetSizeByName(n);
 			if (getGlobal(n) == NULL) {
 				Global *global = new Global(new SizeType(sz * 8), a, n);
-				globals.insert(global);
+				addGlobal(global);
 			}
 			e = new Unary(opAddrOf, Location::global(n, NULL));
 		} else {
@@ -1873,15 +2059,13 @@ Exp *Prog::addReloc(Exp *e, ADDRESS lc)
 				e = new Const(str);
 			else {
 				// check for accesses into the middle of symbols
-				for (std::map<ADDRESS, std::string>::iterator it = symbols.begin(); it != symbols.end(); it++) {
-					if ((*it).first < (ADDRESS)c->getInt()
-					 && (*it).first + pBF->GetSizeByName((*it).second.c_str()) > (ADDRESS)c->getInt()) {
-						int off = c->getInt() - (*it).first;
-						e = new Binary(opPlus,
-						               new Unary(opAddrOf, Location::global((*it).second.c_str(), NULL)),
-						               new Const(off));
-						break;
-					}
+				ADDRESS start;
+				const char *n = findSymbolContaining(c->getInt(), start);
+				if (n) {
+					int off = c->getInt() - start;
+					e = new Binary(opPlus,
+					               new Unary(opAddrOf, Location::global(n, NULL)),
+					               new Const(off));
 				}
 			}
 		}
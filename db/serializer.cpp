@@ -0,0 +1,443 @@
+/**
+ * \file
+ * \brief Implementation of the binary form of expressions, types, statements, RTLs and signatures used by the
+ *        precompiled SSL and signature files.
+ *
+ * \copyright
+ * See the file "LICENSE.TERMS" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#include "serializer.h"
+
+#include "exp.h"
+#include "type.h"
+#include "statement.h"
+#include "rtl.h"
+#include "register.h"
+#include "signature.h"
+
+#include <sstream>
+
+#include <unistd.h>  // For getpid()
+
+#include <cstdio>
+#include <cstring>
+
+void Serializer::word(int w)
+{
+	for (int i = 0; i < 4; i++)
+		buf += (char)((unsigned)w >> (i * 8));
+}
+
+void Serializer::str(const char *s)
+{
+	word(strlen(s));
+	buf.append(s);
+}
+
+void Serializer::strList(std::list<std::string> &l)
+{
+	word(l.size());
+	for (std::list<std::string>::iterator it = l.begin(); it != l.end(); it++)
+		str(it->c_str());
+}
+
+void Serializer::reg(Register &r)
+{
+	word(r.hasName());
+	if (r.hasName())
+		str(r.g_name());
+	word(r.g_size());
+	word(r.g_mappedIndex());
+	word(r.g_mappedOffset());
+	word(r.isFloat());
+}
+
+void Serializer::type(Type *ty)
+{
+	if (ty == NULL) word('0');
+	else if (ty->isVoid()) word('v');
+	else if (ty->isInteger()) { word('i'); word(ty->getSize()); word(((IntegerType *)ty)->getSignedness()); }
+	else if (ty->isFloat()) { word('f'); word(ty->getSize()); }
+	else if (ty->isChar()) word('c');
+	else if (ty->isBoolean()) word('b');
+	else if (ty->isSize()) { word('s'); word(ty->getSize()); }
+	else if (ty->isPointer()) { word('p'); type(ty->asPointer()->getPointsTo()); }
+	else if (ty->isArray()) { word('a'); word(ty->asArray()->getLength()); type(ty->asArray()->getBaseType()); }
+	else if (ty->isNamed()) { word('n'); str(ty->asNamed()->getName()); }
+	else if (ty->isFunc()) { word('F'); sig(ty->asFunc()->getSignature()); }
+	else if (ty->isCompound() && !ty->asCompound()->isGeneric()) {
+		CompoundType *c = ty->asCompound();
+		word('S');
+		word(c->getNumTypes());
+		for (unsigned i = 0; i < c->getNumTypes(); i++) {
+			type(c->getType(i));
+			str(c->getName(i));
+		}
+	} else
+		ok = false;
+}
+
+void Serializer::exp(Exp *e)
+{
+	OPER op = e->getOper();
+	word(op);
+	switch (op) {
+	case opIntConst:
+		word(((Const *)e)->getInt());
+		break;
+	case opFltConst:
+		{
+			double d = ((Const *)e)->getFlt();
+			int w[2];
+			memcpy(w, &d, sizeof(d));
+			word(w[0]);
+			word(w[1]);
+			break;
+		}
+	case opStrConst:
+		str(((Const *)e)->getStr());
+		break;
+	case opTypedExp:
+		type(((TypedExp *)e)->getType());
+		exp(e->getSubExp1());
+		break;
+	case opFlagDef:
+		exp(e->getSubExp1());
+		rtl(((FlagDef *)e)->getRtl());
+		break;
+	default:
+		// Only plain expressions from here on; the class is implied by the operator and arity
+		if (dynamic_cast<Const *>(e) || op == opSubscript || op == opTypeVal
+		 || (dynamic_cast<Location *>(e) && ((Location *)e)->getProc())) {
+			ok = false;
+			return;
+		}
+		word(dynamic_cast<Location *>(e) != NULL);
+		word(e->getArity());
+		if (e->getArity() >= 1) exp(e->getSubExp1());
+		if (e->getArity() >= 2) exp(e->getSubExp2());
+		if (e->getArity() >= 3) exp(e->getSubExp3());
+		break;
+	}
+}
+
+void Serializer::stmt(Statement *s)
+{
+	if (s == NULL) {
+		word(0);
+		return;
+	}
+	if (!s->isAssign()) {
+		ok = false;
+		return;
+	}
+	Assign *a = (Assign *)s;
+	word(1);
+	type(a->getType());
+	exp(a->getLeft());
+	exp(a->getRight());
+	word(a->getGuard() != NULL);
+	if (a->getGuard())
+		exp(a->getGuard());
+}
+
+void Serializer::rtl(RTL *r)
+{
+	word(r != NULL);
+	if (r == NULL)
+		return;
+	word(r->getAddress());
+	std::list<Statement *> &l = r->getList();
+	word(l.size());
+	for (std::list<Statement *>::iterator it = l.begin(); it != l.end(); it++)
+		stmt(*it);
+}
+
+// The class of a signature is given by its platform and calling convention (as for Signature::instantiate()), or is
+// a CustomSignature. The state is then written as is, not the calls that made it.
+void Serializer::sig(Signature *s)
+{
+	if (s == NULL) {
+		word(0);
+		return;
+	}
+	CustomSignature *cs = dynamic_cast<CustomSignature *>(s);
+	if (cs) {
+		word('C');
+		word(cs->sp);
+	} else if (s->getPlatform() != PLAT_GENERIC) {
+		word('S');
+		word(s->getPlatform());
+		word(s->getConvention());
+	} else {
+		ok = false;
+		return;
+	}
+	str(s->name.c_str());
+	str(s->sigFile.c_str());
+	word(s->params.size());
+	for (unsigned i = 0; i < s->params.size(); i++) {
+		Parameter *param = s->params[i];
+		type(param->getType());
+		str(param->getName());
+		word(param->getExp() != NULL);
+		if (param->getExp())
+			exp(param->getExp());
+		str(param->getBoundMax());
+	}
+	word(s->returns.size());
+	for (unsigned i = 0; i < s->returns.size(); i++) {
+		type(s->returns[i]->type);
+		word(s->returns[i]->exp != NULL);
+		if (s->returns[i]->exp)
+			exp(s->returns[i]->exp);
+	}
+	type(s->rettype);
+	word(s->ellipsis);
+	word(s->unknown);
+	word(s->forced);
+	type(s->preferedReturn);
+	str(s->preferedName.c_str());
+	word(s->preferedParams.size());
+	for (unsigned i = 0; i < s->preferedParams.size(); i++)
+		word(s->preferedParams[i]);
+}
+
+bool Serializer::writeFile(const std::string &fileName)
+{
+	std::ostringstream tmp;
+	tmp << fileName << "." << getpid();
+	FILE *f = fopen(tmp.str().c_str(), "wb");
+	if (f == NULL)
+		return false;  // E.g. the directory is installed read only
+	bool written = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+	written &= fclose(f) == 0;
+	if (!written || rename(tmp.str().c_str(), fileName.c_str()) != 0) {
+		remove(tmp.str().c_str());
+		return false;
+	}
+	return true;
+}
+
+int Deserializer::word()
+{
+	if (end - p < 4) {
+		ok = false;
+		return 0;
+	}
+	unsigned w = p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+	p += 4;
+	return (int)w;
+}
+
+std::string Deserializer::str()
+{
+	int n = word();
+	if (n < 0 || end - p < n) {
+		ok = false;
+		return "";
+	}
+	std::string s((const char *)p, n);
+	p += n;
+	return s;
+}
+
+void Deserializer::strList(std::list<std::string> &l)
+{
+	for (int n = word(); ok && n > 0; n--)
+		l.push_back(str());
+}
+
+void Deserializer::reg(Register &r)
+{
+	if (word())
+		r.s_name(str().c_str());
+	r.s_size(word());
+	r.s_mappedIndex(word());
+	r.s_mappedOffset(word());
+	r.s_float(word() != 0);
+}
+
+Type *Deserializer::type()
+{
+	int sz;
+	switch (word()) {
+	case '0': return NULL;
+	case 'v': return new VoidType;
+	case 'i': sz = word(); return new IntegerType(sz, word());
+	case 'f': return new FloatType(word());
+	case 'c': return new CharType;
+	case 'b': return new BooleanType;
+	case 's': return new SizeType(word());
+	case 'p': return new PointerType(type());
+	case 'a': sz = word(); return new ArrayType(type(), sz);
+	case 'n': return new NamedType(str().c_str());
+	case 'F': return new FuncType(sig());
+	case 'S':
+		{
+			CompoundType *c = new CompoundType();
+			for (int n = word(); ok && n > 0; n--) {
+				c->types.push_back(type());
+				c->names.push_back(str());
+			}
+			return c;
+		}
+	}
+	ok = false;
+	return NULL;
+}
+
+Exp *Deserializer::exp()
+{
+	OPER op = (OPER)word();
+	if (!ok || op < opWild || op >= opNumOf) {
+		ok = false;
+		return new Terminal(opNil);
+	}
+	switch (op) {
+	case opIntConst:
+		return new Const(word());
+	case opFltConst:
+		{
+			int w[2];
+			w[0] = word();
+			w[1] = word();
+			double d;
+			memcpy(&d, w, sizeof(d));
+			return new Const(d);
+		}
+	case opStrConst:
+		return new Const(strdup(str().c_str()));
+	case opTypedExp:
+		{
+			Type *ty = type();
+			return new TypedExp(ty, exp());
+		}
+	case opFlagDef:
+		{
+			Exp *params = exp();
+			return new FlagDef(params, rtl());
+		}
+	default:
+		break;
+	}
+	bool isLoc = word() != 0;
+	int arity = word();
+	if (!ok || (isLoc && arity != 1)) {
+		ok = false;
+		return new Terminal(opNil);
+	}
+	if (arity == 0)
+		return new Terminal(op);
+	Exp *e1 = exp();
+	if (isLoc)
+		return new Location(op, e1, NULL);
+	if (arity == 1)
+		return new Unary(op, e1);
+	Exp *e2 = exp();
+	if (arity == 2)
+		return new Binary(op, e1, e2);
+	Exp *e3 = exp();
+	if (arity == 3)
+		return new Ternary(op, e1, e2, e3);
+	ok = false;
+	return new Terminal(opNil);
+}
+
+Statement *Deserializer::stmt()
+{
+	int kind = word();
+	if (kind == 0)
+		return NULL;
+	if (kind != 1) {
+		ok = false;
+		return NULL;
+	}
+	Type *ty = type();
+	Exp *lhs = exp();
+	Exp *rhs = exp();
+	Exp *guard = word() ? exp() : NULL;
+	return new Assign(ty, lhs, rhs, guard);
+}
+
+RTL *Deserializer::rtl()
+{
+	if (!word())
+		return NULL;
+	RTL *r = new RTL(word());
+	for (int n = word(); ok && n > 0; n--)
+		r->appendStmt(stmt());
+	return r;
+}
+
+Signature *Deserializer::sig()
+{
+	Signature *s;
+	int kind = word();
+	if (kind == 0)
+		return NULL;
+	if (kind == 'C') {
+		int sp = word();
+		CustomSignature *cs = new CustomSignature(str().c_str());
+		cs->sp = sp;
+		s = cs;
+	} else if (kind == 'S') {
+		platform plat = (platform)word();
+		callconv cc = (callconv)word();
+		std::string name = str();
+		if (!ok || plat < 0 || plat >= PLAT_GENERIC || cc < 0 || cc >= CONV_NONE) {
+			ok = false;
+			return new Signature(name.c_str());
+		}
+		s = Signature::instantiate(plat, cc, name.c_str());
+		// Replaced by the saved ones below
+		s->params.clear();
+		s->returns.clear();
+	} else {
+		ok = false;
+		return new Signature("");
+	}
+	s->sigFile = str();
+	for (int n = word(); ok && n > 0; n--) {
+		Type *ty = type();
+		std::string name = str();
+		Exp *e = word() ? exp() : NULL;
+		std::string boundMax = str();
+		s->params.push_back(new Parameter(ty, name.c_str(), e, boundMax.c_str()));
+	}
+	for (int n = word(); ok && n > 0; n--) {
+		Type *ty = type();
+		Exp *e = word() ? exp() : NULL;
+		s->returns.push_back(new Return(ty, e));
+	}
+	s->rettype = type();
+	s->ellipsis = word() != 0;
+	s->unknown = word() != 0;
+	s->forced = word() != 0;
+	s->preferedReturn = type();
+	s->preferedName = str();
+	for (int n = word(); ok && n > 0; n--)
+		s->preferedParams.push_back(word());
+	return s;
+}
+
+bool Deserializer::readFile(const std::string &fileName, std::vector<char> &buf)
+{
+	buf.clear();
+	FILE *f = fopen(fileName.c_str(), "rb");
+	if (f == NULL)
+		return false;
+	if (fseek(f, 0, SEEK_END) == 0) {
+		long len = ftell(f);
+		if (len > 0) {
+			buf.resize(len);
+			rewind(f);
+			if (fread(&buf[0], 1, len, f) != (size_t)len)
+				buf.clear();
+		}
+	}
+	fclose(f);
+	return !buf.empty();
+}
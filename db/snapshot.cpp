@@ -0,0 +1,1802 @@
+/**
+ * \file
+ * \brief Implementation of the Snapshot class, which saves the whole state of a Prog to a binary file and loads it
+ *        back.
+ *
+ * \copyright
+ * See the file "LICENSE.TERMS" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#include "snapshot.h"
+
+#include "prog.h"
+#include "proc.h"
+#include "cfg.h"
+#include "basicblock.h"
+#include "cluster.h"
+#include "rtl.h"
+#include "statement.h"
+#include "exp.h"
+#include "type.h"
+#include "signature.h"
+#include "dataflow.h"
+#include "frontend.h"
+#include "boomerang.h"
+#include "log.h"
+
+#include <typeinfo>
+
+#include <cstring>
+
+// The tags of the bodies of the numbered objects, after the prog
+enum { END_TAG = 0, CLUSTER_TAG = 'C', PROC_TAG = 'P', BB_TAG = 'B', STMT_TAG = 'S' };
+
+// When saving one proc, the other procs, and the return statements of callees, are written as EXTERNAL and an address
+enum { EXTERNAL = -3 };
+
+// Expressions, types and signatures are NULL, a reference to one already written, or written in full
+enum { NULL_REF = 0, OLD_REF = 1, NEW_REF = 2 };
+
+// Number the object p, if not already numbered, and return its number
+template <class T>
+static int number(T *p, std::map<T *, int> &ids, std::vector<T *> &list)
+{
+	typename std::map<T *, int>::iterator it = ids.find(p);
+	if (it != ids.end())
+		return it->second;
+	ids[p] = list.size();
+	list.push_back(p);
+	return list.size() - 1;
+}
+
+// The object numbered n, or NULL for -1. Anything else out of range clears ok
+template <class T>
+static T *numbered(int n, std::vector<T *> &list, Deserializer *in)
+{
+	if (n >= 0 && n < (int)list.size())
+		return list[n];
+	if (n != -1)
+		in->ok = false;
+	return NULL;
+}
+
+// Read a count of things, each taking at least a word of a file of maxWords words
+static int count(Deserializer *in, size_t maxWords)
+{
+	int n = in->word();
+	if (n < 0 || (size_t)n > maxWords) {
+		in->ok = false;
+		return 0;
+	}
+	return n;
+}
+
+// True if Signature::instantiate() makes signatures of the given platform and calling convention
+static bool canInstantiate(platform plat, callconv cc)
+{
+	switch (plat) {
+	case PLAT_PENTIUM: return cc == CONV_C || cc == CONV_PASCAL || cc == CONV_THISCALL;
+	case PLAT_SPARC:   return cc == CONV_C;
+	case PLAT_PPC:
+	case PLAT_ST20:    return true;
+	default:           return false;
+	}
+}
+
+/*==============================================================================
+ * FUNCTION:        Snapshot::save
+ * OVERVIEW:        Save the state of a Prog to a file
+ * PARAMETERS:      prog: the Prog to save
+ *                  fileName: the file to save it to. It is written under a temporary name and then renamed
+ * RETURNS:         True if saved
+ *============================================================================*/
+bool Snapshot::save(Prog *prog, const std::string &fileName)
+{
+	Snapshot snap;
+	snap.writeProg(prog);
+	if (!snap.out.ok) {
+		LOG << "can't save " << prog->getName() << ": it has something the snapshot format doesn't know\n";
+		return false;
+	}
+	Serializer file;
+	snap.finish(file);
+	return file.writeFile(fileName);
+}
+
+/*==============================================================================
+ * FUNCTION:        Snapshot::saveProc
+ * OVERVIEW:        Save the state of a decompiled proc, for ProcCache. Other procs are referred to by address, and the
+ *                  globals that the proc uses are saved with it. What the proc keeps from decoding when it is restored
+ *                  (its address, callers and cluster) is not saved
+ * PARAMETERS:      proc: the proc to save
+ *                  out: where to append it
+ * RETURNS:         True if saved
+ *============================================================================*/
+bool Snapshot::saveProc(UserProc *proc, Serializer &out)
+{
+	Snapshot snap;
+	snap.only = proc;
+	snap.id(proc);
+	snap.writeGlobals(proc);
+	snap.writeBodies();
+	if (!snap.out.ok)
+		return false;
+	snap.finish(out);
+	return true;
+}
+
+// Append the head and then the body to file. The classes of the numbered objects go in the head, so that the loader
+// can make them before reading any
+void Snapshot::finish(Serializer &file)
+{
+	file.word(MAGIC);
+	file.word(FORMAT_VERSION);
+	file.word(clusterList.size());
+	for (unsigned i = 0; i < clusterList.size(); i++) {
+		Cluster *c = clusterList[i];
+		file.word(dynamic_cast<Class *>(c) ? 2 : dynamic_cast<Module *>(c) ? 1 : 0);
+	}
+	file.word(procList.size());
+	for (unsigned i = 0; i < procList.size(); i++)
+		file.word(procList[i]->isLib());
+	file.word(bbList.size());
+	file.word(stmtList.size());
+	for (unsigned i = 0; i < stmtList.size(); i++)
+		file.word(stmtList[i]->kind);
+	file.buf += out.buf;
+}
+
+void Snapshot::writeProg(Prog *prog)
+{
+	out.str(prog->m_name.c_str());
+	out.str(prog->m_path.c_str());
+	out.word(prog->m_iNumberedProc);
+	id(prog->m_rootCluster);
+	out.word(prog->m_procs.size());
+	for (std::list<Proc *>::iterator it = prog->m_procs.begin(); it != prog->m_procs.end(); it++)
+		id(*it);
+	out.word(prog->m_procLabels.size());
+	for (PROGMAP::iterator it = prog->m_procLabels.begin(); it != prog->m_procLabels.end(); it++) {
+		out.word(it->first);
+		id(it->second);
+	}
+	out.word(prog->globals.size());
+	for (std::set<Global *>::iterator it = prog->globals.begin(); it != prog->globals.end(); it++) {
+		writeType((*it)->type);
+		out.word((*it)->uaddr);
+		out.str((*it)->nam.c_str());
+	}
+	writeDataMap(prog->globalMap);
+	out.word(prog->entryProcs.size());
+	for (std::list<UserProc *>::iterator it = prog->entryProcs.begin(); it != prog->entryProcs.end(); it++)
+		id(*it);
+	writeBodies();
+}
+
+// The globals that proc uses, so that they can be made if the prog it is restored into doesn't have them yet
+void Snapshot::writeGlobals(UserProc *proc)
+{
+	std::list<Exp *> used;
+	Exp *search = new Location(opGlobal, new Terminal(opWild), proc);
+	StatementList stmts;
+	proc->getStatements(stmts);
+	for (StatementList::iterator it = stmts.begin(); it != stmts.end(); it++)
+		(*it)->searchAll(search, used);
+	std::map<std::string, Global *> globals;
+	for (std::list<Exp *>::iterator it = used.begin(); it != used.end(); it++) {
+		const char *name = ((Const *)(*it)->getSubExp1())->getStr();
+		Global *global = proc->prog->getGlobal(name);
+		if (global)
+			globals[name] = global;
+	}
+	out.word(globals.size());
+	for (std::map<std::string, Global *>::iterator it = globals.begin(); it != globals.end(); it++) {
+		out.str(it->first.c_str());
+		out.word(it->second->uaddr);
+		writeType(it->second->type);
+	}
+}
+
+// The bodies of the numbered objects, in order, including those first seen in the bodies of others
+void Snapshot::writeBodies()
+{
+	unsigned nc = 0, np = 0, nb = 0, ns = 0;
+	while (out.ok) {
+		if (nc < clusterList.size()) {
+			out.word(CLUSTER_TAG);
+			writeCluster(clusterList[nc++]);
+		} else if (np < procList.size()) {
+			out.word(PROC_TAG);
+			writeProc(procList[np++]);
+		} else if (nb < bbList.size()) {
+			out.word(BB_TAG);
+			writeBB(bbList[nb++]);
+		} else if (ns < stmtList.size()) {
+			out.word(STMT_TAG);
+			writeStmt(stmtList[ns++]);
+		} else
+			break;
+	}
+	out.word(END_TAG);
+}
+
+void Snapshot::id(Cluster *c)
+{
+	out.word(c ? number(c, clusterIds, clusterList) : -1);
+}
+
+// Deleted procs are left in Prog::m_procLabels as -1. When saving one proc, the others are written by address
+void Snapshot::id(Proc *p)
+{
+	if (only && p && p != (Proc *)-1 && p != only) {
+		out.word(EXTERNAL);
+		out.word(p->address);
+		return;
+	}
+	out.word(p == NULL ? -1 : p == (Proc *)-1 ? -2 : number(p, procIds, procList));
+}
+
+void Snapshot::id(BasicBlock *bb)
+{
+	out.word(bb ? number(bb, bbIds, bbList) : -1);
+}
+
+// A wildcard definition is -1. When saving one proc, the only statements of other procs are the return statements of
+// callees, written by the address of the callee
+void Snapshot::id(Statement *s)
+{
+	if (only && s && s != (Statement *)-1 && s->proc != only) {
+		UserProc *callee = s->proc;
+		if (callee == NULL || callee->theReturnStatement != s) {
+			LOG << "statement " << s << " of another proc in snapshot of " << only->getName() << "\n";
+			out.ok = false;
+			return;
+		}
+		out.word(EXTERNAL);
+		out.word(callee->address);
+		return;
+	}
+	out.word(s == NULL ? -1 : s == (Statement *)-1 ? -2 : number(s, stmtIds, stmtList));
+}
+
+void Snapshot::writeCluster(Cluster *c)
+{
+	out.str(c->name.c_str());
+	out.word(c->children.size());
+	for (unsigned i = 0; i < c->children.size(); i++)
+		id(c->children[i]);
+}
+
+void Snapshot::writeProc(Proc *p)
+{
+	// What a proc restored by loadProc() keeps from decoding
+	if (only == NULL) {
+		out.word(p->address);
+		id(p->m_firstCaller);
+		out.word(p->m_firstCallerAddr);
+		out.word(p->callerSet.size());
+		for (std::set<CallStatement *>::iterator it = p->callerSet.begin(); it != p->callerSet.end(); it++)
+			id(*it);
+		id(p->cluster);
+	}
+	writeSig(p->signature);
+	writeExpMap(p->provenTrue);
+	writeExpMap(p->recurPremises);
+	if (p->isLib())
+		return;
+
+	UserProc *u = (UserProc *)p;
+	out.word(u->status);
+	out.word(u->locals.size());
+	for (std::map<std::string, Type *>::iterator it = u->locals.begin(); it != u->locals.end(); it++) {
+		out.str(it->first.c_str());
+		writeType(it->second);
+	}
+	out.word(u->nextLocal);
+	out.word(u->nextParam);
+	out.word(u->symbolMap.size());
+	for (UserProc::SymbolMap::iterator it = u->symbolMap.begin(); it != u->symbolMap.end(); it++) {
+		writeExp(it->first);
+		writeExp(it->second);
+	}
+	writeDataMap(u->localTable);
+	out.word(u->calleeList.size());
+	for (std::list<Proc *>::iterator it = u->calleeList.begin(); it != u->calleeList.end(); it++)
+		id(*it);
+	writeUses(u->col);
+	writeStmts(u->parameters);
+	writeLocs(u->addressEscapedVars);
+	out.word(u->stmtNumber);
+	out.word(u->stackMap.size());
+	for (std::map<int, Type *>::iterator it = u->stackMap.begin(); it != u->stackMap.end(); it++) {
+		out.word(it->first);
+		writeType(it->second);
+	}
+	id(u->theReturnStatement);
+	out.word(u->DFGcount);
+	out.word(u->cfg != NULL);
+	if (u->cfg)
+		writeCfg(u->cfg);
+	writeDataFlow(u->df);
+}
+
+// The dominator and phi placement tables that the passes after PROC_FINAL still use (see
+// DataFlow::releaseWorkingSets()). The working sets are not saved
+void Snapshot::writeDataFlow(DataFlow &df)
+{
+	out.word(df.BBs.size());
+	for (unsigned i = 0; i < df.BBs.size(); i++)
+		id(df.BBs[i]);
+	out.word(df.idom.size());
+	for (unsigned i = 0; i < df.idom.size(); i++)
+		out.word(df.idom[i]);
+	out.word(df.DF.size());
+	for (unsigned i = 0; i < df.DF.size(); i++)
+		writeBits(df.DF[i]);
+	out.word(df.locs.size());
+	for (unsigned i = 0; i < df.locs.size(); i++)
+		writeExp(df.locs[i]);
+	out.word(df.A_orig.size());
+	for (unsigned i = 0; i < df.A_orig.size(); i++)
+		writeBits(df.A_orig[i]);
+	out.word(df.defsites.size());
+	for (unsigned i = 0; i < df.defsites.size(); i++)
+		writeBits(df.defsites[i]);
+	out.word(df.A_phi.size());
+	for (std::map<Exp *, BitSet, lessExpStar>::iterator it = df.A_phi.begin(); it != df.A_phi.end(); it++) {
+		writeExp(it->first);
+		writeBits(it->second);
+	}
+	out.word(df.renameLocalsAndParams);
+}
+
+void Snapshot::writeBits(BitSet &bs)
+{
+	out.word(bs.count());
+	for (int i = bs.first(); i != -1; i = bs.next(i + 1))
+		out.word(i);
+}
+
+void Snapshot::writeCfg(Cfg *cfg)
+{
+	out.word(cfg->m_listBB.size());
+	for (std::list<PBB>::iterator it = cfg->m_listBB.begin(); it != cfg->m_listBB.end(); it++)
+		id(*it);
+	out.word(cfg->Ordering.size());
+	for (unsigned i = 0; i < cfg->Ordering.size(); i++)
+		id(cfg->Ordering[i]);
+	out.word(cfg->revOrdering.size());
+	for (unsigned i = 0; i < cfg->revOrdering.size(); i++)
+		id(cfg->revOrdering[i]);
+	out.word(cfg->m_mapBB.size());
+	for (MAPBB::iterator it = cfg->m_mapBB.begin(); it != cfg->m_mapBB.end(); it++) {
+		out.word(it->first);
+		id(it->second);
+	}
+	id(cfg->entryBB);
+	id(cfg->exitBB);
+	out.word(cfg->m_bWellFormed);
+	out.word(cfg->structured);
+	out.word(cfg->callSites.size());
+	for (std::set<CallStatement *>::iterator it = cfg->callSites.begin(); it != cfg->callSites.end(); it++)
+		id(*it);
+	out.word(cfg->lastLabel);
+	out.word(cfg->implicitMap.size());
+	for (std::map<Exp *, Statement *, lessExpStar>::iterator it = cfg->implicitMap.begin(); it != cfg->implicitMap.end(); it++) {
+		writeExp(it->first);
+		id(it->second);
+	}
+	out.word(cfg->bImplicitsDone);
+}
+
+void Snapshot::writeBB(BasicBlock *bb)
+{
+	out.word(bb->m_nodeType);
+	out.word(bb->m_pRtls != NULL);
+	if (bb->m_pRtls) {
+		out.word(bb->m_pRtls->size());
+		for (std::list<RTL *>::iterator it = bb->m_pRtls->begin(); it != bb->m_pRtls->end(); it++)
+			writeRtl(*it);
+	}
+	out.word(bb->m_iLabelNum);
+	out.str(bb->m_labelStr.c_str());
+	out.word(bb->m_labelneeded);
+	out.word(bb->m_bIncomplete);
+	out.word(bb->m_bJumpReqd);
+	out.word(bb->m_InEdges.size());
+	for (unsigned i = 0; i < bb->m_InEdges.size(); i++)
+		id(bb->m_InEdges[i]);
+	out.word(bb->m_OutEdges.size());
+	for (unsigned i = 0; i < bb->m_OutEdges.size(); i++)
+		id(bb->m_OutEdges[i]);
+	out.word(bb->m_iNumInEdges);
+	out.word(bb->m_iNumOutEdges);
+	out.word(bb->m_iTraversed);
+	writeLocs(bb->liveIn);
+
+	out.word(bb->m_DFTfirst);
+	out.word(bb->m_DFTlast);
+	out.word(bb->m_DFTrevfirst);
+	out.word(bb->m_DFTrevlast);
+	out.word(bb->m_structType);
+	out.word(bb->m_loopCondType);
+	id(bb->m_loopHead);
+	id(bb->m_caseHead);
+	id(bb->m_condFollow);
+	id(bb->m_loopFollow);
+	id(bb->m_latchNode);
+
+	out.word(bb->ord);
+	out.word(bb->revOrd);
+	out.word(bb->inEdgesVisited);
+	out.word(bb->numForwardInEdges);
+	out.word(bb->loopStamps[0]);
+	out.word(bb->loopStamps[1]);
+	out.word(bb->revLoopStamps[0]);
+	out.word(bb->revLoopStamps[1]);
+	out.word(bb->traversed);
+	out.word(bb->hllLabel);
+	out.word(bb->indentLevel);
+	id(bb->immPDom);
+	id(bb->loopHead);
+	id(bb->caseHead);
+	id(bb->condFollow);
+	id(bb->loopFollow);
+	id(bb->latchNode);
+	out.word(bb->sType);
+	out.word(bb->usType);
+	out.word(bb->lType);
+	out.word(bb->cType);
+	out.word(bb->overlappedRegProcessingDone);
+}
+
+// RTLs are not shared, so are written in full, with their statements by number
+void Snapshot::writeRtl(RTL *r)
+{
+	out.word(r != NULL);
+	if (r == NULL)
+		return;
+	out.word(r->nativeAddr);
+	out.word(r->stmtList.size());
+	for (std::list<Statement *>::iterator it = r->stmtList.begin(); it != r->stmtList.end(); it++)
+		id(*it);
+}
+
+void Snapshot::writeStmt(Statement *s)
+{
+	out.word(s->number);
+	id(s->pbb);
+	id(s->proc);
+	id(s->parent);
+	if (s->isAssignment()) {
+		Assignment *a = (Assignment *)s;
+		writeType(a->type);
+		writeExp(a->lhs);
+	}
+	switch (s->kind) {
+	case STMT_ASSIGN:
+		writeExp(((Assign *)s)->rhs);
+		writeExp(((Assign *)s)->guard);
+		break;
+	case STMT_PHIASSIGN:
+		{
+			PhiAssign::Definitions &defs = ((PhiAssign *)s)->defVec;
+			out.word(defs.size());
+			for (PhiAssign::iterator it = defs.begin(); it != defs.end(); it++) {
+				id(it->def);
+				writeExp(it->e);
+			}
+			break;
+		}
+	case STMT_IMPASSIGN:
+	case STMT_JUNCTION:
+		break;
+	case STMT_BOOLASSIGN:
+		{
+			BoolAssign *b = (BoolAssign *)s;
+			out.word(b->jtCond);
+			writeExp(b->pCond);
+			out.word(b->bFloat);
+			out.word(b->size);
+			break;
+		}
+	case STMT_IMPREF:
+		writeType(((ImpRefStatement *)s)->type);
+		writeExp(((ImpRefStatement *)s)->addressExp);
+		break;
+	case STMT_GOTO:
+	case STMT_BRANCH:
+	case STMT_CASE:
+	case STMT_CALL:
+		{
+			GotoStatement *g = (GotoStatement *)s;
+			writeExp(g->pDest);
+			out.word(g->m_isComputed);
+			if (s->kind == STMT_BRANCH) {
+				BranchStatement *b = (BranchStatement *)s;
+				out.word(b->jtCond);
+				writeExp(b->pCond);
+				out.word(b->bFloat);
+				out.word(b->size);
+			} else if (s->kind == STMT_CASE) {
+				SWITCH_INFO *si = ((CaseStatement *)s)->pSwitchInfo;
+				out.word(si != NULL);
+				if (si == NULL)
+					break;
+				writeExp(si->pSwitchVar);
+				out.word(si->chForm);
+				out.word(si->iLower);
+				out.word(si->iUpper);
+				out.word(si->uTable);
+				out.word(si->iNumTable);
+				out.word(si->iOffset);
+				if (si->chForm == 'F')  // uTable has the address of an array of the values
+					for (int i = 0; i < si->iNumTable; i++)
+						out.word(((int *)si->uTable)[i]);
+			} else if (s->kind == STMT_CALL) {
+				CallStatement *c = (CallStatement *)s;
+				out.word(c->returnAfterCall);
+				writeStmts(c->arguments);
+				writeStmts(c->defines);
+				id(c->procDest);
+				writeSig(c->signature);
+				writeUses(c->useCol);
+				writeDefs(c->defCol);
+				id(c->calleeReturn);
+			}
+			break;
+		}
+	case STMT_RET:
+		{
+			ReturnStatement *r = (ReturnStatement *)s;
+			out.word(r->retAddr);
+			writeDefs(r->col);
+			writeStmts(r->modifieds);
+			writeStmts(r->returns);
+			break;
+		}
+	default:
+		LOG << "unknown statement kind " << s->kind << " in snapshot\n";
+		out.ok = false;
+		break;
+	}
+}
+
+void Snapshot::writeExp(Exp *e)
+{
+	if (e == NULL) {
+		out.word(NULL_REF);
+		return;
+	}
+	std::map<Exp *, int>::iterator it = expIds.find(e);
+	if (it != expIds.end()) {
+		out.word(OLD_REF);
+		out.word(it->second);
+		return;
+	}
+	int n = expIds.size();
+	expIds[e] = n;
+	out.word(NEW_REF);
+
+	// The class goes first, as the operator doesn't always give it (e.g. opMemOf is a Location or a Unary)
+	int cls;
+	if (dynamic_cast<Const *>(e))         cls = 'c';
+	else if (dynamic_cast<TypeVal *>(e))  cls = 'v';
+	else if (dynamic_cast<Terminal *>(e)) cls = 't';
+	else if (dynamic_cast<Location *>(e)) cls = 'l';
+	else if (dynamic_cast<RefExp *>(e))   cls = 'r';
+	else if (dynamic_cast<FlagDef *>(e))  cls = 'f';
+	else if (dynamic_cast<TypedExp *>(e)) cls = 'y';
+	else if (dynamic_cast<Ternary *>(e))  cls = '3';
+	else if (dynamic_cast<Binary *>(e))   cls = '2';
+	else if (dynamic_cast<Unary *>(e))    cls = '1';
+	else {
+		LOG << "unknown expression class in snapshot\n";
+		out.ok = false;
+		return;
+	}
+	out.word(cls);
+	out.word(e->op);
+	out.word(e->interned | (e->canonical << 1));
+	switch (cls) {
+	case 'c':
+		{
+			Const *c = (Const *)e;
+			out.word(c->conscript);
+			writeType(c->type);
+			switch (e->op) {
+			case opLongConst:
+				out.word((int)c->u.ll);
+				out.word((int)(c->u.ll >> 32));
+				break;
+			case opFltConst:
+				{
+					int w[2];
+					memcpy(w, &c->u.d, sizeof(w));
+					out.word(w[0]);
+					out.word(w[1]);
+					break;
+				}
+			case opStrConst:
+				out.str(c->u.p);
+				break;
+			case opFuncConst:
+				id(c->u.pp);
+				break;
+			default:
+				out.word(c->u.i);
+				break;
+			}
+			break;
+		}
+	case 'v':
+		writeType(((TypeVal *)e)->val);
+		break;
+	case 't':
+		break;
+	case 'l':
+		id(((Location *)e)->proc);
+		writeExp(e->getSubExp1());
+		break;
+	case 'r':
+		writeExp(e->getSubExp1());
+		id(((RefExp *)e)->def);
+		break;
+	case 'f':
+		writeExp(e->getSubExp1());
+		writeRtl(((FlagDef *)e)->rtl);
+		break;
+	case 'y':
+		writeType(((TypedExp *)e)->type);
+		writeExp(e->getSubExp1());
+		break;
+	case '3':
+		writeExp(e->getSubExp1());
+		writeExp(e->getSubExp2());
+		writeExp(e->getSubExp3());
+		break;
+	case '2':
+		writeExp(e->getSubExp1());
+		writeExp(e->getSubExp2());
+		break;
+	case '1':
+		writeExp(e->getSubExp1());
+		break;
+	}
+}
+
+void Snapshot::writeType(Type *ty)
+{
+	if (ty == NULL) {
+		out.word(NULL_REF);
+		return;
+	}
+	std::map<Type *, int>::iterator it = typeIds.find(ty);
+	if (it != typeIds.end()) {
+		out.word(OLD_REF);
+		out.word(it->second);
+		return;
+	}
+	int n = typeIds.size();
+	typeIds[ty] = n;
+	out.word(NEW_REF);
+
+	eType id = ty->getId();
+	if (ty->isLower())
+		id = eLower;  // LowerType has the id of an UpperType
+	out.word(id);
+	switch (id) {
+	case eVoid:
+	case eBoolean:
+	case eChar:
+		break;
+	case eFunc:
+		writeSig(((FuncType *)ty)->signature);
+		break;
+	case eInteger:
+		out.word(((IntegerType *)ty)->size);
+		out.word(((IntegerType *)ty)->signedness);
+		break;
+	case eFloat:
+		out.word(((FloatType *)ty)->size);
+		break;
+	case ePointer:
+		writeType(((PointerType *)ty)->points_to);
+		break;
+	case eArray:
+		writeType(((ArrayType *)ty)->base_type);
+		out.word(((ArrayType *)ty)->length);
+		break;
+	case eNamed:
+		out.str(((NamedType *)ty)->name.c_str());
+		break;
+	case eCompound:
+		{
+			CompoundType *c = (CompoundType *)ty;
+			out.word(c->types.size());
+			for (unsigned i = 0; i < c->types.size(); i++) {
+				writeType(c->types[i]);
+				out.str(c->names[i].c_str());
+			}
+			out.word(c->nextGenericMemberNum);
+			out.word(c->generic);
+			break;
+		}
+	case eUnion:
+		{
+			std::list<UnionElement> &li = ((UnionType *)ty)->li;
+			out.word(li.size());
+			for (std::list<UnionElement>::iterator it = li.begin(); it != li.end(); it++) {
+				writeType(it->type);
+				out.str(it->name.c_str());
+			}
+			break;
+		}
+	case eSize:
+		out.word(((SizeType *)ty)->size);
+		break;
+	case eUpper:
+		writeType(((UpperType *)ty)->getBaseType());
+		break;
+	case eLower:
+		writeType(((LowerType *)ty)->getBaseType());
+		break;
+	default:
+		LOG << "unknown type in snapshot\n";
+		out.ok = false;
+		break;
+	}
+}
+
+// As for the precompiled signature files, the class of a signature is given by its platform and calling convention
+// (see Signature::instantiate()), or is a CustomSignature or a plain Signature
+void Snapshot::writeSig(Signature *s)
+{
+	if (s == NULL) {
+		out.word(NULL_REF);
+		return;
+	}
+	std::map<Signature *, int>::iterator it = sigIds.find(s);
+	if (it != sigIds.end()) {
+		out.word(OLD_REF);
+		out.word(it->second);
+		return;
+	}
+	int n = sigIds.size();
+	sigIds[s] = n;
+	out.word(NEW_REF);
+
+	CustomSignature *cs = dynamic_cast<CustomSignature *>(s);
+	if (cs) {
+		out.word('C');
+		out.word(cs->sp);
+	} else if (typeid(*s) == typeid(Signature))
+		out.word('G');
+	else if (canInstantiate(s->getPlatform(), s->getConvention())) {
+		out.word('S');
+		out.word(s->getPlatform());
+		out.word(s->getConvention());
+	} else {
+		LOG << "can't save the signature of " << s->getName() << " in snapshot\n";
+		out.ok = false;
+		return;
+	}
+	out.str(s->name.c_str());
+	out.str(s->sigFile.c_str());
+	out.word(s->params.size());
+	for (unsigned i = 0; i < s->params.size(); i++) {
+		Parameter *param = s->params[i];
+		writeType(param->type);
+		out.str(param->name.c_str());
+		writeExp(param->exp);
+		out.str(param->boundMax.c_str());
+	}
+	out.word(s->returns.size());
+	for (unsigned i = 0; i < s->returns.size(); i++) {
+		writeType(s->returns[i]->type);
+		writeExp(s->returns[i]->exp);
+	}
+	writeType(s->rettype);
+	out.word(s->ellipsis);
+	out.word(s->unknown);
+	out.word(s->forced);
+	writeType(s->preferedReturn);
+	out.str(s->preferedName.c_str());
+	out.word(s->preferedParams.size());
+	for (unsigned i = 0; i < s->preferedParams.size(); i++)
+		out.word(s->preferedParams[i]);
+}
+
+void Snapshot::writeStmts(StatementList &sl)
+{
+	out.word(sl.size());
+	for (StatementList::iterator it = sl.begin(); it != sl.end(); it++)
+		id(*it);
+}
+
+void Snapshot::writeLocs(LocationSet &ls)
+{
+	out.word(ls.size());
+	for (LocationSet::iterator it = ls.begin(); it != ls.end(); it++)
+		writeExp(*it);
+}
+
+void Snapshot::writeDefs(DefCollector &dc)
+{
+	out.word(dc.initialised);
+	out.word(dc.defs.size());
+	for (AssignSet::iterator it = dc.defs.begin(); it != dc.defs.end(); it++)
+		id(*it);
+}
+
+void Snapshot::writeUses(UseCollector &uc)
+{
+	out.word(uc.initialised);
+	writeLocs(uc.locs);
+}
+
+void Snapshot::writeExpMap(std::map<Exp *, Exp *, lessExpStar> &m)
+{
+	out.word(m.size());
+	for (std::map<Exp *, Exp *, lessExpStar>::iterator it = m.begin(); it != m.end(); it++) {
+		writeExp(it->first);
+		writeExp(it->second);
+	}
+}
+
+void Snapshot::writeDataMap(DataIntervalMap &dim)
+{
+	out.word(dim.dimap.size());
+	for (std::map<ADDRESS, DataInterval>::iterator it = dim.dimap.begin(); it != dim.dimap.end(); it++) {
+		out.word(it->first);
+		out.word(it->second.size);
+		out.str(it->second.name.c_str());
+		writeType(it->second.type);
+	}
+}
+
+/*==============================================================================
+ * FUNCTION:        Snapshot::read
+ * OVERVIEW:        Read the state of a Prog saved by save(). The binary file is not loaded, so the Prog has no front
+ *                  end; see load()
+ * PARAMETERS:      fileName: the file to read
+ * RETURNS:         The Prog, or NULL if the file can't be read, or is not a snapshot of this version
+ *============================================================================*/
+Prog *Snapshot::read(const std::string &fileName)
+{
+	std::vector<char> buf;
+	if (!Deserializer::readFile(fileName, buf))
+		return NULL;
+	Deserializer d(&buf[0], buf.size());
+	Snapshot snap;
+	snap.in = &d;
+	snap.prog = new Prog();
+	if (!snap.readHead()) {
+		LOG << fileName.c_str() << " is not a snapshot of this version of boomerang\n";
+		return NULL;
+	}
+	snap.readProg();
+	if (!d.ok || !d.atEnd()) {
+		LOG << "snapshot " << fileName.c_str() << " is damaged at offset " << (int)d.offset() << "\n";
+		return NULL;
+	}
+	return snap.prog;
+}
+
+/*==============================================================================
+ * FUNCTION:        Snapshot::load
+ * OVERVIEW:        Read the state of a Prog saved by save(), and load the binary file it was decompiled from
+ * PARAMETERS:      fileName: the file to read
+ * RETURNS:         The Prog, or NULL if the file can't be read, or the binary file can't be loaded
+ *============================================================================*/
+Prog *Snapshot::load(const std::string &fileName)
+{
+	Prog *prog = read(fileName);
+	if (prog == NULL)
+		return NULL;
+	std::string binary = prog->m_path + prog->m_name;
+	FrontEnd *pFE = FrontEnd::Load(binary.c_str(), prog);
+	if (pFE == NULL) {
+		LOG << "can't load " << binary.c_str() << ", the binary file of snapshot " << fileName.c_str() << "\n";
+		return NULL;
+	}
+	// Keep the clusters the procs are in, rather than the new root cluster that setFrontEnd() makes
+	Cluster *root = prog->m_rootCluster;
+	prog->setFrontEnd(pFE);
+	prog->m_rootCluster = root;
+	pFE->readLibraryCatalog();
+	return prog;
+}
+
+/*==============================================================================
+ * FUNCTION:        Snapshot::loadProc
+ * OVERVIEW:        Restore the state of a proc saved by saveProc(), and make the globals it uses that the prog doesn't
+ *                  have yet
+ * PARAMETERS:      proc: the proc to restore, which has been decoded but not decompiled
+ *                  in: the rest of which is the saved state
+ * RETURNS:         False, with proc as it was, if the state can't be restored: e.g. a callee is missing, or a global
+ *                  has another name in this prog
+ *============================================================================*/
+bool Snapshot::loadProc(UserProc *proc, Deserializer &in)
+{
+	// Read it into a scratch proc first, so that proc is only changed if all of it can be read
+	Deserializer trial(in);
+	UserProc *scratch = new UserProc();
+	scratch->prog = proc->prog;
+	scratch->address = proc->address;
+	std::vector<Global *> newGlobals;
+	{
+		Snapshot snap;
+		snap.only = scratch;
+		snap.prog = proc->prog;
+		snap.in = &trial;
+		if (!snap.readProcState(newGlobals))
+			return false;
+	}
+
+	// Forget the decoded state; the saved state replaces it
+	proc->provenTrue.clear();
+	proc->recurPremises.clear();
+	proc->locals.clear();
+	proc->symbolMap.clear();
+	proc->localTable.dimap.clear();
+	proc->calleeList.clear();
+	proc->col.clear();
+	proc->parameters.clear();
+	proc->addressEscapedVars.clear();
+	proc->stackMap.clear();
+	proc->df = DataFlow();
+	newGlobals.clear();
+	Snapshot snap;
+	snap.only = proc;
+	snap.prog = proc->prog;
+	snap.in = &in;
+	if (!snap.readProcState(newGlobals))
+		return false;  // Can't happen: it was all read once already
+	for (unsigned i = 0; i < newGlobals.size(); i++)
+		proc->prog->addGlobal(newGlobals[i]);
+	proc->defUses.invalidate();
+
+	// The callees' caller sets are only saved with the whole prog, and initStatements() (which would add the calls
+	// via setSigArguments()) isn't run for a restored proc
+	StatementList stmts;
+	proc->getStatements(stmts);
+	for (StatementList::iterator it = stmts.begin(); it != stmts.end(); it++) {
+		if (!(*it)->isCall()) continue;
+		Proc *dest = ((CallStatement *)*it)->getDestProc();
+		if (dest)
+			dest->addCaller((CallStatement *)*it);
+	}
+	return true;
+}
+
+// Read what saveProc() wrote into only. The globals that it uses that the prog doesn't have are added to newGlobals
+bool Snapshot::readProcState(std::vector<Global *> &newGlobals)
+{
+	if (!readHead() || proc() != only)
+		return false;
+	for (int n = count(in, in->left() / 4); in->ok && n > 0; n--) {
+		std::string name = in->str();
+		ADDRESS a = in->word();
+		Type *ty = readType();
+		Global *named = prog->getGlobal(name.c_str());
+		Global *at = prog->findGlobalAt(a);
+		if (named == NULL && at == NULL)
+			newGlobals.push_back(new Global(ty, a, name.c_str()));
+		else if (named != at || named->uaddr != a)
+			in->ok = false;  // Has another name (or address) in this prog
+	}
+	readBodies();
+	return in->ok && in->atEnd();
+}
+
+// Check the magic word and the version, and make the numbered objects, so that references to them can be resolved as
+// they are read. When reading one proc, it is the one proc declared
+bool Snapshot::readHead()
+{
+	if (in->word() != MAGIC || in->word() != FORMAT_VERSION) {
+		in->ok = false;
+		return false;
+	}
+	size_t maxWords = in->left() / 4;
+	for (int n = count(in, maxWords); in->ok && n > 0; n--) {
+		switch (in->word()) {
+		case 0:  clusters.push_back(new Cluster()); break;
+		case 1:  clusters.push_back(new Module("")); break;
+		case 2:  clusters.push_back(new Class("")); break;
+		default: in->ok = false; break;
+		}
+	}
+	for (int n = count(in, maxWords); in->ok && n > 0; n--) {
+		Proc *p;
+		bool isLib = in->word() != 0;
+		if (only) {
+			if (isLib || procs.size()) {
+				in->ok = false;
+				break;
+			}
+			p = only;
+		} else if (isLib)
+			p = new LibProc();
+		else
+			p = new UserProc();
+		p->prog = prog;
+		procs.push_back(p);
+	}
+	for (int n = count(in, maxWords); in->ok && n > 0; n--)
+		bbs.push_back(new BasicBlock());
+	for (int n = count(in, maxWords); in->ok && n > 0; n--) {
+		Statement *s;
+		int kind = in->word();
+		switch (kind) {
+		case STMT_ASSIGN:     s = new Assign(); break;
+		case STMT_PHIASSIGN:  s = new PhiAssign((Exp *)NULL); break;
+		case STMT_IMPASSIGN:  s = new ImplicitAssign((Exp *)NULL); break;
+		case STMT_BOOLASSIGN: s = new BoolAssign(0); break;
+		case STMT_CALL:       s = new CallStatement(); break;
+		case STMT_RET:        s = new ReturnStatement(); break;
+		case STMT_BRANCH:     s = new BranchStatement(); break;
+		case STMT_GOTO:       s = new GotoStatement(); break;
+		case STMT_CASE:       s = new CaseStatement(); break;
+		case STMT_IMPREF:     s = new ImpRefStatement(NULL, NULL); break;
+		case STMT_JUNCTION:   s = new JunctionStatement(); break;
+		default:              in->ok = false; return false;
+		}
+		s->kind = (STMT_KIND)kind;
+		stmts.push_back(s);
+	}
+	return in->ok;
+}
+
+void Snapshot::readProg()
+{
+	size_t maxWords = in->left() / 4;
+	prog->m_name = in->str();
+	prog->m_path = in->str();
+	prog->m_iNumberedProc = in->word();
+	prog->m_rootCluster = cluster();
+	for (int n = count(in, maxWords); in->ok && n > 0; n--)
+		prog->m_procs.push_back(proc());
+	for (int n = count(in, maxWords); in->ok && n > 0; n--) {
+		ADDRESS a = in->word();
+		prog->m_procLabels[a] = proc();
+	}
+	for (int n = count(in, maxWords); in->ok && n > 0; n--) {
+		Type *ty = readType();
+		ADDRESS a = in->word();
+		std::string name = in->str();
+		prog->addGlobal(new Global(ty, a, name.c_str()));
+	}
+	readDataMap(prog->globalMap);
+	for (int n = count(in, maxWords); in->ok && n > 0; n--)
+		prog->entryProcs.push_back((UserProc *)proc());
+	readBodies();
+	if (prog->m_rootCluster == NULL)
+		in->ok = false;
+}
+
+// Read the bodies of the numbered objects, and check that there is one for each
+void Snapshot::readBodies()
+{
+	unsigned nc = 0, np = 0, nb = 0, ns = 0;
+	while (in->ok) {
+		int tag = in->word();
+		if (tag == END_TAG)
+			break;
+		if (tag == CLUSTER_TAG && nc < clusters.size())
+			readCluster(clusters[nc++]);
+		else if (tag == PROC_TAG && np < procs.size())
+			readProc(procs[np++]);
+		else if (tag == BB_TAG && nb < bbs.size())
+			readBB(bbs[nb++]);
+		else if (tag == STMT_TAG && ns < stmts.size())
+			readStmt(stmts[ns++]);
+		else
+			in->ok = false;
+	}
+	if (!in->ok || nc != clusters.size() || np != procs.size() || nb != bbs.size() || ns != stmts.size()) {
+		in->ok = false;
+		return;
+	}
+
+	// Now that the left hand sides are known
+	for (std::list<std::pair<DefCollector *, int> >::iterator it = pendingDefs.begin(); it != pendingDefs.end(); it++) {
+		Statement *s = numbered(it->second, stmts, in);
+		if (s == NULL || !s->isAssign()) {
+			in->ok = false;
+			return;
+		}
+		it->first->defs.insert((Assign *)s);
+	}
+}
+
+Cluster *Snapshot::cluster()
+{
+	return numbered(in->word(), clusters, in);
+}
+
+Proc *Snapshot::proc()
+{
+	int n = in->word();
+	if (n == -2)
+		return (Proc *)-1;
+	if (n == EXTERNAL && only) {
+		Proc *p = prog->findProc(in->word());
+		if (p == NULL)
+			in->ok = false;  // Not in this prog
+		return p;
+	}
+	return numbered(n, procs, in);
+}
+
+BasicBlock *Snapshot::bb()
+{
+	return numbered(in->word(), bbs, in);
+}
+
+Statement *Snapshot::stmt()
+{
+	int n = in->word();
+	if (n == -2)
+		return (Statement *)-1;
+	if (n == EXTERNAL && only) {
+		Proc *callee = prog->findProc(in->word());
+		if (callee == NULL || callee->isLib() || ((UserProc *)callee)->theReturnStatement == NULL) {
+			in->ok = false;
+			return NULL;
+		}
+		return ((UserProc *)callee)->theReturnStatement;
+	}
+	return numbered(n, stmts, in);
+}
+
+void Snapshot::readCluster(Cluster *c)
+{
+	c->name = in->str();
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		Cluster *child = cluster();
+		if (child)
+			c->addChild(child);
+	}
+}
+
+void Snapshot::readProc(Proc *p)
+{
+	if (only == NULL) {
+		p->address = in->word();
+		p->m_firstCaller = proc();
+		p->m_firstCallerAddr = in->word();
+		for (int n = in->word(); in->ok && n > 0; n--)
+			p->callerSet.insert((CallStatement *)stmt());
+		p->cluster = cluster();
+	}
+	p->signature = readSig();
+	readExpMap(p->provenTrue);
+	readExpMap(p->recurPremises);
+	if (p->isLib())
+		return;
+
+	UserProc *u = (UserProc *)p;
+	u->status = (ProcStatus)in->word();
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		std::string name = in->str();
+		u->locals[name] = readType();
+	}
+	u->nextLocal = in->word();
+	u->nextParam = in->word();
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		Exp *from = readExp();
+		Exp *to = readExp();
+		if (in->ok)
+			u->symbolMap.insert(std::pair<Exp *, Exp *>(from, to));
+	}
+	readDataMap(u->localTable);
+	for (int n = in->word(); in->ok && n > 0; n--)
+		u->calleeList.push_back(proc());
+	readUses(u->col);
+	readStmts(u->parameters);
+	readLocs(u->addressEscapedVars);
+	u->stmtNumber = in->word();
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		int offset = in->word();
+		u->stackMap[offset] = readType();
+	}
+	u->theReturnStatement = (ReturnStatement *)stmt();
+	u->DFGcount = in->word();
+	if (in->word()) {
+		u->cfg = new Cfg();
+		u->cfg->setProc(u);
+		readCfg(u->cfg);
+	}
+	readDataFlow(u->df);
+}
+
+void Snapshot::readDataFlow(DataFlow &df)
+{
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		PBB b = bb();
+		df.indices[b] = df.BBs.size();
+		df.BBs.push_back(b);
+	}
+	for (int n = in->word(); in->ok && n > 0; n--)
+		df.idom.push_back(in->word());
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		df.DF.push_back(BitSet());
+		readBits(df.DF.back());
+	}
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		Exp *e = readExp();
+		df.locNums[e] = df.locs.size();
+		df.locs.push_back(e);
+	}
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		df.A_orig.push_back(BitSet());
+		readBits(df.A_orig.back());
+	}
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		df.defsites.push_back(BitSet());
+		readBits(df.defsites.back());
+	}
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		Exp *e = readExp();
+		readBits(df.A_phi[e]);
+	}
+	df.renameLocalsAndParams = in->word() != 0;
+}
+
+void Snapshot::readBits(BitSet &bs)
+{
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		int i = in->word();
+		if (i < 0 || i >= 0x1000000) {  // Don't make huge sets from a damaged file
+			in->ok = false;
+			return;
+		}
+		bs.set(i);
+	}
+}
+
+void Snapshot::readCfg(Cfg *cfg)
+{
+	for (int n = in->word(); in->ok && n > 0; n--)
+		cfg->m_listBB.push_back(bb());
+	for (int n = in->word(); in->ok && n > 0; n--)
+		cfg->Ordering.push_back(bb());
+	for (int n = in->word(); in->ok && n > 0; n--)
+		cfg->revOrdering.push_back(bb());
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		ADDRESS a = in->word();
+		cfg->m_mapBB[a] = bb();
+	}
+	cfg->entryBB = bb();
+	cfg->exitBB = bb();
+	cfg->m_bWellFormed = in->word() != 0;
+	cfg->structured = in->word() != 0;
+	for (int n = in->word(); in->ok && n > 0; n--)
+		cfg->callSites.insert((CallStatement *)stmt());
+	cfg->lastLabel = in->word();
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		Exp *e = readExp();
+		Statement *s = stmt();
+		if (in->ok)
+			cfg->implicitMap[e] = s;
+	}
+	cfg->bImplicitsDone = in->word() != 0;
+}
+
+void Snapshot::readBB(BasicBlock *bb)
+{
+	bb->m_nodeType = (BBTYPE)in->word();
+	if (in->word()) {
+		bb->m_pRtls = new std::list<RTL *>;
+		for (int n = in->word(); in->ok && n > 0; n--)
+			bb->m_pRtls->push_back(readRtl());
+	}
+	bb->m_iLabelNum = in->word();
+	bb->m_labelStr = in->str();
+	bb->m_labelneeded = in->word() != 0;
+	bb->m_bIncomplete = in->word() != 0;
+	bb->m_bJumpReqd = in->word() != 0;
+	for (int n = in->word(); in->ok && n > 0; n--)
+		bb->m_InEdges.push_back(this->bb());
+	for (int n = in->word(); in->ok && n > 0; n--)
+		bb->m_OutEdges.push_back(this->bb());
+	bb->m_iNumInEdges = in->word();
+	bb->m_iNumOutEdges = in->word();
+	bb->m_iTraversed = in->word() != 0;
+	readLocs(bb->liveIn);
+
+	bb->m_DFTfirst = in->word();
+	bb->m_DFTlast = in->word();
+	bb->m_DFTrevfirst = in->word();
+	bb->m_DFTrevlast = in->word();
+	bb->m_structType = (SBBTYPE)in->word();
+	bb->m_loopCondType = (SBBTYPE)in->word();
+	bb->m_loopHead = this->bb();
+	bb->m_caseHead = this->bb();
+	bb->m_condFollow = this->bb();
+	bb->m_loopFollow = this->bb();
+	bb->m_latchNode = this->bb();
+
+	bb->ord = in->word();
+	bb->revOrd = in->word();
+	bb->inEdgesVisited = in->word();
+	bb->numForwardInEdges = in->word();
+	bb->loopStamps[0] = in->word();
+	bb->loopStamps[1] = in->word();
+	bb->revLoopStamps[0] = in->word();
+	bb->revLoopStamps[1] = in->word();
+	bb->traversed = (travType)in->word();
+	bb->hllLabel = in->word() != 0;
+	bb->indentLevel = in->word();
+	bb->immPDom = this->bb();
+	bb->loopHead = this->bb();
+	bb->caseHead = this->bb();
+	bb->condFollow = this->bb();
+	bb->loopFollow = this->bb();
+	bb->latchNode = this->bb();
+	bb->sType = (structType)in->word();
+	bb->usType = (unstructType)in->word();
+	bb->lType = (loopType)in->word();
+	bb->cType = (condType)in->word();
+	bb->overlappedRegProcessingDone = in->word() != 0;
+}
+
+RTL *Snapshot::readRtl()
+{
+	if (!in->word())
+		return NULL;
+	RTL *r = new RTL(in->word());
+	for (int n = in->word(); in->ok && n > 0; n--)
+		r->stmtList.push_back(stmt());
+	return r;
+}
+
+void Snapshot::readStmt(Statement *s)
+{
+	s->number = in->word();
+	s->pbb = bb();
+	s->proc = (UserProc *)proc();
+	s->parent = stmt();
+	if (s->isAssignment()) {
+		Assignment *a = (Assignment *)s;
+		a->type = readType();
+		a->lhs = readExp();
+	}
+	switch (s->kind) {
+	case STMT_ASSIGN:
+		((Assign *)s)->rhs = readExp();
+		((Assign *)s)->guard = readExp();
+		break;
+	case STMT_PHIASSIGN:
+		for (int n = in->word(); in->ok && n > 0; n--) {
+			PhiInfo pi;
+			pi.def = stmt();
+			pi.e = readExp();
+			((PhiAssign *)s)->defVec.push_back(pi);
+		}
+		break;
+	case STMT_IMPASSIGN:
+	case STMT_JUNCTION:
+		break;
+	case STMT_BOOLASSIGN:
+		{
+			BoolAssign *b = (BoolAssign *)s;
+			b->jtCond = (BRANCH_TYPE)in->word();
+			b->pCond = readExp();
+			b->bFloat = in->word() != 0;
+			b->size = in->word();
+			break;
+		}
+	case STMT_IMPREF:
+		((ImpRefStatement *)s)->type = readType();
+		((ImpRefStatement *)s)->addressExp = readExp();
+		break;
+	case STMT_GOTO:
+	case STMT_BRANCH:
+	case STMT_CASE:
+	case STMT_CALL:
+		{
+			GotoStatement *g = (GotoStatement *)s;
+			g->pDest = readExp();
+			g->m_isComputed = in->word() != 0;
+			if (s->kind == STMT_BRANCH) {
+				BranchStatement *b = (BranchStatement *)s;
+				b->jtCond = (BRANCH_TYPE)in->word();
+				b->pCond = readExp();
+				b->bFloat = in->word() != 0;
+				b->size = in->word();
+			} else if (s->kind == STMT_CASE) {
+				if (!in->word())
+					break;
+				SWITCH_INFO *si = new SWITCH_INFO;
+				si->pSwitchVar = readExp();
+				si->chForm = in->word();
+				si->iLower = in->word();
+				si->iUpper = in->word();
+				si->uTable = in->word();
+				si->iNumTable = in->word();
+				si->iOffset = in->word();
+				if (si->chForm == 'F') {
+					if (si->iNumTable < 0 || si->iNumTable > 0x10000) {
+						in->ok = false;
+						break;
+					}
+					int *table = new int[si->iNumTable];
+					for (int i = 0; i < si->iNumTable; i++)
+						table[i] = in->word();
+					si->uTable = (ADDRESS)table;  // Abuse the uTable member as a pointer, as in decodeIndirectJmp()
+				}
+				((CaseStatement *)s)->pSwitchInfo = si;
+			} else if (s->kind == STMT_CALL) {
+				CallStatement *c = (CallStatement *)s;
+				c->returnAfterCall = in->word() != 0;
+				readStmts(c->arguments);
+				readStmts(c->defines);
+				c->procDest = proc();
+				c->signature = readSig();
+				readUses(c->useCol);
+				readDefs(c->defCol);
+				c->calleeReturn = (ReturnStatement *)stmt();
+			}
+			break;
+		}
+	case STMT_RET:
+		{
+			ReturnStatement *r = (ReturnStatement *)s;
+			r->retAddr = in->word();
+			readDefs(r->col);
+			readStmts(r->modifieds);
+			readStmts(r->returns);
+			break;
+		}
+	}
+}
+
+Exp *Snapshot::readExp()
+{
+	switch (in->word()) {
+	case NULL_REF:
+		return NULL;
+	case OLD_REF:
+		{
+			int n = in->word();
+			if (n >= 0 && n < (int)exps.size() && exps[n])
+				return exps[n];
+			in->ok = false;
+			return new Terminal(opNil);
+		}
+	case NEW_REF:
+		break;
+	default:
+		in->ok = false;
+		return new Terminal(opNil);
+	}
+	// The number is taken before the subexpressions, as when saved
+	int n = exps.size();
+	exps.push_back(NULL);
+	int cls = in->word();
+	OPER op = (OPER)in->word();
+	int flags = in->word();
+	if (!in->ok || op < opWild || op >= opNumOf) {
+		in->ok = false;
+		return new Terminal(opNil);
+	}
+	Exp *e;
+	switch (cls) {
+	case 'c':
+		{
+			Const *c = new Const(0);
+			c->conscript = in->word();
+			c->type = readType();
+			switch (op) {
+			case opLongConst:
+				{
+					unsigned lo = in->word();
+					unsigned hi = in->word();
+					c->u.ll = ((QWord)hi << 32) | lo;
+					break;
+				}
+			case opFltConst:
+				{
+					int w[2];
+					w[0] = in->word();
+					w[1] = in->word();
+					memcpy(&c->u.d, w, sizeof(w));
+					break;
+				}
+			case opStrConst:
+				c->u.p = strdup(in->str().c_str());
+				break;
+			case opFuncConst:
+				c->u.pp = proc();
+				break;
+			default:
+				c->u.i = in->word();
+				break;
+			}
+			e = c;
+			break;
+		}
+	case 'v':
+		e = new TypeVal(readType());
+		break;
+	case 't':
+		e = new Terminal(op);
+		break;
+	case 'l':
+		{
+			Location *l = new Location(op);
+			l->proc = (UserProc *)proc();
+			l->subExp1 = readExp();
+			e = l;
+			break;
+		}
+	case 'r':
+		{
+			Exp *e1 = readExp();
+			e = new RefExp(e1, stmt());
+			break;
+		}
+	case 'f':
+		{
+			Exp *e1 = readExp();
+			e = new FlagDef(e1, readRtl());
+			break;
+		}
+	case 'y':
+		{
+			Type *ty = readType();
+			e = new TypedExp(ty, readExp());
+			break;
+		}
+	case '3':
+		{
+			Ternary *t = new Ternary(op);
+			t->subExp1 = readExp();
+			t->subExp2 = readExp();
+			t->subExp3 = readExp();
+			e = t;
+			break;
+		}
+	case '2':
+		{
+			Binary *b = new Binary(op);
+			b->subExp1 = readExp();
+			b->subExp2 = readExp();
+			e = b;
+			break;
+		}
+	case '1':
+		{
+			Unary *u = new Unary(op);
+			u->subExp1 = readExp();
+			e = u;
+			break;
+		}
+	default:
+		in->ok = false;
+		return new Terminal(opNil);
+	}
+	e->op = op;
+	if ((flags & 1) && in->ok)
+		e = shared.intern(e);  // Shared nodes must stay immutable
+	if (flags & 2)
+		e->canonical = true;
+	exps[n] = e;
+	return e;
+}
+
+Type *Snapshot::readType()
+{
+	switch (in->word()) {
+	case NULL_REF:
+		return NULL;
+	case OLD_REF:
+		{
+			int n = in->word();
+			if (n >= 0 && n < (int)types.size() && types[n])
+				return types[n];
+			in->ok = false;
+			return new VoidType;
+		}
+	case NEW_REF:
+		break;
+	default:
+		in->ok = false;
+		return new VoidType;
+	}
+	// The type is made and numbered before its parts are read, as they may refer back to it
+	Type *ty;
+	int id = in->word();
+	switch (id) {
+	case eVoid:     ty = new VoidType; break;
+	case eFunc:     ty = new FuncType; break;
+	case eBoolean:  ty = new BooleanType; break;
+	case eChar:     ty = new CharType; break;
+	case eInteger:  ty = new IntegerType; break;
+	case eFloat:    ty = new FloatType; break;
+	case ePointer:  ty = new PointerType(NULL); break;
+	case eArray:    ty = new ArrayType(); break;
+	case eNamed:    ty = new NamedType(""); break;
+	case eCompound: ty = new CompoundType(); break;
+	case eUnion:    ty = new UnionType(); break;
+	case eSize:     ty = new SizeType(); break;
+	case eUpper:    ty = new UpperType(NULL); break;
+	case eLower:    ty = new LowerType(NULL); break;
+	default:
+		in->ok = false;
+		return new VoidType;
+	}
+	types.push_back(ty);
+	switch (id) {
+	case eFunc:
+		((FuncType *)ty)->signature = readSig();
+		break;
+	case eInteger:
+		((IntegerType *)ty)->size = in->word();
+		((IntegerType *)ty)->signedness = in->word();
+		break;
+	case eFloat:
+		((FloatType *)ty)->size = in->word();
+		break;
+	case ePointer:
+		((PointerType *)ty)->points_to = readType();
+		break;
+	case eArray:
+		((ArrayType *)ty)->base_type = readType();
+		((ArrayType *)ty)->length = in->word();
+		break;
+	case eNamed:
+		((NamedType *)ty)->name = in->str();
+		break;
+	case eCompound:
+		{
+			CompoundType *c = (CompoundType *)ty;
+			for (int n = in->word(); in->ok && n > 0; n--) {
+				c->types.push_back(readType());
+				c->names.push_back(in->str());
+			}
+			c->nextGenericMemberNum = in->word();
+			c->generic = in->word() != 0;
+			break;
+		}
+	case eUnion:
+		for (int n = in->word(); in->ok && n > 0; n--) {
+			UnionElement ue;
+			ue.type = readType();
+			ue.name = in->str();
+			((UnionType *)ty)->li.push_back(ue);
+		}
+		break;
+	case eSize:
+		((SizeType *)ty)->size = in->word();
+		break;
+	case eUpper:
+		((UpperType *)ty)->setBaseType(readType());
+		break;
+	case eLower:
+		((LowerType *)ty)->setBaseType(readType());
+		break;
+	}
+	return ty;
+}
+
+Signature *Snapshot::readSig()
+{
+	switch (in->word()) {
+	case NULL_REF:
+		return NULL;
+	case OLD_REF:
+		{
+			int n = in->word();
+			if (n >= 0 && n < (int)sigs.size() && sigs[n])
+				return sigs[n];
+			in->ok = false;
+			return new Signature("");
+		}
+	case NEW_REF:
+		break;
+	default:
+		in->ok = false;
+		return new Signature("");
+	}
+	Signature *s;
+	int kind = in->word();
+	if (kind == 'C') {
+		int sp = in->word();
+		CustomSignature *cs = new CustomSignature(in->str().c_str());
+		cs->sp = sp;
+		s = cs;
+	} else if (kind == 'G')
+		s = new Signature(in->str().c_str());
+	else if (kind == 'S') {
+		platform plat = (platform)in->word();
+		callconv cc = (callconv)in->word();
+		std::string name = in->str();
+		if (!in->ok || !canInstantiate(plat, cc)) {
+			in->ok = false;
+			return new Signature(name.c_str());
+		}
+		s = Signature::instantiate(plat, cc, name.c_str());
+	} else {
+		in->ok = false;
+		return new Signature("");
+	}
+	sigs.push_back(s);
+
+	// Replaced by the saved ones
+	s->params.clear();
+	s->returns.clear();
+	s->sigFile = in->str();
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		Type *ty = readType();
+		std::string name = in->str();
+		Exp *e = readExp();
+		std::string boundMax = in->str();
+		s->params.push_back(new Parameter(ty, name.c_str(), e, boundMax.c_str()));
+	}
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		Type *ty = readType();
+		s->returns.push_back(new Return(ty, readExp()));
+	}
+	s->rettype = readType();
+	s->ellipsis = in->word() != 0;
+	s->unknown = in->word() != 0;
+	s->forced = in->word() != 0;
+	s->preferedReturn = readType();
+	s->preferedName = in->str();
+	for (int n = in->word(); in->ok && n > 0; n--)
+		s->preferedParams.push_back(in->word());
+	return s;
+}
+
+void Snapshot::readStmts(StatementList &sl)
+{
+	for (int n = in->word(); in->ok && n > 0; n--)
+		sl.append(stmt());
+}
+
+void Snapshot::readLocs(LocationSet &ls)
+{
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		Exp *e = readExp();
+		if (in->ok)
+			ls.insert(e);
+	}
+}
+
+void Snapshot::readDefs(DefCollector &dc)
+{
+	dc.initialised = in->word() != 0;
+	for (int n = in->word(); in->ok && n > 0; n--)
+		pendingDefs.push_back(std::pair<DefCollector *, int>(&dc, in->word()));
+}
+
+void Snapshot::readUses(UseCollector &uc)
+{
+	uc.initialised = in->word() != 0;
+	readLocs(uc.locs);
+}
+
+void Snapshot::readExpMap(std::map<Exp *, Exp *, lessExpStar> &m)
+{
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		Exp *from = readExp();
+		Exp *to = readExp();
+		if (in->ok)
+			m[from] = to;
+	}
+}
+
+void Snapshot::readDataMap(DataIntervalMap &dim)
+{
+	for (int n = in->word(); in->ok && n > 0; n--) {
+		ADDRESS a = in->word();
+		DataInterval &di = dim.dimap[a];
+		di.size = in->word();
+		di.name = in->str();
+		di.type = readType();
+	}
+}
@@ -35,8 +35,12 @@
 #include "sslparser.h"
 #include "util.h"
 #include "boomerang.h"
+#include "serializer.h"
 
 #include <algorithm>  // For remove()
+#include <vector>
+
+#include <sys/stat.h>  // For stat()
 
 #include <cstring>
 #include <cassert>
@@ -103,6 +107,7 @@ const TableEntry &TableEntry::operator=(const TableEntry &other)
 	for (std::list<std::string>::const_iterator it = other.params.begin(); it != other.params.end(); it++)
 		params.push_back(*it);
 	rtl = *(new RTL(other.rtl));
+	tmpl = other.tmpl;
 	return *this;
 }
 
@@ -150,7 +155,9 @@ int RTLInstDict::appendToDict(std::string &n, std::list<std::string> &p, RTL &r)
 	return 0;
 }
 
-RTLInstDict::RTLInstDict()
+RTLInstDict::RTLInstDict() :
+	bigEndian(false),
+	fetchExecCycle(NULL)
 {
 }
 
@@ -172,21 +179,27 @@ bool RTLInstDict::readSSLFile(const std::string &SSLFileName)
 	// Clear all state
 	reset();
 
-	// Attempt to Parse the SSL file
+	if (Boomerang::get()->noPrecompiled || !readCache(SSLFileName)) {
+		// Attempt to Parse the SSL file
 #ifdef DEBUG_SSLPARSER
-	SSLParser theParser(SSLFileName, true);
+		SSLParser theParser(SSLFileName, true);
 #else
-	SSLParser theParser(SSLFileName, false);
+		SSLParser theParser(SSLFileName, false);
 #endif
 
-	if (theParser.theScanner == NULL)
-		return false;
-	addRegister("%CTI", -1, 1, false);
-	addRegister("%NEXT", -1, 32, false);
+		if (theParser.theScanner == NULL)
+			return false;
+		addRegister("%CTI", -1, 1, false);
+		addRegister("%NEXT", -1, 32, false);
+
+		theParser.yyparse(*this);
 
-	theParser.yyparse(*this);
+		fixupParams();
 
-	fixupParams();
+		if (!Boomerang::get()->noPrecompiled)
+			writeCache(SSLFileName);
+	}
+	compileTemplates();
 
 	if (Boomerang::get()->debugDecoder) {
 		std::cout << "\n=======Expanded RTL template dictionary=======\n";
@@ -411,14 +424,28 @@ std::list<Statement *> *RTLInstDict::instantiateRTL(std::string &name, ADDRESS n
 		if (itf != fastMap.end())
 			lname = &itf->second;
 	}
-	// Retrieve the dictionary entry for the named instruction
-	if (idict.find(*lname) == idict.end()) { /* lname is not in dictionary */
+	// Retrieve the dictionary entry for the named instruction. Only find() here: the dictionary is read only while
+	// decoding
+	std::map<std::string, TableEntry>::iterator it = idict.find(*lname);
+	if (it == idict.end()) { /* lname is not in dictionary */
 		std::cerr << "ERROR: unknown instruction " << *lname << " at 0x" << std::hex << natPC << ", ignoring.\n";
 		return NULL;
 	}
-	TableEntry &entry = idict[*lname];
-
-	return instantiateRTL(entry.rtl, natPC, entry.params, actuals);
+	TableEntry &entry = it->second;
+	if (!entry.tmpl.isCompiled())
+		return instantiateRTL(entry.rtl, natPC, entry.params, actuals);
+
+	assert(entry.params.size() == actuals.size());
+	std::list<Statement *> *newList = entry.tmpl.instantiate(entry.rtl, actuals);
+	if (Boomerang::get()->debugDecoder)
+		for (std::list<Statement *>::iterator ss = newList->begin(); ss != newList->end(); ss++)
+			std::cout << "\t\t\t" << *ss << "\n";
+	if (entry.tmpl.hasPostVars())
+		transformPostVars(newList, true);
+	// Perform simplifications, e.g. *1 in Pentium addressing modes
+	for (std::list<Statement *>::iterator ss = newList->begin(); ss != newList->end(); ss++)
+		(*ss)->simplify();
+	return newList;
 }
 
 /*==============================================================================
@@ -438,18 +465,18 @@ std::list<Statement *> *RTLInstDict::instantiateRTL(RTL &rtl, ADDRESS natPC, std
 	std::list<Statement *> *newList = new std::list<Statement *>();
 	rtl.deepCopyList(*newList);
 
+	// Construct the formals to search for once, rather than for each statement
+	std::vector<Exp *> formals;
+	formals.reserve(params.size());
+	for (std::list<std::string>::iterator param = params.begin(); param != params.end(); param++)
+		formals.push_back(Location::param(param->c_str()));
+
 	// Iterate through each Statement of the new list of stmts
 	std::list<Statement *>::iterator ss;
 	for (ss = newList->begin(); ss != newList->end(); ss++) {
 		// Search for the formals and replace them with the actuals
-		std::list<std::string>::iterator param = params.begin();
-		std::vector<Exp *>::const_iterator actual = actuals.begin();
-		for (; param != params.end(); param++, actual++) {
-			/* Simple parameter - just construct the formal to search for */
-			Exp *formal = Location::param(param->c_str());
-			(*ss)->searchAndReplace(formal, *actual);
-			//delete formal;
-		}
+		for (unsigned i = 0; i < formals.size(); i++)
+			(*ss)->searchAndReplace(formals[i], actuals[i]);
 		(*ss)->fixSuccessor();
 		if (Boomerang::get()->debugDecoder)
 			std::cout << "\t\t\t" << *ss << "\n";
@@ -465,6 +492,120 @@ std::list<Statement *> *RTLInstDict::instantiateRTL(RTL &rtl, ADDRESS natPC, std
 	return newList;
 }
 
+/*==============================================================================
+ * FUNCTION:         RTLInstDict::compileTemplates
+ * OVERVIEW:         Compile the template of each instruction in the dictionary (see RTLTemplate). Called once the
+ *                   dictionary is complete; after this, the dictionary must not change
+ * PARAMETERS:       <none>
+ * RETURNS:          <nothing>
+ *============================================================================*/
+void RTLInstDict::compileTemplates()
+{
+	for (std::map<std::string, TableEntry>::iterator it = idict.begin(); it != idict.end(); it++)
+		it->second.tmpl.compile(it->second.rtl, it->second.params);
+}
+
+// Add to slots the places in e where the formals appear. As for Exp::searchReplaceAll(), the first formal with a given
+// name is the one used, and the operand of an opInitValueOf is not looked at
+static void findSlots(Exp *e, std::map<std::string, int> &formals, RTLTemplate::Slot &slot,
+                      std::vector<RTLTemplate::Slot> &slots)
+{
+	if (e->getOper() == opParam && e->getSubExp1()->isStrConst()) {
+		std::map<std::string, int>::iterator ff = formals.find(((Const *)e->getSubExp1())->getStr());
+		if (ff != formals.end()) {
+			slot.param = ff->second;
+			slots.push_back(slot);
+			return;
+		}
+	}
+	if (e->getOper() == opInitValueOf)
+		return;
+	for (int i = 1; i <= e->getArity(); i++) {
+		slot.path.push_back(i);
+		findSlots(i == 1 ? e->getSubExp1() : i == 2 ? e->getSubExp2() : e->getSubExp3(), formals, slot, slots);
+		slot.path.pop_back();
+	}
+}
+
+/*==============================================================================
+ * FUNCTION:         RTLTemplate::compile
+ * OVERVIEW:         Find the slots of the formals in the given template. Only assignments can be compiled
+ * PARAMETERS:       rtl - the template
+ *                   params - the formal parameters
+ * RETURNS:          <nothing>
+ *============================================================================*/
+void RTLTemplate::compile(RTL &rtl, std::list<std::string> &params)
+{
+	compiled = postVars = false;
+	slots.clear();
+	successors.clear();
+
+	std::map<std::string, int> formals;
+	int n = 0;
+	for (std::list<std::string>::iterator it = params.begin(); it != params.end(); it++, n++)
+		formals.insert(std::pair<std::string, int>(*it, n));  // Doesn't replace an earlier formal of the same name
+
+	Exp *succ = new Unary(opSuccessor, new Terminal(opWild));
+	std::list<Statement *> &stmts = rtl.getList();
+	for (std::list<Statement *>::iterator ss = stmts.begin(); ss != stmts.end(); ss++) {
+		if (!(*ss)->isAssign() || ((Assign *)*ss)->getLeft() == NULL || ((Assign *)*ss)->getRight() == NULL)
+			return;
+		Assign *a = (Assign *)*ss;
+		slots.push_back(std::vector<Slot>());
+		Slot slot;
+		slot.root = 0;
+		findSlots(a->getLeft(), formals, slot, slots.back());
+		slot.root = 1;
+		findSlots(a->getRight(), formals, slot, slots.back());
+		if (a->getGuard()) {
+			slot.root = 2;
+			findSlots(a->getGuard(), formals, slot, slots.back());
+		}
+		Exp *result;
+		successors.push_back(a->getLeft()->search(succ, result) || a->getRight()->search(succ, result));
+		// A formal as the whole left hand side could be replaced by a post-variable
+		if (a->getLeft()->isPostVar() || a->getLeft()->getOper() == opParam)
+			postVars = true;
+	}
+	compiled = true;
+}
+
+/*==============================================================================
+ * FUNCTION:         RTLTemplate::instantiate
+ * OVERVIEW:         Copy the given template, which must be the one that was compiled, and put clones of the actuals
+ *                   into the slots
+ * PARAMETERS:       rtl - the template
+ *                   actuals - the actual parameter values
+ * RETURNS:          the list of statements
+ *============================================================================*/
+std::list<Statement *> *RTLTemplate::instantiate(RTL &rtl, std::vector<Exp *> &actuals)
+{
+	std::list<Statement *> *newList = new std::list<Statement *>();
+	rtl.deepCopyList(*newList);
+
+	unsigned n = 0;
+	for (std::list<Statement *>::iterator ss = newList->begin(); ss != newList->end(); ss++, n++) {
+		Assign *a = (Assign *)*ss;
+		for (std::vector<Slot>::iterator sl = slots[n].begin(); sl != slots[n].end(); sl++) {
+			Exp *actual = actuals[sl->param]->clone();
+			if (sl->path.empty()) {
+				if (sl->root == 0) a->setLeft(actual);
+				else if (sl->root == 1) a->setRight(actual);
+				else a->setGuard(actual);
+				continue;
+			}
+			Exp *e = sl->root == 0 ? a->getLeft() : sl->root == 1 ? a->getRight() : a->getGuard();
+			std::vector<char>::iterator pp;
+			for (pp = sl->path.begin(); pp + 1 != sl->path.end(); pp++)
+				e = *pp == 1 ? e->getSubExp1() : *pp == 2 ? e->getSubExp2() : e->getSubExp3();
+			(*pp == 1 ? e->refSubExp1() : *pp == 2 ? e->refSubExp2() : e->refSubExp3()) = actual;
+		}
+		if (successors[n])
+			a->fixSuccessor();
+	}
+	return newList;
+}
+
 /* Small struct for transformPostVars */
 class transPost {
 public:
@@ -642,3 +783,176 @@ void RTLInstDict::reset()
 	idict.clear();
 	fetchExecCycle = 0;
 }
+
+/*==============================================================================
+ * Precompiled SSL files. Parsing an SSL file costs far more than decoding a small binary, so the parsed dictionary
+ * is saved in a binary form next to the SSL file (e.g. pentium.ssl.cache), and read back with a single read the next
+ * time. The cache records the size and modification time of the SSL file it was made from, and is ignored if these
+ * (or the format version, or the number of operators) have changed since.
+ * See serializer.h for the form of the expressions, types and statements. Anything that form does not know makes
+ * writeCache() give up, so the SSL file is simply parsed every time.
+ *============================================================================*/
+#define SSL_CACHE_MAGIC   0x4c535342  // "BSSL"
+#define SSL_CACHE_VERSION 1
+
+// The name of the precompiled form of an SSL file
+static std::string cacheName(const std::string &SSLFileName)
+{
+	return SSLFileName + ".cache";
+}
+
+/*==============================================================================
+ * FUNCTION:        RTLInstDict::readCache
+ * OVERVIEW:        Read this dictionary from the precompiled form of an SSL file, if it was made from the current
+ *                  version of the file. On failure, the dictionary is left empty.
+ * PARAMETERS:      SSLFileName - the name of the SSL file (not of the cache)
+ * RETURNS:         the dictionary was read
+ *============================================================================*/
+bool RTLInstDict::readCache(const std::string &SSLFileName)
+{
+	struct stat st;
+	if (stat(SSLFileName.c_str(), &st) != 0)
+		return false;
+	std::vector<char> buf;
+	if (!Deserializer::readFile(cacheName(SSLFileName), buf))
+		return false;
+
+	Deserializer in(&buf[0], buf.size());
+	if (in.word() != SSL_CACHE_MAGIC
+	 || in.word() != SSL_CACHE_VERSION
+	 || in.word() != opNumOf
+	 || in.word() != (int)st.st_size
+	 || in.word() != (int)st.st_mtime
+	 || !in.ok)
+		return false;
+
+	for (int n = in.word(); in.ok && n > 0; n--) {
+		std::string name = in.str();
+		RegMap[name] = in.word();
+	}
+	for (int n = in.word(); in.ok && n > 0; n--) {
+		int num = in.word();
+		in.reg(DetRegMap[num]);
+	}
+	for (int n = in.word(); in.ok && n > 0; n--) {
+		std::string name = in.str();
+		in.reg(SpecialRegMap[name]);
+	}
+	for (int n = in.word(); in.ok && n > 0; n--)
+		ParamSet.insert(in.str());
+	for (int n = in.word(); in.ok && n > 0; n--) {
+		ParamEntry &pe = DetParamMap[in.str()];
+		in.strList(pe.params);
+		in.strList(pe.funcParams);
+		pe.asgn = in.stmt();
+		pe.lhs = in.word() != 0;
+		pe.kind = (ParamKind)in.word();
+		pe.type = in.type();
+		pe.regType = in.type();
+		for (int i = in.word(); in.ok && i > 0; i--)
+			pe.regIdx.insert(in.word());
+		pe.mark = in.word();
+	}
+	for (int n = in.word(); in.ok && n > 0; n--) {
+		std::string name = in.str();
+		FlagFuncs[name] = in.exp();
+	}
+	for (int n = in.word(); in.ok && n > 0; n--) {
+		std::string name = in.str();
+		fastMap[name] = in.str();
+	}
+	bigEndian = in.word() != 0;
+	for (int n = in.word(); in.ok && n > 0; n--) {
+		TableEntry &te = idict[in.str()];
+		in.strList(te.params);
+		te.flags = in.word();
+		RTL *r = in.rtl();
+		if (r)
+			te.rtl.appendRTL(*r);
+	}
+	fetchExecCycle = in.rtl();
+
+	if (!in.ok || !in.atEnd()) {
+		reset();
+		return false;
+	}
+	return true;
+}
+
+/*==============================================================================
+ * FUNCTION:        RTLInstDict::writeCache
+ * OVERVIEW:        Write the precompiled form of this dictionary, as just read from an SSL file. The file is written
+ *                  under a temporary name and then renamed, so that other processes never see half a file.
+ * PARAMETERS:      SSLFileName - the name of the SSL file (not of the cache)
+ * RETURNS:         the cache was written
+ *============================================================================*/
+bool RTLInstDict::writeCache(const std::string &SSLFileName)
+{
+	struct stat st;
+	if (stat(SSLFileName.c_str(), &st) != 0)
+		return false;
+
+	Serializer out;
+	out.word(SSL_CACHE_MAGIC);
+	out.word(SSL_CACHE_VERSION);
+	out.word(opNumOf);
+	out.word(st.st_size);
+	out.word(st.st_mtime);
+
+	out.word(RegMap.size());
+	for (std::map<std::string, int>::iterator it = RegMap.begin(); it != RegMap.end(); it++) {
+		out.str(it->first.c_str());
+		out.word(it->second);
+	}
+	out.word(DetRegMap.size());
+	for (std::map<int, Register>::iterator it = DetRegMap.begin(); it != DetRegMap.end(); it++) {
+		out.word(it->first);
+		out.reg(it->second);
+	}
+	out.word(SpecialRegMap.size());
+	for (std::map<std::string, Register>::iterator it = SpecialRegMap.begin(); it != SpecialRegMap.end(); it++) {
+		out.str(it->first.c_str());
+		out.reg(it->second);
+	}
+	out.word(ParamSet.size());
+	for (std::set<std::string>::iterator it = ParamSet.begin(); it != ParamSet.end(); it++)
+		out.str(it->c_str());
+	out.word(DetParamMap.size());
+	for (std::map<std::string, ParamEntry>::iterator it = DetParamMap.begin(); it != DetParamMap.end(); it++) {
+		ParamEntry &pe = it->second;
+		out.str(it->first.c_str());
+		out.strList(pe.params);
+		out.strList(pe.funcParams);
+		out.stmt(pe.asgn);
+		out.word(pe.lhs);
+		out.word(pe.kind);
+		out.type(pe.type);
+		out.type(pe.regType);
+		out.word(pe.regIdx.size());
+		for (std::set<int>::iterator ri = pe.regIdx.begin(); ri != pe.regIdx.end(); ri++)
+			out.word(*ri);
+		out.word(pe.mark);
+	}
+	out.word(FlagFuncs.size());
+	for (std::map<std::string, Exp *>::iterator it = FlagFuncs.begin(); it != FlagFuncs.end(); it++) {
+		out.str(it->first.c_str());
+		out.exp(it->second);
+	}
+	out.word(fastMap.size());
+	for (std::map<std::string, std::string>::iterator it = fastMap.begin(); it != fastMap.end(); it++) {
+		out.str(it->first.c_str());
+		out.str(it->second.c_str());
+	}
+	out.word(bigEndian);
+	out.word(idict.size());
+	for (std::map<std::string, TableEntry>::iterator it = idict.begin(); it != idict.end(); it++) {
+		out.str(it->first.c_str());
+		out.strList(it->second.params);
+		out.word(it->second.flags);
+		out.rtl(&it->second.rtl);
+	}
+	out.rtl(fetchExecCycle);
+	if (!out.ok || !DefMap.empty() || !AliasMap.empty())
+		return false;
+	return out.writeFile(cacheName(SSLFileName));
+}
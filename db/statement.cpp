@@ -863,6 +863,8 @@ bool Statement::propagateTo(bool &convert, std::map<Exp *, int, lessExpStar> *de
 	// Simplify is very costly, especially for calls. I hope that doing one simplify at the end will not affect any
 	// result...
 	simplify();
+	if (changes > 0)
+		usesChanged();
 	return changes > 0;  // Note: change is only for the last time around the do/while loop
 }
 
@@ -887,9 +889,17 @@ bool Statement::propagateFlagsTo()
 		}
 	} while (change && ++changes < 10);
 	simplify();
+	if (change)
+		usesChanged();
 	return change;
 }
 
+void Statement::usesChanged()
+{
+	if (proc)
+		proc->getDefUses().markDirty(this);
+}
+
 
 // Parameter convert is set true if an indirect call is converted to direct
 // Return true if a change made
@@ -1074,6 +1084,7 @@ ADDRESS GotoStatement::getFixedDest()
 void GotoStatement::setDest(Exp *pd)
 {
 	pDest = pd;
+	usesChanged();
 }
 
 /*==============================================================================
@@ -2117,6 +2128,7 @@ void CallStatement::setArguments(StatementList &args)
 		((Assign *)*ll)->setProc(proc);
 		((Assign *)*ll)->setBB(pbb);
 	}
+	usesChanged();
 }
 
 /*==============================================================================
@@ -2155,6 +2167,7 @@ void CallStatement::setSigArguments()
 		as->setParent(this);
 		arguments.append(as);
 	}
+	usesChanged();
 
 	// initialize returns
 	// FIXME: anything needed here?
@@ -2621,6 +2634,7 @@ void CallStatement::removeArgument(int i)
 	StatementList::iterator aa = arguments.begin();
 	advance(aa, i);
 	arguments.erase(aa);
+	usesChanged();
 }
 
 // Processes each argument of a CallStatement, and the RHS of an Assign. Ad-hoc type analysis only.
@@ -2997,6 +3011,7 @@ void ReturnStatement::removeReturn(Exp *loc)
 	for (rr = returns.begin(); rr != returns.end(); ++rr) {
 		if (*((Assignment *)*rr)->getLeft() == *loc) {
 			returns.erase(rr);
+			usesChanged();
 			return;  // Assume only one definition
 		}
 	}
@@ -3005,6 +3020,7 @@ void ReturnStatement::removeReturn(Exp *loc)
 void ReturnStatement::addReturn(Assignment *a)
 {
 	returns.append(a);
+	usesChanged();
 }
 
 bool ReturnStatement::search(Exp *search, Exp *&result)
@@ -4696,6 +4712,7 @@ void ReturnStatement::updateModifieds()
 // modifieds list
 void ReturnStatement::updateReturns()
 {
+	usesChanged();  // The returns are rebuilt below
 	Signature *sig = proc->getSignature();
 	int sp = sig->getStackRegister();
 	StatementList oldRets(returns);  // Copy the old returns
@@ -4765,6 +4782,7 @@ void ReturnStatement::updateReturns()
 // Set the defines to the set of locations modified by the callee, or if no callee, to all variables live at this call
 void CallStatement::updateDefines()
 {
+	usesChanged();  // Any of the paths below can change the defines
 	Signature *sig;
 	if (procDest)
 		// The signature knows how to order the returns
@@ -5014,6 +5032,7 @@ void CallStatement::updateArguments()
 		bool convert;
 		proc->propagateStatements(convert, 88);
 	}
+	usesChanged();
 	StatementList oldArguments(arguments);
 	arguments.clear();
 	if (EXPERIMENTAL) {
@@ -5152,6 +5171,7 @@ void CallStatement::removeDefine(Exp *e)
 		Assign *as = ((Assign *)*ss);
 		if (*as->getLeft() == *e) {
 			defines.erase(ss);
+			usesChanged();
 			return;
 		}
 	}
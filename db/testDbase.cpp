@@ -12,12 +12,17 @@
 #include "ParserTest.h"
 #include "TypeTest.h"
 
+#include "boomerang.h"
+
 #include <cppunit/ui/text/TestRunner.h>
 
 #include <cstdlib>
 
 int main(int argc, char *argv[])
 {
+	// Parse the .ssl and signature files rather than write their precompiled forms into the source tree
+	Boomerang::get()->noPrecompiled = true;
+
 	CppUnit::TextUi::TestRunner runner;
 
 	runner.addTest(ExpTest::suite());
@@ -5,12 +5,17 @@
 
 #include "StatementTest.h"
 
+#include "boomerang.h"
+
 #include <cppunit/ui/text/TestRunner.h>
 
 #include <cstdlib>
 
 int main(int argc, char *argv[])
 {
+	// Parse the .ssl and signature files rather than write their precompiled forms into the source tree
+	Boomerang::get()->noPrecompiled = true;
+
 	CppUnit::TextUi::TestRunner runner;
 
 	runner.addTest(StatementTest::suite());
@@ -359,11 +359,13 @@ void XMLProgParser::addChildTo_prog(Context *node, const Context *child) const
 		child->proc->setProg(node->prog);
 		node->prog->m_procs.push_back(child->proc);
 		node->prog->m_procLabels[child->proc->getNativeAddress()] = child->proc;
+		node->prog->procNamesChanged();
 		break;
 	case e_userproc:
 		child->proc->setProg(node->prog);
 		node->prog->m_procs.push_back(child->proc);
 		node->prog->m_procLabels[child->proc->getNativeAddress()] = child->proc;
+		node->prog->procNamesChanged();
 		break;
 	case e_procs:
 		for (std::list<Proc *>::const_iterator it = child->procs.begin(); it != child->procs.end(); it++) {
@@ -371,12 +373,13 @@ void XMLProgParser::addChildTo_prog(Context *node, const Context *child) const
 			node->prog->m_procLabels[(*it)->getNativeAddress()] = *it;
 			Boomerang::get()->alert_load(*it);
 		}
+		node->prog->procNamesChanged();
 		break;
 	case e_cluster:
 		node->prog->m_rootCluster = child->cluster;
 		break;
 	case e_global:
-		node->prog->globals.insert(child->global);
+		node->prog->addGlobal(child->global);
 		break;
 	default:
 		addChildStub(node, child);
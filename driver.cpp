@@ -18,6 +18,7 @@
  */
 
 #include "boomerang.h"
+#include "profiler.h"
 
 //#define GC_DEBUG 1  // Uncomment to debug the garbage collector
 #include "gc.h"
@@ -44,6 +45,8 @@ int main(int argc, const char *argv[])
     that we can't be bothered collecting, especially standard STL objects */
 void *operator new(size_t n)
 {
+	++Profiler::numAllocs;  // For -gp
+	Profiler::numBytes += n;
 #ifdef DONT_COLLECT_STL
 	return GC_malloc_uncollectable(n);  // Don't collect, but mark
 #else
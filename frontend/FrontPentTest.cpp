@@ -228,3 +228,42 @@ void FrontPentTest::testFindMain()
 
 	delete pFE;
 }
+
+/*==============================================================================
+ * FUNCTION:        FrontPentTest::testDecodeCache
+ * OVERVIEW:        Test that decoding an address again is served from the decode cache, as a separate copy
+ *============================================================================*/
+void FrontPentTest::testDecodeCache()
+{
+	BinaryFileFactory bff;
+	BinaryFile *pBF = bff.Load(HELLO_PENT);
+	if (pBF == NULL)
+		pBF = new BinaryFileStub();
+	CPPUNIT_ASSERT(pBF != 0);
+	CPPUNIT_ASSERT(pBF->GetMachine() == MACHINE_PENTIUM);
+	Prog *prog = new Prog;
+	FrontEnd *pFE = new PentiumFrontEnd(pBF, prog, &bff);
+	prog->setFrontEnd(pFE);
+
+	std::ostringstream o1, o2;
+	DecodeResult first = pFE->decodeInstruction(0x8048345);
+	first.rtl->print(o1);
+	CPPUNIT_ASSERT_EQUAL(0u, pFE->getDecodeCacheHits());
+	CPPUNIT_ASSERT_EQUAL(1u, pFE->getDecodeCacheMisses());
+
+	DecodeResult second = pFE->decodeInstruction(0x8048345);
+	second.rtl->print(o2);
+	CPPUNIT_ASSERT_EQUAL(1u, pFE->getDecodeCacheHits());
+	CPPUNIT_ASSERT_EQUAL(1u, pFE->getDecodeCacheMisses());
+	CPPUNIT_ASSERT_EQUAL(first.numBytes, second.numBytes);
+	CPPUNIT_ASSERT_EQUAL(o1.str(), o2.str());
+	// The caller owns the RTL, so each decode must return its own
+	CPPUNIT_ASSERT(first.rtl != second.rtl);
+
+	pFE->clearDecodeCache();
+	pFE->decodeInstruction(0x8048345);
+	CPPUNIT_ASSERT_EQUAL(2u, pFE->getDecodeCacheMisses());
+
+	delete pFE;
+	//delete pBF;
+}
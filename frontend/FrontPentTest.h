@@ -13,6 +13,7 @@ class FrontPentTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(test3);
 	CPPUNIT_TEST(testBranch);
 	CPPUNIT_TEST(testFindMain);
+	CPPUNIT_TEST(testDecodeCache);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -23,4 +24,5 @@ public:
 	void test3();
 	void testBranch();
 	void testFindMain();
+	void testDecodeCache();
 };
@@ -36,11 +36,14 @@
 #include "signature.h"
 #include "boomerang.h"
 #include "log.h"
+#include "serializer.h"
 #include "ansi-c-parser.h"
 
 #include <queue>
 #include <sstream>
 
+#include <sys/stat.h>  // For stat()
+
 #include <cstdlib>
 #include <cstdarg>  // For varargs
 #include <cstring>
@@ -54,7 +57,8 @@
  *                pbff: pointer to a BinaryFileFactory object (so the library can be unloaded)
  * RETURNS:       <N/a>
  *============================================================================*/
-FrontEnd::FrontEnd(BinaryFile *pBF, Prog *prog, BinaryFileFactory *pbff) : pBF(pBF), pbff(pbff), prog(prog)
+FrontEnd::FrontEnd(BinaryFile *pBF, Prog *prog, BinaryFileFactory *pbff) :
+	pBF(pBF), pbff(pbff), prog(prog), cachedResult(new DecodeResult), decodeHits(0), decodeMisses(0)
 {
 }
 
@@ -90,6 +94,8 @@ FrontEnd *FrontEnd::Load(const char *fname, Prog *prog)
 // destructor
 FrontEnd::~FrontEnd()
 {
+	clearDecodeCache();
+	delete cachedResult;
 	if (pbff)
 		pbff->UnLoad();  // Unload the BinaryFile library with dlclose() or FreeLibrary()
 }
@@ -171,6 +177,8 @@ void FrontEnd::readLibraryCatalog(const char *sPath)
 void FrontEnd::readLibraryCatalog()
 {
 	librarySignatures.clear();
+	unreadSignatures.clear();
+	precompiledSigs.clear();
 	std::string sList = Boomerang::get()->getProgPath() + "signatures/common.hs";
 
 	readLibraryCatalog(sList.c_str());
@@ -292,7 +300,7 @@ void FrontEnd::decode(Prog *prog, bool decodeMain, const char *pname)
 					LOG << "unable to find signature for known entrypoint " << name << "\n";
 				else {
 					proc->setSignature(fty->getSignature()->clone());
-					proc->getSignature()->setName(name);
+					proc->setName(name);
 					//proc->getSignature()->setFullSig(true);  // Don't add or remove parameters
 					proc->getSignature()->setForced(true);   // Don't add or remove parameters
 				}
@@ -373,6 +381,15 @@ void FrontEnd::decodeFragment(UserProc *proc, ADDRESS a)
 	processProc(a, proc, os, true);
 }
 
+/*==============================================================================
+ * FUNCTION:      FrontEnd::decodeInstruction
+ * OVERVIEW:      Decode the instruction at pc. Procs are decoded again after indirect jumps are analysed (reDecode)
+ *                  and switch arms are decoded as fragments, so every result is cached with a pristine clone of its
+ *                  RTL; a hit returns a fresh clone of that, since the caller takes ownership of the RTL and changes
+ *                  it. Instructions that must be decoded repeatedly (DecodeResult::reDecode) are not cached.
+ * PARAMETERS:    pc: native address of the instruction
+ * RETURNS:       The decoded instruction; valid until the next call
+ *============================================================================*/
 DecodeResult &FrontEnd::decodeInstruction(ADDRESS pc)
 {
 	if (pBF->GetSectionInfoByAddr(pc) == NULL) {
@@ -382,7 +399,37 @@ DecodeResult &FrontEnd::decodeInstruction(ADDRESS pc)
 		invalid.valid = false;
 		return invalid;
 	}
-	return decoder->decodeInstruction(pc, pBF->getTextDelta());
+	std::map<ADDRESS, DecodeResult *>::iterator it = decodeCache.find(pc);
+	if (it != decodeCache.end()) {
+		decodeHits++;
+		*cachedResult = *it->second;
+		if (cachedResult->rtl)
+			cachedResult->rtl = cachedResult->rtl->clone();
+		prog->noteRead(pc, cachedResult->numBytes);
+		return *cachedResult;
+	}
+	decodeMisses++;
+	DecodeResult &inst = decoder->decodeInstruction(pc, pBF->getTextDelta());
+	prog->noteRead(pc, inst.numBytes);
+	if (inst.reDecode)
+		noDecodeCache.insert(pc);
+	else if (noDecodeCache.find(pc) == noDecodeCache.end()) {
+		DecodeResult *entry = new DecodeResult(inst);
+		if (entry->rtl)
+			entry->rtl = entry->rtl->clone();
+		decodeCache[pc] = entry;
+	}
+	return inst;
+}
+
+void FrontEnd::clearDecodeCache()
+{
+	for (std::map<ADDRESS, DecodeResult *>::iterator it = decodeCache.begin(); it != decodeCache.end(); it++) {
+		delete it->second->rtl;
+		delete it->second;
+	}
+	decodeCache.clear();
+	noDecodeCache.clear();
 }
 
 /*==============================================================================
@@ -394,6 +441,9 @@ DecodeResult &FrontEnd::decodeInstruction(ADDRESS pc)
  *============================================================================*/
 void FrontEnd::readLibrarySignatures(const char *sPath, callconv cc)
 {
+	if (!Boomerang::get()->noPrecompiled && readPrecompiledSigs(sPath, cc))
+		return;
+
 	std::ifstream ifs;
 
 	ifs.open(sPath);
@@ -413,13 +463,135 @@ void FrontEnd::readLibrarySignatures(const char *sPath, callconv cc)
 		std::cerr << "readLibrarySignatures from " << sPath << ": " << (*it)->getName() << "\n";
 #endif
 		librarySignatures[(*it)->getName()] = *it;
+		unreadSignatures.erase((*it)->getName());
 		(*it)->setSigFile(sPath);
 	}
+	if (!Boomerang::get()->noPrecompiled)
+		writePrecompiledSigs(sPath, cc, p);
 
 	delete p;
 	ifs.close();
 }
 
+/*==============================================================================
+ * Precompiled signature files. Parsing the signature files for a Win32 program (windows.h and friends) takes longer
+ * than loading a small binary, and only the few signatures that the binary imports are ever needed. So the parsed
+ * signatures are saved in a binary form next to each file, one per platform and calling convention (e.g.
+ * windows.h.pentium-pascal.sigdb). The named types (typedefs and structs) are made when the file is read, since
+ * any type may refer to them; a signature is made only when getLibSignature() first looks it up.
+ * The file starts with the format version, the number of operators, and the size and modification time of the
+ * signature file it was made from; it is ignored if any of these have changed. Then come the named types in order of
+ * definition, an index of signature names and offsets, and the signatures (see serializer.h).
+ *============================================================================*/
+#define SIGDB_MAGIC   0x47495342  // "BSIG"
+#define SIGDB_VERSION 1
+
+// The name of the precompiled form of a signature file
+static std::string precompiledSigsName(const char *sPath, platform plat, callconv cc)
+{
+	return std::string(sPath) + "." + Signature::platformName(plat) + "-" + Signature::conventionName(cc) + ".sigdb";
+}
+
+/*==============================================================================
+ * FUNCTION:       FrontEnd::readPrecompiledSigs
+ * OVERVIEW:       Read the precompiled form of a signature file, if it was made from the current version of the file.
+ *                 The named types are defined, and the signatures are noted in unreadSignatures
+ * PARAMETERS:     sPath: the signature file (not the precompiled one)
+ *                 cc: the calling convention assumed
+ * RETURNS:        true if the file was read
+ *============================================================================*/
+bool FrontEnd::readPrecompiledSigs(const char *sPath, callconv cc)
+{
+	struct stat st;
+	if (stat(sPath, &st) != 0)
+		return false;
+	platform plat = getFrontEndId();
+	precompiledSigs.push_back(std::vector<char>());
+	std::vector<char> &buf = precompiledSigs.back();
+	if (!Deserializer::readFile(precompiledSigsName(sPath, plat, cc), buf)) {
+		precompiledSigs.pop_back();
+		return false;
+	}
+
+	Deserializer in(&buf[0], buf.size());
+	bool ok = in.word() == SIGDB_MAGIC
+	       && in.word() == SIGDB_VERSION
+	       && in.word() == opNumOf
+	       && in.word() == (int)st.st_size
+	       && in.word() == (int)st.st_mtime
+	       && in.word() == plat
+	       && in.word() == cc;
+	std::list<std::pair<std::string, Type *> > namedTypes;
+	for (int n = ok ? in.word() : 0; in.ok && n > 0; n--) {
+		std::string name = in.str();
+		namedTypes.push_back(std::pair<std::string, Type *>(name, in.type()));
+	}
+	std::list<std::pair<std::string, unsigned> > index;
+	for (int n = ok ? in.word() : 0; in.ok && n > 0; n--) {
+		std::string name = in.str();
+		index.push_back(std::pair<std::string, unsigned>(name, in.word()));
+	}
+	if (!ok || !in.ok) {
+		precompiledSigs.pop_back();
+		return false;
+	}
+
+	for (std::list<std::pair<std::string, Type *> >::iterator it = namedTypes.begin(); it != namedTypes.end(); it++)
+		Type::addNamedType(it->first.c_str(), it->second);
+	unsigned base = in.offset();
+	for (std::list<std::pair<std::string, unsigned> >::iterator it = index.begin(); it != index.end(); it++) {
+		librarySignatures.erase(it->first);
+		unreadSignatures[it->first] = std::pair<const std::vector<char> *, unsigned>(&buf, base + it->second);
+	}
+	return true;
+}
+
+/*==============================================================================
+ * FUNCTION:       FrontEnd::writePrecompiledSigs
+ * OVERVIEW:       Write the precompiled form of a signature file, from the parser that has just read it. Nothing is
+ *                 written if the file has anything the precompiled form can't hold
+ * PARAMETERS:     sPath: the signature file (not the precompiled one)
+ *                 cc: the calling convention assumed
+ *                 p: the parser
+ * RETURNS:        <nothing>
+ *============================================================================*/
+void FrontEnd::writePrecompiledSigs(const char *sPath, callconv cc, AnsiCParser *p)
+{
+	struct stat st;
+	if (stat(sPath, &st) != 0)
+		return;
+	platform plat = getFrontEndId();
+
+	Serializer out;
+	out.word(SIGDB_MAGIC);
+	out.word(SIGDB_VERSION);
+	out.word(opNumOf);
+	out.word(st.st_size);
+	out.word(st.st_mtime);
+	out.word(plat);
+	out.word(cc);
+	out.word(p->namedTypes.size());
+	for (std::list<std::pair<std::string, Type *> >::iterator it = p->namedTypes.begin(); it != p->namedTypes.end(); it++) {
+		out.str(it->first.c_str());
+		out.type(it->second);
+	}
+	// As in librarySignatures, the last signature with a given name wins
+	std::map<std::string, Signature *> sigs;
+	for (std::list<Signature *>::iterator it = p->signatures.begin(); it != p->signatures.end(); it++)
+		sigs[(*it)->getName()] = *it;
+	Serializer body;
+	out.word(sigs.size());
+	for (std::map<std::string, Signature *>::iterator it = sigs.begin(); it != sigs.end(); it++) {
+		out.str(it->first.c_str());
+		out.word(body.buf.size());
+		body.sig(it->second);
+	}
+	if (!out.ok || !body.ok)
+		return;
+	out.buf += body.buf;
+	out.writeFile(precompiledSigsName(sPath, plat, cc));
+}
+
 Signature *FrontEnd::getDefaultSignature(const char *name)
 {
 	Signature *signature = NULL;
@@ -439,6 +611,27 @@ Signature *FrontEnd::getLibSignature(const char *name)
 	// Look up the name in the librarySignatures map
 	std::map<std::string, Signature *>::iterator it;
 	it = librarySignatures.find(name);
+	if (it == librarySignatures.end()) {
+		// Make it now if it is in a precompiled signature file
+		std::map<std::string, std::pair<const std::vector<char> *, unsigned> >::iterator uu;
+		uu = unreadSignatures.find(name);
+		if (uu != unreadSignatures.end()) {
+			const std::vector<char> &buf = *uu->second.first;
+			unsigned off = uu->second.second;
+			unreadSignatures.erase(uu);
+			Signature *sig = NULL;
+			if (off < buf.size()) {
+				Deserializer in(&buf[off], buf.size() - off);
+				sig = in.sig();
+				if (!in.ok)
+					sig = NULL;
+			}
+			if (sig)
+				it = librarySignatures.insert(std::pair<std::string, Signature *>(name, sig)).first;
+			else
+				LOG << "Bad precompiled signature for " << name << "\n";
+		}
+	}
 	if (it == librarySignatures.end()) {
 		LOG << "Unknown library function " << name << "\n";
 		signature = getDefaultSignature(name);
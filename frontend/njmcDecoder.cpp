@@ -104,8 +104,9 @@ Exp *NJMCDecoder::instantiateNamedParam(const char *name, ...)
 		std::cerr << "No entry for named parameter '" << name << "'\n";
 		return 0;
 	}
-	assert(RTLDict.DetParamMap.find(name) != RTLDict.DetParamMap.end());
-	ParamEntry &ent = RTLDict.DetParamMap[name];
+	std::map<std::string, ParamEntry>::iterator pe = RTLDict.DetParamMap.find(name);
+	assert(pe != RTLDict.DetParamMap.end());
+	ParamEntry &ent = pe->second;
 	if (ent.kind != PARAM_ASGN && ent.kind != PARAM_LAMBDA) {
 		std::cerr << "Attempt to instantiate expressionless parameter '" << name << "'\n";
 		return 0;
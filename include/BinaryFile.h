@@ -213,6 +213,9 @@ public:
 	        SectionInfo *GetSectionInfoByName(const char *sName);
 	        // Find the end of a section, given an address in the section
 	        SectionInfo *GetSectionInfoByAddr(ADDRESS uEntry) const;
+	        // Index the sections by address and name, so the lookups above take O(log n) time. Call once the section
+	        // table is complete; the lookups fall back to a linear search if the table has been replaced since
+	        void        indexSections();
 
 	// returns true if the given address is in a read only section
 	        bool        isReadOnly(ADDRESS uEntry) { SectionInfo *p = GetSectionInfoByAddr(uEntry); return p && p->bReadOnly; }
@@ -315,10 +318,24 @@ protected:
 	// Get the lower and upper limits of the text segment
 	        void        getTextLimits();
 
+	// Memory mapped images. The mappings are private, so writes (e.g. relocations) copy only the pages they touch
+	// Map size bytes of file f from offset (a multiple of the page size), at addr if not NULL. NULL if this fails
+	static  char       *mapFile(FILE *f, long offset, size_t size, char *addr = NULL);
+	// Map size bytes of zeroes; only the pages written to take any memory. NULL if this fails
+	static  char       *mapZeroes(size_t size);
+	static  void        unmap(char *addr, size_t size);
+	static  size_t      pageSize();
+
 	// Data
 	        bool        m_bArchive;      // True if archive member
 	        int         m_iNumSections;  // Number of sections
 	        SectionInfo *m_pSections;    // The section info
+	// The section index; see indexSections()
+	        std::vector<ADDRESS> sectStarts;  // Sorted starts of the intervals where the covering sections change
+	        std::vector<int> sectCover;       // Lowest numbered section covering each interval, or -1
+	        std::map<std::string, int> sectNames;  // Lowest numbered section with each name
+	        SectionInfo *indexedSections;     // The values of m_pSections and m_iNumSections when indexed
+	        int         indexedNumSections;
 	        ADDRESS     m_uInitPC;       // Initial program counter
 	        ADDRESS     m_uInitSP;       // Initial stack pointer
 
@@ -22,6 +22,8 @@
 
 class Location;
 class HLLCode;
+class BitSet;
+class LiveNumbering;
 class BasicBlock;
 class RTL;
 class Proc;
@@ -511,8 +513,9 @@ public:
 	        void        prependStmt(Statement *s, UserProc *proc);
 
 	// Liveness
-	        bool        calcLiveness(ConnectionGraph &ig, UserProc *proc);
-	        void        getLiveOut(LocationSet &live, LocationSet &phiLocs);
+	        void        numberLiveness(LiveNumbering &ln);
+	        bool        calcLiveness(ConnectionGraph &ig, LiveNumbering &ln);
+	        void        getLiveOut(BitSet &live, LiveNumbering &ln);
 
 	// Find indirect jumps and calls
 	        bool        decodeIndirectJmp(UserProc *proc);
@@ -530,6 +533,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 	        void        addOutEdge(PBB bb) { m_OutEdges.push_back(bb); }
 	        void        addRTL(RTL *rtl) {
 		                    if (m_pRtls == NULL)
@@ -44,6 +44,8 @@ class Proc;
 class UserProc;
 class HLLCode;
 class ObjcModule;
+class Profiler;
+class ProcCache;
 
 #define LOG Boomerang::get()->log()
 #define LOGTAIL Boomerang::get()->logTail()
@@ -76,6 +78,8 @@ public:
 	virtual void        alert_considering(Proc *parent, Proc *p) { }
 	virtual void        alert_decompiling(UserProc *p) { }
 	virtual void        alert_decompile_debug_point(UserProc *p, const char *description) { }
+	virtual void        alert_start_phase(UserProc *p, const char *phase) { }
+	virtual void        alert_end_phase(UserProc *p, const char *phase) { }
 };
 
 /**
@@ -141,6 +145,8 @@ public:
 	        int         decompile(const char *fname, const char *pname = NULL);
 	        /// Add a Watcher to the set of Watchers for this Boomerang object.
 	        void        addWatcher(Watcher *watcher) { watchers.insert(watcher); }
+	        bool        saveSnapshot(Prog *prog);
+	        Prog       *loadSnapshot(const char *fname);
 	        void        persistToXML(Prog *prog);
 	        Prog       *loadFromXML(const char *fname);
 
@@ -233,6 +239,17 @@ public:
 			                    (*it)->alert_decompiling(p);
 	                    }
 	virtual void        alert_decompile_debug_point(UserProc *p, const char *description);
+	        /// Alert the watchers that a phase (e.g. "middleDecompile") of \a p, or of the whole program if \a p is
+	        /// NULL, is starting.
+	        void        alert_start_phase(UserProc *p, const char *phase) {
+		                    for (std::set<Watcher *>::iterator it = watchers.begin(); it != watchers.end(); it++)
+			                    (*it)->alert_start_phase(p, phase);
+	                    }
+	        /// Alert the watchers that a phase has ended.
+	        void        alert_end_phase(UserProc *p, const char *phase) {
+		                    for (std::set<Watcher *>::iterator it = watchers.begin(); it != watchers.end(); it++)
+			                    (*it)->alert_end_phase(p, phase);
+	                    }
 
 	        void        logTail();
 
@@ -290,6 +307,24 @@ public:
 	        bool        assumeABI;          ///< Assume ABI compliance
 	        bool        experimental;       ///< Activate experimental code. Caution!
 	        int         minsToStopAfter;
+	        bool        internExps;         ///< Share identical dataflow locations via the ExpFactory
+	        bool        noPrecompiled;      ///< Always parse the .ssl and signature files; don't use their precompiled forms
+	        Profiler   *profiler;           ///< Times the phases of each proc for -gp (also one of the watchers)
+	        ProcCache  *procCache;          ///< Decompiled procs kept between runs, for -C
+};
+
+/**
+ * Alerts the watchers to the start of a phase of the decompilation when constructed, and to its end when it goes out
+ * of scope, so that every return from the phase is covered.
+ */
+class PhaseAlert {
+	        UserProc   *proc;
+	        const char *phase;
+public:
+	                    PhaseAlert(UserProc *p, const char *phase) : proc(p), phase(phase) {
+		                    Boomerang::get()->alert_start_phase(proc, phase);
+	                    }
+	                   ~PhaseAlert() { Boomerang::get()->alert_end_phase(proc, phase); }
 };
 
 #define VERBOSE             (Boomerang::get()->vFlag)
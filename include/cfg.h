@@ -488,6 +488,7 @@ public:
 protected:
 	void        addBB(PBB bb) { m_listBB.push_back(bb); }
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 #endif
@@ -62,6 +62,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class Module : public Cluster {
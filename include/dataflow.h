@@ -14,6 +14,7 @@
 #define DATAFLOW_H
 
 #include "exphelp.h"    // For lessExpStar, etc
+#include "exp.h"        // For embedded class ExpFactory
 #include "managed.h"    // For LocationSet
 #include "boomerang.h"  // For USE_DOMINANCE_NUMS etc
 
@@ -33,7 +34,80 @@ class Type;
 
 typedef BasicBlock *PBB;
 
+/*
+ * A dense set of small non negative integers (BB or location numbers), one bit each. Much smaller and faster than a
+ * std::set<int> for the dominance frontiers and phi placement sets. Members are visited in increasing order with
+ *   for (int i = bs.first(); i != -1; i = bs.next(i + 1))
+ */
+class BitSet {
+	typedef unsigned long Word;
+	enum { BITS = sizeof(Word) * 8 };
+	std::vector<Word> words;
+
+public:
+	            BitSet() { }
+	            BitSet(int n) : words((n + BITS - 1) / BITS, 0) { }
+
+	// Make room for members 0 .. n-1, keeping the existing members
+	void        resize(int n) { if ((int)words.size() * BITS < n) words.resize((n + BITS - 1) / BITS, 0); }
+	void        set(int i) { resize(i + 1); words[i / BITS] |= (Word)1 << (i % BITS); }
+	void        reset(int i) { if (i / BITS < (int)words.size()) words[i / BITS] &= ~((Word)1 << (i % BITS)); }
+	bool        test(int i) const { return i / BITS < (int)words.size() && ((words[i / BITS] >> (i % BITS)) & 1); }
+	void        clear() { words.clear(); }
+	void        swap(BitSet &o) { words.swap(o.words); }
+	bool        empty() const;
+	int         count() const;
+	// Return the smallest member >= i, or -1 if there is none
+	int         next(int i) const;
+	int         first() const { return next(0); }
+	BitSet     &operator|=(const BitSet &o);
+	bool        operator==(const BitSet &o) const;
+	// For testing and debugging
+	std::set<int> toSet() const;
+};
+
+/*
+ * The subscripted locations of a proc, numbered for the liveness analysis of Cfg::findInterferences(), and each BB's
+ * statements reduced to the numbers they define and use. The numbers follow lessExpStar order, so the versions of a
+ * base location (e.g. r24{2} and r24{7}) are consecutive, and the fixpoint iteration works on BitSets without ever
+ * comparing expressions.
+ */
+class LiveNumbering {
+public:
+	struct Stmt {
+		Statement  *s;
+		std::vector<int> defs;              // The definitions of s, subscripted by s
+		std::vector<int> uses;              // The subscripted uses, in lessExpStar order. None for phis
+	};
+	struct Block {
+		std::vector<Stmt> stmts;            // In reverse order, as the liveness visits them
+		std::vector<int> phiLocs;           // Phi operands at the top of successors that come from this BB
+		BitSet      liveIn;                 // Numbers live at the start of the BB
+	};
+	std::map<PBB, Block> blocks;
+
+private:
+	std::map<Exp *, int, lessExpStar> nums; // Numbers from locations
+	std::vector<Exp *> locs;                // Locations from numbers
+	std::vector<int> firstVersion;          // The first number with the same base location as each number
+	std::vector<int> endVersion;            // One past the last number with the same base location
+	std::vector<int> graphNodes;            // The node number in the interference graph, or -1 if none yet
+
+public:
+	// Return the number of subscripted location e, numbering it if new. Numbers are provisional until finish()
+	int         add(Exp *e);
+	// Renumber in lessExpStar order; call after all the blocks have been added
+	void        finish();
+	Exp        *getLoc(int n) { return locs[n]; }
+	// Return a member of live with the same base location as n but a different subscript, or -1 if none
+	int         differentVersion(int n, const BitSet &live) const;
+	int         graphNode(int n, ConnectionGraph &ig);
+	void        toLocationSet(const BitSet &bs, LocationSet &ls);
+};
+
 class DataFlow {
+	friend class Snapshot;
+
 	/******************** Dominance Frontier Data *******************/
 
 	/* These first two are not from Appel; they map PBBs to indices */
@@ -52,21 +126,25 @@ class DataFlow {
 	std::vector<int> vertex;            // ?
 	std::vector<int> parent;            // Parent in the dominator tree?
 	std::vector<int> best;              // Improves ancestorWithLowestSemi
-	std::vector<std::set<int> > bucket; // Deferred calculation?
+	std::vector<std::vector<int> > bucket; // Deferred calculation?
 	int         N;                      // Current node number in algorithm
-	std::vector<std::set<int> > DF;     // The dominance frontiers
+	std::vector<BitSet> DF;             // The dominance frontiers
+	std::vector<std::vector<int> > domChildren; // Children in the dominator tree, only while computing DF
 
 	/*
 	 * Inserting phi-functions
 	 */
-	// Array of sets of locations defined in BB n
-	std::vector<std::set<Exp *, lessExpStar> > A_orig;
-	// Map from expression to set of block numbers
-	std::map<Exp *, std::set<int>, lessExpStar> defsites;
+	// The locations defined in this proc, numbered in lessExpStar order, and the map back to the numbers
+	std::vector<Exp *> locs;
+	std::map<Exp *, int, lessExpStar> locNums;
+	// Array of sets of (numbers of) locations defined in BB n
+	std::vector<BitSet> A_orig;
+	// Array of sets of block numbers, indexed by location number
+	std::vector<BitSet> defsites;
 	// Set of block numbers defining all variables
-	std::set<int> defallsites;
-	// Array of sets of BBs needing phis
-	std::map<Exp *, std::set<int>, lessExpStar> A_phi;
+	BitSet      defallsites;
+	// Array of sets of BBs needing phis. Keyed by location, since location numbers change between passes
+	std::map<Exp *, BitSet, lessExpStar> A_phi;
 	// A Boomerang requirement: Statements defining particular subscripted locations
 	std::map<Exp *, Statement *, lessExpStar> defStmts;
 
@@ -77,6 +155,12 @@ class DataFlow {
 	// A map from expression (Exp *) to a stack of (pointers to) Statements
 	std::map<Exp *, std::stack<Statement *>, lessExpStar> Stacks;
 
+	// With -ie, the shared copies of the keys of locNums, A_phi and Stacks. Per proc and emptied at PROC_FINAL, so that
+	// it doesn't keep every key of every proc alive for the rest of the run
+	ExpFactory  keys;
+	// Copy a location for use as a key of locNums, A_phi or Stacks
+	Exp        *keyCopy(Exp *e);
+
 	// Initially false, meaning that locals and parameters are not renamed and hence not propagated.
 	// When true, locals and parameters can be renamed if their address does not escape the local procedure.
 	// See Mike's thesis for details.
@@ -96,6 +180,8 @@ public:
 	bool        placePhiFunctions(UserProc *proc);
 	// Rename variables in basicblock n. Return true if any change made
 	bool        renameBlockVars(UserProc *proc, int n, bool clearStacks = false);
+	// Subscript the uses in statement S; see renameBlockVars()
+	bool        renameUses(UserProc *proc, Statement *S);
 	bool        doesDominate(int n, int w);
 	void        setRenameLocalsParams(bool b) { renameLocalsAndParams = b; }
 	bool        canRenameLocalsParams() { return renameLocalsAndParams; }
@@ -107,14 +193,19 @@ public:
 	void        setDominanceNums(int n, int &currNum);  // Set the dominance statement number
 #endif
 	void        clearA_phi() { A_phi.clear(); }
+	// Free the working storage of dominators() and placePhiFunctions(); they recreate it if called again
+	void        releaseWorkingSets();
+	// Free all the dominance and SSA tables. Only for when the proc has been transformed out of SSA form
+	void        releaseAll();
 
 	// For testing:
 	int         pbbToNode(PBB bb) { return indices[bb]; }
-	std::set<int> &getDF(int node) { return DF[node]; }
+	unsigned    numInternedKeys() { return keys.size(); }
+	std::set<int> getDF(int node) { return DF[node].toSet(); }
 	PBB         nodeToBB(int node) { return BBs[node]; }
 	int         getIdom(int node) { return idom[node]; }
 	int         getSemi(int node) { return semi[node]; }
-	std::set<int> &getA_phi(Exp *e) { return A_phi[e]; }
+	std::set<int> getA_phi(Exp *e) { return A_phi[e].toSet(); }
 
 	// For debugging:
 	void        dumpStacks();
@@ -133,6 +224,8 @@ public:
  * DefCollector class. This class collects all definitions that reach the statement that contains this collector.
  */
 class DefCollector {
+	friend class Snapshot;
+
 	/*
 	 * True if initialised. When not initialised, callees should not subscript parameters inserted into the
 	 * associated CallStatement
@@ -210,6 +303,8 @@ public:
  * Typically the entries are not subscripted, like parameters or locations on the LHS of assignments
  */
 class UseCollector {
+	friend class Snapshot;
+
 	/*
 	 * True if initialised. When not initialised, callees should not subscript parameters inserted into the
 	 * associated CallStatement
@@ -274,4 +369,56 @@ public:
 	bool        operator==(UseCollector &other);
 };
 
+/**
+ * DefUseIndex class. For each definition in a proc, the statements that use it and the subscripted locations by which
+ * they use it (e.g. r24{12}), so that a pass looking for the uses of a definition does not have to visit every
+ * statement. Uses in collectors are not counted, as for Statement::addUsedLocs(). Uses of x{-} are filed under NULL.
+ *
+ * Statements that get new or different uses (renaming, propagation, changes to the arguments of calls or to returns)
+ * are marked dirty and refiled at the next query, and removed statements are unfiled. Passes which rewrite the
+ * whole proc (e.g. type analysis, simplification) just invalidate the index, and the next query rebuilds it.
+ */
+class DefUseIndex {
+public:
+	struct Use {
+		Statement  *user;                   // The statement with the use
+		RefExp     *ref;                    // What it uses, e.g. r24{12}
+	};
+	typedef std::vector<Use> UseList;
+	typedef std::map<Statement *, UseList>::iterator iterator;
+
+private:
+	UserProc   *proc;
+	bool        valid;                      // False if the index has to be rebuilt
+	std::map<Statement *, UseList> uses;    // The uses of each definition
+	std::map<Statement *, std::vector<Statement *> > defsUsed; // The definitions each statement is filed under
+	StatementSet dirty;                     // Statements to refile at the next query
+
+	void        file(Statement *s);
+	void        unfile(Statement *s);
+
+public:
+	            DefUseIndex() : proc(NULL), valid(false) { }
+
+	void        setProc(UserProc *p) { proc = p; }
+	// Forget everything; the next query rebuilds the index from the statements of the proc
+	void        invalidate();
+	// The uses of s have changed
+	void        markDirty(Statement *s) { if (valid) dirty.insert(s); }
+	// s has been removed from the proc
+	void        remove(Statement *s);
+	// Rebuild the index if invalid, and refile the dirty statements
+	void        refresh();
+
+	// The uses of def; empty if there are none
+	UseList    &getUses(Statement *def);
+	// Add the statements that use base{def} to users, if not there already, and sort them by statement number
+	void        getUsers(Statement *def, Exp *base, std::vector<Statement *> &users);
+	// The definitions that s uses, each once
+	void        getDefsUsedBy(Statement *s, std::vector<Statement *> &defs);
+	// All the definitions that have uses, with their uses. Call refresh() first
+	iterator    begin() { return uses.begin(); }
+	iterator    end()   { return uses.end(); }
+};
+
 #endif
@@ -67,8 +67,19 @@ protected:
 
 	        unsigned    lexBegin, lexEnd;
 
+	        bool        interned;  // True if this node is shared and owned by an ExpFactory; never modify it
+	        unsigned    hashVal;   // Cached structural hash; only valid if interned
+	        bool        canonical; // True if simplify() left this node unchanged; any change to the node clears it
+
 	// Constructor, with ID
-	                    Exp(OPER op) : op(op) { }
+	                    Exp(OPER op) : op(op), interned(false), hashVal(0), canonical(false) { }
+
+	// For two interned expressions: 1 if known equal, 0 if known different, -1 if a full compare is needed
+	        int         internedCompare(const Exp &o) const {
+		                    if (!interned || !o.interned) return -1;
+		                    if (this == &o) return 1;
+		                    return hashVal == o.hashVal ? -1 : 0;
+	                    }
 
 public:
 	// Virtual destructor
@@ -77,7 +88,7 @@ public:
 	        // Return the operator. Note: I'd like to make this protected, but then subclasses don't seem to be able to use
 	        // it (at least, for subexpressions)
 	        OPER        getOper() const { return op; }
-	        void        setOper(OPER x) { op = x; }  // A few simplifications use this
+	        void        setOper(OPER x) { assert(!interned); op = x; canonical = false; }  // A few simplifications use this
 
 	        void        setLexBegin(unsigned int n) { lexBegin = n; }
 	        void        setLexEnd(unsigned int n) { lexEnd = n; }
@@ -113,6 +124,12 @@ public:
 	// Comparison ignoring subscripts
 	virtual bool        operator*=(Exp &o) = 0;
 
+	// Structural hash, consistent with operator== for expressions without wildcards
+	        unsigned    hash();
+	// True if this is a shared node from an ExpFactory. Interned expressions are immutable: clone() gives a private,
+	// modifiable copy, and the ExpModifier, simplify and searchReplace paths clone them before changing anything
+	        bool        isInterned() const { return interned; }
+
 	// Return the number of subexpressions. This is only needed in rare cases.
 	// Could use polymorphism for all those cases, but this is easier
 	virtual int         getArity() { return 0; }  // Overridden for Unary, Binary, etc
@@ -218,8 +235,8 @@ public:
 	// NULL
 	virtual Exp        *match(Exp *pattern);
 
-	// match a string pattern
-	virtual bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
+	// match a string pattern. The pattern is compiled (once) to an ExpPattern; see there for the syntax
+	        bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
 
 	//  //  //  //  //  //  //
 	//  Search and Replace  //
@@ -285,6 +302,13 @@ public:
 	static  Exp        *Accumulate(std::list<Exp *> exprs);
 	// Simplify the expression
 	        Exp        *simplify();
+	// True if this node and all its subexpressions are known to be simplified already, so simplify() can return at once
+	        bool        isCanonical();
+	// Mark this expression as simplified, except for the nodes whose simplification depends on more than the tree
+	        void        setCanonical();
+	        void        clearCanonical() { canonical = false; }
+	// Counts of calls to simplify(), and of those that returned at once because the expression was canonical
+	static  unsigned    simplifyCalls, simplifySkips;
 	virtual Exp        *polySimplify(bool &bMod) { bMod = false; return this; }
 	// Just the address simplification a[ m[ any ]]
 	virtual Exp        *simplifyAddr() { return this; }
@@ -349,6 +373,8 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
+	friend class ExpFactory;
 };
 
 // Not part of the Exp class, but logically belongs with it:
@@ -401,11 +427,11 @@ public:
 	        const char *getFuncName();
 
 	// Set the constant
-	        void        setInt(int i)         { u.i  = i;  }
-	        void        setLong(QWord ll)     { u.ll = ll; }
-	        void        setFlt(double d)      { u.d  = d;  }
-	        void        setStr(const char *p) { u.p  = p;  }
-	        void        setAddr(ADDRESS a)    { u.a  = a;  }
+	        void        setInt(int i)         { u.i  = i;  canonical = false; }
+	        void        setLong(QWord ll)     { u.ll = ll; canonical = false; }
+	        void        setFlt(double d)      { u.d  = d;  canonical = false; }
+	        void        setStr(const char *p) { u.p  = p;  canonical = false; }
+	        void        setAddr(ADDRESS a)    { u.a  = a;  canonical = false; }
 
 	// Get and set the type
 	        Type       *getType() { return type; }
@@ -423,8 +449,6 @@ public:
 	virtual bool        accept(ExpVisitor *v);
 	virtual Exp        *accept(ExpModifier *v);
 
-	virtual bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
-
 	        int         getConscript() { return conscript; }
 	        void        setConscript(int cs) { conscript = cs; }
 
@@ -433,6 +457,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -465,10 +490,9 @@ public:
 	virtual Type       *ascendType();
 	virtual void        descendType(Type *parentType, bool &ch, Statement *s);
 
-	virtual bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
-
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -507,14 +531,13 @@ public:
 
 	// Set first subexpression
 	        void        setSubExp1(Exp *e);
-	        void        setSubExp1ND(Exp *e) { subExp1 = e; }
+	        void        setSubExp1ND(Exp *e) { subExp1 = e; canonical = false; }
 	// Get first subexpression
 	        Exp        *getSubExp1();
 	// Get a reference to subexpression 1
 	        Exp       *&refSubExp1();
 
 	virtual Exp        *match(Exp *pattern);
-	virtual bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
 
 	// Search children
 	        void        doSearchChildren(Exp *search, std::list<Exp **> &li, bool once);
@@ -537,6 +560,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -585,7 +609,6 @@ public:
 	        Exp       *&refSubExp2();
 
 	virtual Exp        *match(Exp *pattern);
-	virtual bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
 
 	// Search children
 	        void        doSearchChildren(Exp *search, std::list<Exp **> &li, bool once);
@@ -611,6 +634,7 @@ private:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -669,13 +693,12 @@ public:
 	virtual bool        accept(ExpVisitor *v);
 	virtual Exp        *accept(ExpModifier *v);
 
-	virtual bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
-
 	virtual Type       *ascendType();
 	virtual void        descendType(Type *parentType, bool &ch, Statement *s);
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -725,6 +748,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -745,6 +769,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -770,13 +795,12 @@ public:
 	virtual void        printx(int ind);
 	//virtual int         getNumRefs() { return 1; }
 	        Statement  *getDef() { return def; }  // Ugh was called getRef()
-	        Exp        *addSubscript(Statement *def) { this->def = def; return this; }
-	        void        setDef(Statement *def) { this->def = def; }
+	        Exp        *addSubscript(Statement *def) { assert(!interned); this->def = def; canonical = false; return this; }
+	        void        setDef(Statement *def) { assert(!interned); this->def = def; canonical = false; }
 	virtual Exp        *genConstraints(Exp *restrictTo);
 	        bool        references(Statement *s) { return def == s; }
 	virtual Exp        *polySimplify(bool &bMod);
 	virtual Exp        *match(Exp *pattern);
-	virtual bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
 
 	// Before type analysis, implicit definitions are NULL.  During and after TA, they point to an implicit
 	// assignment statement.  Don't implement here, since it would require #including of statement.h
@@ -792,6 +816,7 @@ public:
 protected:
 	                    RefExp() : Unary(opSubscript), def(NULL) { }
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -821,6 +846,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class Location : public Unary {
@@ -852,11 +878,90 @@ public:
 	// Visitation
 	virtual bool        accept(ExpVisitor *v);
 	virtual Exp        *accept(ExpModifier *v);
-	virtual bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 	                    Location(OPER op) : Unary(op), proc(NULL) { }
 };
 
+/*==============================================================================
+ * ExpFactory hash conses expressions: structurally identical expressions are interned into a single shared, immutable
+ * node, so that the many copies of the same location (e.g. m[r28{-} - 4]) made during dataflow analysis cost one node,
+ * and comparisons between interned expressions can often be decided by pointer or by cached hash.
+ * Two expressions share a node only if they are equal by operator== and also have the same Location procs, constant
+ * types and string pointers. Expressions with wildcards, constant subscripts, wild subscript definitions, or flag
+ * definitions are not interned.
+ *============================================================================*/
+class ExpFactory {
+	        std::vector<std::vector<Exp *> > buckets;  // Hash table of interned nodes, chained
+	        unsigned    count;                         // Number of interned nodes
+	        unsigned    hits, misses;                  // Intern requests satisfied by an existing node, or not
+
+public:
+	                    ExpFactory();
+
+	// True if e (and all its subexpressions) can be interned
+	static  bool        canIntern(Exp *e);
+	// Return the shared node for e. e itself is not changed or retained. If e can't be interned, it is returned as is
+	        Exp        *intern(Exp *e);
+	// Forget all interned nodes. Nodes already handed out stay valid (and immutable)
+	        void        clear();
+
+	        unsigned    size() { return count; }
+	        unsigned    getHits() { return hits; }
+	        unsigned    getMisses() { return misses; }
+
+private:
+	        Exp        *internNode(Exp *e);
+	static  Exp        *makeNode(Exp *e, Exp *c1, Exp *c2, Exp *c3);
+	static  bool        sameNode(Exp *a, Exp *b);
+	        void        grow();
+};
+
+/*==============================================================================
+ * ExpPattern is a textual expression pattern compiled into a tree of tests on the operators of an expression, so that
+ * it can be matched many times without printing the expression or copying the pattern. The syntax is that of the
+ * printed expression: x + y, x - y, m[x], r[x], a[x], x[y], x.name and x{n} or x{-} are matched by structure, and an
+ * alphanumeric name matches anything and binds it to that name. Negative integers, "strings" and terminals such as %pc
+ * are compared with the constant or terminal; any other text matches nothing.
+ * Variables are numbered in order of first appearance; match() stores the bound expressions in a caller supplied
+ * array of getNumVars() entries, and allocates nothing.
+ *============================================================================*/
+class ExpPattern {
+	enum Kind { VAR, OP1, OP2, SUBSCRIPT, MEMBER, INTLIT, STRLIT, TERMINAL, NOMATCH };
+	struct Node {
+		        Kind        kind;
+		        OPER        op;         // For OP1, OP2 and TERMINAL
+		        int         sub1, sub2; // Indices of the subpatterns
+		        int         var;        // Variable number for VAR, and for the member name of a MEMBER (or -1)
+		        int         val;        // Constant for INTLIT, definition number for SUBSCRIPT (-1 for {-})
+		        std::string text;       // For STRLIT, and the member name of a MEMBER
+	};
+	        std::vector<Node> nodes;
+	        std::vector<std::string> vars;
+	        int         root;
+
+public:
+	                    ExpPattern(const char *pattern);
+
+	        int         getNumVars() const { return vars.size(); }
+	        const std::string &getVarName(int i) const { return vars[i]; }
+	// The number of the named variable, or -1 if the pattern has no such variable
+	        int         getVarNum(const char *name) const;
+
+	// Match e against the pattern. If successful, bound[i] is the expression bound to variable i (unchanged if the
+	// variable was not reached)
+	        bool        match(Exp *e, Exp **bound) const;
+	// As above, but add the bindings to a map by name
+	        bool        match(Exp *e, std::map<std::string, Exp *> &bindings) const;
+
+private:
+	        int         compile(const std::string &pat);
+	        int         compileLiteral(const std::string &t);
+	        int         newNode(Kind kind, OPER op = opWild);
+	        int         varFor(const std::string &name);
+	        bool        matchNode(int n, Exp *e, Exp **bound) const;
+};
+
 #endif
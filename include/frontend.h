@@ -27,7 +27,9 @@
 
 #include <list>
 #include <map>
+#include <set>
 #include <queue>
+#include <vector>
 #include <fstream>
 
 class UserProc;
@@ -42,6 +44,7 @@ class Cfg;
 class Prog;
 struct DecodeResult;
 class Signature;
+class AnsiCParser;
 class Statement;
 class CallStatement;
 
@@ -110,10 +113,21 @@ protected:
 	TargetQueue targetQueue;
 	// Public map from function name (string) to signature.
 	std::map<std::string, Signature *> librarySignatures;
+	// Library signatures from precompiled signature files that have not been looked up yet: the file contents, and
+	// the offset of the signature in them. getLibSignature() makes the Signature and moves it to librarySignatures
+	std::map<std::string, std::pair<const std::vector<char> *, unsigned> > unreadSignatures;
+	// The contents of the precompiled signature files read so far
+	std::list<std::vector<char> > precompiledSigs;
 	// Map from address to meaningful name
 	std::map<ADDRESS, std::string> refHints;
 	// Map from address to previously decoded RTLs for decoded indirect control transfer instructions
 	std::map<ADDRESS, RTL *> previouslyDecoded;
+	// Program wide cache of decoded instructions, each with a pristine copy of its RTL; see decodeInstruction()
+	std::map<ADDRESS, DecodeResult *> decodeCache;
+	// Addresses that decode differently each time (see DecodeResult::reDecode), so are never cached
+	std::set<ADDRESS> noDecodeCache;
+	DecodeResult *cachedResult;  // Returned by decodeInstruction() on a cache hit
+	unsigned decodeHits, decodeMisses;
 public:
 	/*
 	 * Constructor. Takes some parameters to save passing these around a lot
@@ -158,6 +172,11 @@ public:
 
 	virtual DecodeResult &decodeInstruction(ADDRESS pc);
 
+	// Decode cache statistics, and a way to release the cache once no more decoding is expected
+	unsigned getDecodeCacheHits() { return decodeHits; }
+	unsigned getDecodeCacheMisses() { return decodeMisses; }
+	void clearDecodeCache();
+
 	virtual void extraProcessCall(CallStatement *call, std::list<RTL *> *BB_rtls) { }
 
 	/*
@@ -169,6 +188,9 @@ public:
 	 * Read library signatures from a file.
 	 */
 	void readLibrarySignatures(const char *sPath, callconv cc);
+	// Read or write the precompiled form of a signature file (see readLibrarySignatures)
+	bool readPrecompiledSigs(const char *sPath, callconv cc);
+	void writePrecompiledSigs(const char *sPath, callconv cc, AnsiCParser *p);
 	// read from a catalog
 	void readLibraryCatalog(const char *sPath);
 	// read from default catalog
@@ -28,6 +28,7 @@
 
 class BasicBlock;
 typedef BasicBlock *PBB;
+class BinaryFile;
 class Exp;
 class UserProc;
 class Proc;
@@ -111,6 +112,8 @@ public:
 	virtual void    AddProcEnd() = 0;
 	virtual void    AddLocal(const char *name, Type *type, bool last = false) = 0;
 	virtual void    AddGlobal(const char *name, Type *type, Exp *init = NULL) = 0;
+	// A global array of the size bytes at uNative in pBF, initialised with them as they are read when printed
+	virtual void    AddRawGlobal(const char *name, BinaryFile *pBF, ADDRESS uNative, unsigned size) = 0;
 	virtual void    AddPrototype(UserProc *proc) = 0;
 
 	// comments
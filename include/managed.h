@@ -26,6 +26,7 @@
 #include "exphelp.h"  // For lessExpStar
 
 #include <list>
+#include <map>
 #include <set>
 #include <vector>
 #include <ostream>
@@ -254,19 +255,46 @@ public:
 /// A class to store connections in a graph, e.g. for interferences of types or live ranges, or the phi_unite relation
 /// that phi statements imply
 /// If a is connected to b, then b is automatically connected to a
-// This is implemented in a std::multimap, even though Appel suggests a bitmap (e.g. std::vector<bool> does this in a
-// space efficient manner), but then you still need maps from expression to bit number. So here a standard map is used,
-// and when a -> b is inserted, b->a is redundantly inserted.
+// Each location is given a node number once, and the connections are kept as lists of node numbers, so that callers
+// which have numbered their locations already (e.g. the liveness in Cfg::findInterferences()) never compare
+// expressions. Appel suggests a bit matrix as well, for the membership test, but that is quadratic in the number of
+// nodes and big procs have thousands of them; the lists are short, so they are scanned instead.
+// Iteration is in lessExpStar order of the first location, then in the order the connections were made.
 class ConnectionGraph {
-	std::multimap<Exp *, Exp *, lessExpStar> emap;  // The map
+	std::map<Exp *, int, lessExpStar> nodeNums;  // Node numbers of the locations
+	std::vector<Exp *> nodes;                    // Locations of the node numbers
+	std::vector<std::vector<int> > adj;          // Nodes connected to each node, in the order connected
 public:
-	typedef std::multimap<Exp *, Exp *, lessExpStar>::iterator iterator;
+	class iterator {
+		friend class ConnectionGraph;
+		ConnectionGraph *g;
+		std::map<Exp *, int, lessExpStar>::iterator key;
+		unsigned    i;                          // Index into the list of key's node
+		std::pair<Exp *, Exp *> pr;             // The current connection
+
+		            iterator(ConnectionGraph *cg, std::map<Exp *, int, lessExpStar>::iterator k) :
+		                g(cg), key(k), i(0) { settle(); }
+		void        settle();                   // Move to the first connection at or after here, and set pr
+	public:
+		            iterator() : g(NULL), i(0) { }
+		std::pair<Exp *, Exp *> &operator*() { return pr; }
+		std::pair<Exp *, Exp *> *operator->() { return &pr; }
+		iterator   &operator++() { i++; settle(); return *this; }
+		iterator    operator++(int) { iterator ret = *this; ++*this; return ret; }
+		bool        operator==(const iterator &o) const { return key == o.key && i == o.i; }
+		bool        operator!=(const iterator &o) const { return !(*this == o); }
+	};
+	friend class iterator;
+
 	            ConnectionGraph() { }
 
-	void        add(Exp *a, Exp *b);            // Add pair with check for existing
-	void        connect(Exp *a, Exp *b);
-	iterator    begin() { return emap.begin(); }
-	iterator    end()   { return emap.end(); }
+	int         node(Exp *e);                   // Return the node number of e, adding a node if needed
+	void        add(int a, int b);              // Add a -> b with check for existing
+	void        add(Exp *a, Exp *b) { add(node(a), node(b)); }
+	void        connect(int a, int b);
+	void        connect(Exp *a, Exp *b) { connect(node(a), node(b)); }
+	iterator    begin() { return iterator(this, nodeNums.begin()); }
+	iterator    end()   { return iterator(this, nodeNums.end()); }
 	int         count(Exp *a);                  // Return a count of locations connected to a
 	bool        isConnected(Exp *a, Exp *b);    // Return true if a is connected to b
 	// Update the map that used to be a <-> b, now it is a <-> c
@@ -104,7 +104,7 @@ public:
 	 * Returns a pointer to the Signature
 	 */
 	        Signature  *getSignature() { return signature; }
-	        void        setSignature(Signature *sig) { signature = sig; }
+	        void        setSignature(Signature *sig);
 
 	virtual void        renameParam(const char *oldName, const char *newName);
 
@@ -189,6 +189,9 @@ public:
 	/// Set an equation as proven. Useful for some sorts of testing
 	        void        setProvenTrue(Exp *fact);
 
+	/// Print what the callers of this proc depend on: its signature, what it preserves and (for a UserProc) its returns
+	        void        printSummary(std::ostream &os);
+
 	/**
 	 * Get the callers
 	 * Note: the callers will be in a random order (determined by memory allocation)
@@ -252,6 +255,7 @@ protected:
 	        Cluster    *cluster;                  ///< Cluster this procedure is contained within.
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 	                    Proc() : visited(false), prog(NULL), signature(NULL), address(0), m_firstCaller(NULL), m_firstCallerAddr(0), cluster(NULL) { }
 
 };
@@ -284,6 +288,7 @@ public:
 protected:
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 	                    LibProc() : Proc() { }
 };
 
@@ -384,6 +389,11 @@ private:
 	 */
 	        DataFlow    df;
 
+	/**
+	 * The uses of each definition, kept up to date as statements are renamed, propagated into and removed.
+	 */
+	        DefUseIndex defUses;
+
 	/**
 	 * Current statement number. Makes it easier to split decompile() into smaller pieces.
 	 */
@@ -431,6 +441,11 @@ public:
 	 */
 	        DataFlow   *getDataFlow() { return &df; }
 
+	/**
+	 * Returns the def-use index. Its queries bring it up to date first.
+	 */
+	        DefUseIndex &getDefUses() { return defUses; }
+
 	/**
 	 * Deletes the whole CFG and all the RTLs and Exps associated with it. Also nulls the internal cfg
 	 * pointer (to prevent strange errors)
@@ -479,7 +494,7 @@ public:
 	        void        dumpLocals();
 
 	/// simplify the statements in this proc
-	        void        simplify() { cfg->simplify(); }
+	        void        simplify() { cfg->simplify(); defUses.invalidate(); }
 
 	// simple windows mode decompile
 	        void        windowsModeDecompile();
@@ -589,7 +604,26 @@ private:
 public:
 	        bool        removeNullStatements();
 	        bool        removeDeadStatements();
-	typedef std::map<Statement *, int> RefCounter;
+	/*
+	 * Counts of the references to each definition, for removing unused statements. Statement numbers are dense within
+	 * a proc, so most counts are in a flat array indexed by number. Implicit assignments are all numbered 0, so they
+	 * (and any statement numbered twice, which shouldn't happen) are kept in a map instead.
+	 */
+	class RefCounter {
+		struct Entry {
+			Statement  *stmt;
+			int         count;
+			bool        inProc;  // True if stmt is one of the statements of the proc, so it may be removed
+			            Entry() : stmt(NULL), count(0), inProc(false) { }
+		};
+		std::vector<Entry> numbered;              // Indexed by statement number
+		std::map<Statement *, Entry> unnumbered;
+		Entry      &entry(Statement *s);
+	public:
+		int        &operator[](Statement *s) { return entry(s).count; }
+		void        addStmt(Statement *s) { entry(s).inProc = true; }
+		bool        inProc(Statement *s) { return entry(s).inProc; }
+	};
 	        void        countRefs(RefCounter &refCounts);
 	/// Remove unused statements.
 	        void        remUnusedStmtEtc();
@@ -862,6 +896,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 	                    UserProc();
 	        void        setCFG(Cfg *c) { cfg = c; }
 };
@@ -0,0 +1,73 @@
+/**
+ * \file
+ * \brief Interface for the ProcCache class, which keeps decompiled procs on disk between runs.
+ *
+ * \copyright
+ * See the file "LICENSE.TERMS" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#ifndef PROCCACHE_H
+#define PROCCACHE_H
+
+#include "types.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class Prog;
+class Proc;
+class UserProc;
+
+/*==============================================================================
+ * ProcCache keeps the state of each proc at PROC_FINAL in a directory (-C switch), so that decompiling a new build of
+ * the same program only runs the pipeline of UserProc::decompile() for the procs that changed, and their callers.
+ *
+ * A proc is filed under a hash of its decoded RTLs (which hold the addresses of its instructions), the summaries of
+ * its callees (signature, preserved locations and returns) and the switches that change the decompilation. Its
+ * callees are decompiled first, so a proc whose code and callees are the same as before gets the same key. A proc is
+ * not saved if it is part of a recursion group, or if its pipeline found callees that weren't known when it was
+ * looked up (e.g. by analysing a switch), as those would not be decompiled first next time.
+ *
+ * The pipeline also reads the image itself, e.g. format strings, string constants and switch tables, and decodes the
+ * arms of switches. The ranges read through Prog while a proc is decompiled are saved with it, with a hash of their
+ * bytes, and the proc is only restored if those bytes are the same in the image being decompiled.
+ *
+ * The passes after all the procs are decompiled (global type analysis, removing unused returns, leaving SSA form)
+ * still run on all the procs, cached or not.
+ *============================================================================*/
+class ProcCache {
+	// A proc looked up but not found, to be saved when decompiled
+	struct Pending {
+		QWord       key;
+		std::set<Proc *> callees;           // The callees it was looked up with
+		unsigned    firstRead;              // Index in reads of the first range read by its decompilation
+	};
+	typedef std::pair<ADDRESS, unsigned> Range;  // Start and length
+	static const int ENTRY_VERSION = 2;     // Of the layout of an entry up to its snapshot
+	std::string dir;                        // With a trailing slash
+	std::map<UserProc *, Pending> pending;
+	std::vector<Range> reads;               // The ranges of the image read since the first pending proc was looked up
+	int         hits, misses, saved;
+
+	        std::string fileName(QWord key);
+	        QWord       getKey(UserProc *proc, std::set<Proc *> &callees);
+	static  QWord       hashImage(Prog *prog, const std::vector<Range> &ranges);
+
+public:
+	                    ProcCache(const std::string &dir);
+	// The directory, with a trailing slash
+	        const std::string &getDir() { return dir; }
+
+	// Restore proc from the cache, if it's there under its key. Call when its callees have been decompiled, before
+	// its own decompilation starts. If it's not there, it's saved by save() when decompiled
+	        bool        load(UserProc *proc);
+	// Save proc, which has just reached PROC_FINAL, if load() didn't find it
+	        void        save(UserProc *proc);
+	// Log the numbers of procs found, not found and saved
+	        void        report();
+};
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * \file
+ * \brief Interface for the Profiler class, which times the phases of the decompilation of each proc.
+ *
+ * \copyright
+ * See the file "LICENSE.TERMS" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "boomerang.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A Watcher that records the wall clock time, the number of allocations and the bytes allocated for each phase of
+ * each proc (e.g. middleDecompile of main), and writes them as a JSON or CSV file (-gp switch).
+ *
+ * Phases nest: the "self" figures exclude the phases started inside a phase, including those of other procs (e.g.
+ * the children decompiled from decompile). When a phase of a proc is started again while it is still going (e.g.
+ * decompile, when a proc is restarted after finding a switch), only the outermost one adds to the total.
+ */
+class Profiler : public Watcher {
+	struct Totals {
+		std::string proc;                   // Name of the proc when first seen; empty for whole program phases
+		std::string phase;
+		int         calls;
+		double      secs, selfSecs;
+		unsigned long allocs, selfAllocs;
+		unsigned long bytes, selfBytes;
+		            Totals() : calls(0), secs(0), selfSecs(0), allocs(0), selfAllocs(0), bytes(0), selfBytes(0) { }
+	};
+	struct Frame {
+		int         row;                    // Index into rows
+		double      start;
+		unsigned long allocs, bytes;        // Counters at the start
+		double      childSecs;              // Totals of the phases started inside this one
+		unsigned long childAllocs, childBytes;
+	};
+	std::string fileName;
+	std::vector<Totals> rows;               // In the order first started
+	std::map<std::pair<UserProc *, std::string>, int> rowNums;
+	std::vector<Frame> stack;               // The phases going now, innermost last
+
+	static  double      now();
+	        int         endFrame(double end);
+
+public:
+	// Counted by the global operator new (see driver.cpp)
+	static  unsigned long numAllocs, numBytes;
+
+	                    Profiler(const char *fileName) : fileName(fileName) { }
+
+	virtual void        alert_start_phase(UserProc *p, const char *phase);
+	virtual void        alert_end_phase(UserProc *p, const char *phase);
+
+	// Write the report: CSV if the file name ends in .csv, else JSON. Phases still going are ended first (e.g. when
+	// stopped by -S). Returns false if the file can't be written
+	        bool        writeReport();
+};
+
+#endif
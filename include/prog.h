@@ -32,6 +32,7 @@ class Signature;
 class Statement;
 class StatementSet;
 class Cluster;
+class HLLCode;
 class XMLProgParser;
 
 typedef std::map<ADDRESS, Proc *, std::less<ADDRESS> > PROGMAP;
@@ -57,6 +58,7 @@ public:
 protected:
 	                    Global() : type(NULL), uaddr(0), nam("") { }
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class Prog {
@@ -83,6 +85,8 @@ public:
 	        Proc       *findProc(const char *name) const;
 	// Find the Proc that contains the given address
 	        Proc       *findContainingProc(ADDRESS uAddr) const;
+	// Call when a proc is renamed or given a new signature, so that findProc(name) rebuilds its index
+	        void        procNamesChanged() { procsIndexed = false; }
 	        bool        isProcLabel(ADDRESS addr);      // Checks if addr is a label or not
 	// Create a dot file for all CFGs
 	        bool        createDotFile(const char *, bool bMainOnly = false) const;
@@ -172,6 +176,7 @@ public:
 	// Generate code
 	        void        generateCode(std::ostream &os);
 	        void        generateCode(Cluster *cluster = NULL, UserProc *proc = NULL, bool intermixRTL = false);
+	        HLLCode    *generateProcCode(UserProc *proc);
 	        void        generateRTL(Cluster *cluster = NULL, UserProc *proc = NULL);
 
 	// Print this program (primarily for debugging)
@@ -237,12 +242,12 @@ public:
 	        ADDRESS     getLimitTextHigh() { return pBF->getLimitTextHigh(); }
 	        bool        isReadOnly(ADDRESS a) { return pBF->isReadOnly(a); }
 	// Read 2, 4, or 8 bytes given a native address
-	        int         readNative1(ADDRESS a) { return pBF->readNative1(a); }
-	        int         readNative2(ADDRESS a) { return pBF->readNative2(a); }
-	        int         readNative4(ADDRESS a) { return pBF->readNative4(a); }
-	        float       readNativeFloat4(ADDRESS a) { return pBF->readNativeFloat4(a); }
-	        double      readNativeFloat8(ADDRESS a) { return pBF->readNativeFloat8(a); }
-	        QWord       readNative8(ADDRESS a) { return pBF->readNative8(a); }
+	        int         readNative1(ADDRESS a) { noteRead(a, 1); return pBF->readNative1(a); }
+	        int         readNative2(ADDRESS a) { noteRead(a, 2); return pBF->readNative2(a); }
+	        int         readNative4(ADDRESS a) { noteRead(a, 4); return pBF->readNative4(a); }
+	        float       readNativeFloat4(ADDRESS a) { noteRead(a, 4); return pBF->readNativeFloat4(a); }
+	        double      readNativeFloat8(ADDRESS a) { noteRead(a, 8); return pBF->readNativeFloat8(a); }
+	        QWord       readNative8(ADDRESS a) { noteRead(a, 8); return pBF->readNative8(a); }
 	        Exp        *readNativeAs(ADDRESS uaddr, Type *type);
 	        int         getTextDelta() { return pBF->getTextDelta(); }
 
@@ -255,6 +260,11 @@ public:
 	        unsigned    getImageSize() { return pBF->getImageSize(); }
 	        ADDRESS     getImageBase() { return pBF->getImageBase(); }
 
+	// Note the ranges of the image read from now on (by the methods above, and by decoding) in log, or stop if NULL.
+	// For ProcCache, whose entries depend on them
+	        void        setReadLog(std::vector<std::pair<ADDRESS, unsigned> > *log) { readLog = log; }
+	        void        noteRead(ADDRESS a, unsigned n) { if (readLog) readLog->push_back(std::pair<ADDRESS, unsigned>(a, n)); }
+
 	// Public booleans that are set if and when a register jump or call is
 	// found, respectively
 	        bool        bRegisterJump;
@@ -291,7 +301,36 @@ protected:
 	        int         m_iNumberedProc;    // Next numbered proc will use this
 	        Cluster    *m_rootCluster;      // Root of the cluster tree
 
+	/* Lookup indexes, rebuilt on demand when marked stale */
+	        std::map<std::string, Global *> globalsByName;  // First global with each name
+	        std::multimap<ADDRESS, Global *> globalsByAddr;
+	        unsigned    maxGlobalSize;      // Bytes in the largest global; bounds the search for a containing global
+	        bool        globalsIndexed;     // False if the two maps above need rebuilding
+	mutable std::map<std::string, Proc *> procsByName;  // First proc with each name
+	mutable bool        procsIndexed;       // False if procsByName needs rebuilding
+	struct SymRange {
+		ADDRESS     start, end;         // The binary file's symbol covers [start, end)
+		ADDRESS     reach;              // Largest end of this and all the ranges before it
+		std::string name;
+		static  bool        startsBelow(const SymRange &r, ADDRESS a) { return r.start < a; }
+		static  bool        reachesPast(ADDRESS a, const SymRange &r) { return a < r.reach; }
+	};
+	        std::vector<SymRange> symRanges;  // Symbols with a size, in order of start
+	        int         numSymsIndexed;     // Size of the binary file's symbol map when symRanges was built, or -1
+	        std::vector<std::pair<ADDRESS, unsigned> > *readLog;  // See setReadLog()
+
+	// Add a global, keeping the indexes up to date
+	        void        addGlobal(Global *global);
+	        void        indexGlobals();
+	        void        indexGlobal(Global *global);
+	// The global at or containing uaddr, or NULL if none
+	        Global     *findGlobalAt(ADDRESS uaddr);
+	        void        indexSymbols();
+	// The name of the lowest symbol of the binary file strictly below uaddr that contains it, or NULL if none
+	        const char *findSymbolContaining(ADDRESS uaddr, ADDRESS &start);
+
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 #endif
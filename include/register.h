@@ -40,6 +40,8 @@ public:
 	void s_float(bool f) { flt = f; }
 	void s_address(void *p) { address = p; }
 
+	bool hasName() const { return name != 0; }
+
 	/* These are only used in the interpreter */
 	char *g_name() const;
 	void *g_address() const { return address; }
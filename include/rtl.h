@@ -171,10 +171,44 @@ public:
 protected:
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 
 
+/*==============================================================================
+ * The RTLTemplate class is the compiled form of an instruction template (the RTL and formal parameters of a
+ * TableEntry). It records the places (slots) where the formals appear in each statement, so that instantiating the
+ * template is one copy of its statements with the actuals written straight into their slots, instead of a search of
+ * every statement for every formal. Whether the template needs its successor functions fixed, or its post-variables
+ * transformed, is also worked out once here.
+ *============================================================================*/
+class RTLTemplate {
+public:
+	// A place in a statement of the template where a formal parameter appears
+	struct Slot {
+		int         root;           // 0 for the left hand side of the assignment, 1 for the right, 2 for the guard
+		std::vector<char> path;     // Numbers (1 to 3) of the subexpressions leading from the root to the formal
+		int         param;          // Index of the formal
+	};
+
+	            RTLTemplate() : compiled(false), postVars(false) { }
+
+	// Find the slots of the given template. If it has anything the slots can't describe, isCompiled() is false
+	// afterwards, and the template must be instantiated the general way
+	void        compile(RTL &rtl, std::list<std::string> &params);
+	bool        isCompiled() const { return compiled; }
+	bool        hasPostVars() const { return postVars; }
+	// Copy the given template (as compiled) with the actuals in their slots, and successor functions fixed
+	std::list<Statement *> *instantiate(RTL &rtl, std::vector<Exp *> &actuals);
+
+private:
+	bool        compiled;
+	bool        postVars;                   // Some statement assigns to a post-variable
+	std::vector<std::vector<Slot> > slots;  // The slots of each statement
+	std::vector<bool> successors;           // Whether each statement has a successor function
+};
+
 /*==============================================================================
  * The TableEntry class represents a single instruction - a string/RTL pair.
  *
@@ -197,6 +231,7 @@ public:
 public:
 	std::list<std::string> params;
 	RTL rtl;
+	RTLTemplate tmpl;  // Compiled form of rtl and params; see RTLInstDict::compileTemplates()
 
 #define TEF_NEXTPC 1
 	int flags;  // aka required capabilities. Init. to 0
@@ -252,6 +287,14 @@ public:
 	// dictionary.
 	bool readSSLFile(const std::string &SSLFileName);
 
+	// Read the dictionary from the precompiled form of the given SSL file, if there is one and it is up to date.
+	bool readCache(const std::string &SSLFileName);
+	// Write the precompiled form of the dictionary, read from the given SSL file, for readCache().
+	bool writeCache(const std::string &SSLFileName);
+
+	// Compile the instruction templates, once the dictionary is complete, for instantiateRTL()
+	void compileTemplates();
+
 	// Reset the object to "undo" a readSSLFile()
 	void reset();
 
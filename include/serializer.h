@@ -0,0 +1,84 @@
+/**
+ * \file
+ * \brief Binary form of expressions, types, statements, RTLs and signatures, for the precompiled SSL and signature
+ *        files.
+ *
+ * \copyright
+ * See the file "LICENSE.TERMS" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#ifndef SERIALIZER_H
+#define SERIALIZER_H
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+class Exp;
+class Type;
+class Statement;
+class RTL;
+class Register;
+class Signature;
+
+/*==============================================================================
+ * Serializer appends objects to a buffer, in prefix order. Everything is 32 bit little endian words and length
+ * counted strings, so the files can be shared between hosts. Anything the format does not know (e.g. a statement
+ * other than an assignment, or a subscripted expression) clears ok; the caller should then not save the buffer.
+ *============================================================================*/
+class Serializer {
+public:
+	std::string buf;
+	bool        ok;
+
+	            Serializer() : ok(true) { }
+
+	void        word(int w);
+	void        str(const char *s);
+	void        strList(std::list<std::string> &l);
+	void        reg(Register &r);
+	void        type(Type *ty);
+	void        exp(Exp *e);
+	void        stmt(Statement *s);
+	void        rtl(RTL *r);
+	void        sig(Signature *s);
+
+	// Write the buffer to the named file. The file is written under a temporary name and then renamed, so that other
+	// processes never see half a file
+	bool        writeFile(const std::string &fileName);
+};
+
+/*==============================================================================
+ * Deserializer reads back what Serializer wrote, from a buffer owned by the caller. Running off the end of the
+ * buffer, or finding anything unexpected, clears ok; the objects returned after that are placeholders.
+ *============================================================================*/
+class Deserializer {
+	const unsigned char *start, *p, *end;
+public:
+	bool        ok;
+
+	            Deserializer(const char *buf, size_t len) :
+		            start((const unsigned char *)buf), p(start), end(start + len), ok(true) { }
+
+	int         word();
+	std::string str();
+	void        strList(std::list<std::string> &l);
+	void        reg(Register &r);
+	Type       *type();
+	Exp        *exp();
+	Statement  *stmt();
+	RTL        *rtl();
+	Signature  *sig();
+
+	bool        atEnd() { return p == end; }
+	size_t      offset() { return p - start; }
+	size_t      left() { return end - p; }     // Bytes not yet read
+
+	// Read the whole of the named file into buf. Returns false if it can't be read or is empty
+	static bool readFile(const std::string &fileName, std::vector<char> &buf);
+};
+
+#endif
@@ -48,6 +48,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 	                    Parameter() : type(NULL), name(""), exp(NULL) { }
 };
 
@@ -63,6 +64,7 @@ public:
 
 	                    Return() : type(NULL), exp(NULL) { }
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 typedef std::vector<Return *> Returns;
@@ -243,6 +245,9 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
+	friend class Serializer;
+	friend class Deserializer;
 	                    Signature() : name(""), rettype(NULL), ellipsis(false), preferedReturn(NULL), preferedName("") { }
 	        void        appendParameter(Parameter *p) { params.push_back(p); }
 	        //void        appendImplicitParameter(ImplicitParameter *p) { implicitParams.push_back(p); }
@@ -259,6 +264,11 @@ public:
 	virtual Signature  *clone();
 	        void        setSP(int nsp);
 	virtual int         getStackRegister() throw (StackRegisterNotDefinedException) { return sp; };
+
+protected:
+	friend class Serializer;
+	friend class Deserializer;
+	friend class Snapshot;
 };
 
 #endif
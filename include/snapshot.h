@@ -0,0 +1,166 @@
+/**
+ * \file
+ * \brief Interface for the Snapshot class, which saves the whole state of a Prog to a binary file and loads it back.
+ *
+ * \copyright
+ * See the file "LICENSE.TERMS" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "exphelp.h"
+#include "exp.h"        // For embedded class ExpFactory
+#include "serializer.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Prog;
+class Proc;
+class UserProc;
+class Cfg;
+class BasicBlock;
+class Cluster;
+class RTL;
+class Statement;
+class Type;
+class Signature;
+class DefCollector;
+class UseCollector;
+class LocationSet;
+class StatementList;
+class DataIntervalMap;
+class DataFlow;
+class BitSet;
+class Global;
+
+/*==============================================================================
+ * Snapshot saves the state of a Prog (its procs with their CFGs, RTLs and statements, the expressions and types they
+ * use, the globals and the clusters) to a binary file, and loads it back, for the -SD and -LD switches and the save
+ * and load commands.
+ *
+ * Sharing is kept. Clusters, procs, basic blocks and statements are numbered, and the file starts with the class of
+ * each, so the loader makes them all before reading any, and references to them (e.g. the definition of a RefExp)
+ * can go forwards. Expressions, types and signatures are written in full where first seen, and by number after that.
+ * The file starts with a magic word and a version; a file of another version is not read.
+ *
+ * Range information and recursion groups are not saved; they are recomputed by the passes that use them. The dataflow
+ * tables are saved without their working sets, as for a proc that has reached PROC_FINAL.
+ *
+ * A single decompiled proc can also be saved and restored (for ProcCache), with the other procs referred to by address.
+ *============================================================================*/
+class Snapshot {
+public:
+	static const int MAGIC = 0x50414e53;    // "SNAP"
+	static const int FORMAT_VERSION = 3;
+
+	// Save prog to the named file. Returns false if it can't be written, or holds something the format doesn't know
+	static  bool        save(Prog *prog, const std::string &fileName);
+	// Read a Prog from the named file, without loading its binary file. Returns NULL if the file can't be read, or
+	// isn't a snapshot of this version
+	static  Prog       *read(const std::string &fileName);
+	// As read(), then load the binary file the Prog came from and set up its front end, ready to go on decompiling
+	static  Prog       *load(const std::string &fileName);
+
+	// Append the state of a decompiled proc to out, for ProcCache. Returns false if it holds something the format
+	// doesn't know
+	static  bool        saveProc(UserProc *proc, Serializer &out);
+	// Restore proc, decoded but not yet decompiled, from what saveProc() wrote, which is the rest of in. Returns false,
+	// with proc unchanged, if it can't be restored into this prog
+	static  bool        loadProc(UserProc *proc, Deserializer &in);
+
+private:
+	                    Snapshot() : only(NULL), in(NULL), prog(NULL) { }
+
+	// When saving or loading one proc, that proc. Other procs are referred to by address
+	        UserProc   *only;
+
+	/* Saving */
+	        Serializer  out;
+	        std::map<Cluster *, int> clusterIds;
+	        std::map<Proc *, int> procIds;
+	        std::map<BasicBlock *, int> bbIds;
+	        std::map<Statement *, int> stmtIds;
+	        std::map<Exp *, int> expIds;
+	        std::map<Type *, int> typeIds;
+	        std::map<Signature *, int> sigIds;
+	// The numbered objects, in order of number. Their bodies are written in the same order, after the prog
+	        std::vector<Cluster *> clusterList;
+	        std::vector<Proc *> procList;
+	        std::vector<BasicBlock *> bbList;
+	        std::vector<Statement *> stmtList;
+
+	        void        writeProg(Prog *prog);
+	        void        writeGlobals(UserProc *proc);
+	        void        writeBodies();
+	        void        finish(Serializer &file);
+	        void        id(Cluster *c);
+	        void        id(Proc *p);
+	        void        id(BasicBlock *bb);
+	        void        id(Statement *s);
+	        void        writeCluster(Cluster *c);
+	        void        writeProc(Proc *p);
+	        void        writeCfg(Cfg *cfg);
+	        void        writeDataFlow(DataFlow &df);
+	        void        writeBits(BitSet &bs);
+	        void        writeBB(BasicBlock *bb);
+	        void        writeRtl(RTL *r);
+	        void        writeStmt(Statement *s);
+	        void        writeExp(Exp *e);
+	        void        writeType(Type *ty);
+	        void        writeSig(Signature *s);
+	        void        writeStmts(StatementList &sl);
+	        void        writeLocs(LocationSet &ls);
+	        void        writeDefs(DefCollector &dc);
+	        void        writeUses(UseCollector &uc);
+	        void        writeExpMap(std::map<Exp *, Exp *, lessExpStar> &m);
+	        void        writeDataMap(DataIntervalMap &dim);
+
+	/* Loading */
+	        Deserializer *in;
+	        Prog       *prog;
+	        std::vector<Cluster *> clusters;
+	        std::vector<Proc *> procs;
+	        std::vector<BasicBlock *> bbs;
+	        std::vector<Statement *> stmts;
+	        std::vector<Exp *> exps;
+	        ExpFactory  shared;             // Makes the nodes that were shared (interned) when saved, shared again
+	        std::vector<Type *> types;
+	        std::vector<Signature *> sigs;
+	// Assigns for the DefCollectors, which are sets ordered by the left hand sides, so can only be filled in once
+	// all the statements are read
+	        std::list<std::pair<DefCollector *, int> > pendingDefs;
+
+	        bool        readHead();
+	        void        readProg();
+	        bool        readProcState(std::vector<Global *> &newGlobals);
+	        void        readBodies();
+	        Cluster    *cluster();
+	        Proc       *proc();
+	        BasicBlock *bb();
+	        Statement  *stmt();
+	        void        readCluster(Cluster *c);
+	        void        readProc(Proc *p);
+	        void        readCfg(Cfg *cfg);
+	        void        readDataFlow(DataFlow &df);
+	        void        readBits(BitSet &bs);
+	        void        readBB(BasicBlock *bb);
+	        RTL        *readRtl();
+	        void        readStmt(Statement *s);
+	        Exp        *readExp();
+	        Type       *readType();
+	        Signature  *readSig();
+	        void        readStmts(StatementList &sl);
+	        void        readLocs(LocationSet &ls);
+	        void        readDefs(DefCollector &dc);
+	        void        readUses(UseCollector &uc);
+	        void        readExpMap(std::map<Exp *, Exp *, lessExpStar> &m);
+	        void        readDataMap(DataIntervalMap &dim);
+};
+
+#endif
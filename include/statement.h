@@ -254,6 +254,8 @@ public:
 	// Set force to true to propagate even memofs (for switch analysis)
 	        bool        propagateTo(bool &convert, std::map<Exp *, int, lessExpStar> *destCounts = NULL, LocationSet *usedByDomPhi = NULL, bool force = false);
 	        bool        propagateFlagsTo();
+	// Tell the proc's def-use index that the RefExps used by this statement have changed
+	        void        usesChanged();
 
 	// code generation
 	virtual void        generateCode(HLLCode *hll, BasicBlock *pbb, int indLevel) = 0;
@@ -355,6 +357,7 @@ public:
 	        bool        mayAlias(Exp *e1, Exp *e2, int size);
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 // Print the Statement (etc) poited to by p
@@ -451,6 +454,7 @@ public:
 	        void        dfaTypeAnalysis(bool &ch);
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 
@@ -534,6 +538,7 @@ public:
 	        bool        match(const char *pattern, std::map<std::string, Exp *> &bindings);
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -627,6 +632,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 // An implicit assignment has only a left hand side. It is a placeholder for storing the types of parameters and
@@ -729,6 +735,7 @@ public:
 	virtual void        dfaTypeAnalysis(bool &ch);
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 // An implicit reference has only an expression. It holds the type information that results from taking the address
@@ -757,6 +764,8 @@ public:
 	virtual void        generateCode(HLLCode *, BasicBlock *, int) { }
 	virtual void        simplify();
 	virtual void        print(std::ostream &os, bool html = false);
+
+	friend class Snapshot;
 };
 
 
@@ -830,6 +839,7 @@ public:
 	virtual bool        usesExp(Exp *);
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class JunctionStatement: public Statement {
@@ -950,6 +960,7 @@ public:
 	        void        dfaTypeAnalysis(bool &ch);
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -1006,6 +1017,7 @@ public:
 	virtual void        simplify();
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 /*==============================================================================
@@ -1184,6 +1196,7 @@ protected:
 	        void        updateDefineWithType(int n);
 	        void        appendArgument(Assignment *as) { arguments.append(as); }
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 
@@ -1228,7 +1241,7 @@ public:
 	typedef StatementList::iterator iterator;
 	        iterator    begin()             { return returns.begin(); }
 	        iterator    end()               { return returns.end(); }
-	        iterator    erase(iterator it)  { return returns.erase(it); }
+	        iterator    erase(iterator it)  { usesChanged(); return returns.erase(it); }
 	        StatementList &getModifieds()   { return modifieds; }
 	        StatementList &getReturns()     { return returns; }
 	        unsigned    getNumReturns()     { return returns.size(); }
@@ -1301,6 +1314,7 @@ public:
 	        //void        specialProcessing();
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 #endif
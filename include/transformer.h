@@ -9,19 +9,37 @@
 #ifndef TRANSFORMER_H
 #define TRANSFORMER_H
 
+#include "operator.h"
+
 #include <list>
+#include <map>
+#include <vector>
 
 class ExpTransformer {
 protected:
 	static std::list<ExpTransformer *> transformers;
+	// The transformers by the operator at the root of the expressions they can apply to, each in order of creation.
+	// Those that can apply to any expression are under opWild. Rebuilt when a transformer is added
+	static std::map<OPER, std::vector<ExpTransformer *> > byOper;
+	static bool indexed;
+	int seq;  // Order of creation
 public:
 	ExpTransformer();
 	virtual ~ExpTransformer() { }  // Prevent gcc4 warning
 
 	static void loadAll();
 
+	// The operator at the root of every expression this applies to, or opWild if it is not known
+	virtual OPER getOper() { return opWild; }
 	virtual Exp *applyTo(Exp *e, bool &bMod) = 0;
 	static Exp *applyAllTo(Exp *e, bool &bMod);
+	// Forget the results remembered by applyAllTo
+	static void clearCache();
+
+private:
+	static void index();
+	static ExpTransformer *next(OPER op, int seq);
+	static bool seqLess(ExpTransformer *t, int seq);
 };
 
 #endif
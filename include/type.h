@@ -200,6 +200,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class VoidType : public Type {
@@ -224,6 +225,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class FuncType : public Type {
@@ -256,6 +258,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class IntegerType : public Type {
@@ -299,6 +302,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class FloatType : public Type {
@@ -329,6 +333,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class BooleanType : public Type {
@@ -353,6 +358,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class CharType : public Type {
@@ -377,6 +383,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class PointerType : public Type {
@@ -411,6 +418,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 class ArrayType : public Type {
@@ -447,6 +455,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 	                    ArrayType() : Type(eArray), base_type(NULL), length(0) { }
 };
 
@@ -480,6 +489,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 // The compound type represents structures, not unions
@@ -535,6 +545,8 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
+	friend class Deserializer;
 };
 
 // The union type represents the union of any number of any other types
@@ -579,6 +591,7 @@ public:
 
 protected:
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 // This class is for before type analysis. Typically, you have no info at all, or only know the size (e.g.
@@ -605,6 +618,7 @@ public:
 	virtual bool        isCompatible(Type *other, bool all);
 
 	friend class XMLProgParser;
+	friend class Snapshot;
 };
 
 // This class represents the upper half of its base type
@@ -698,6 +712,8 @@ private:
 	        void        enterComponent(DataIntervalEntry *pdie, ADDRESS addr, const char *name, Type *ty, bool forced);
 	        void        replaceComponents(ADDRESS addr, const char *name, Type *ty, bool forced);
 	        void        checkMatching(DataIntervalEntry *pdie, ADDRESS addr, const char *name, Type *ty, bool forced);
+
+	friend class Snapshot;
 };
 
 // Not part of the Type class, but logically belongs with it:
@@ -23,16 +23,22 @@
 
 #include "BinaryFile.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include <cstdio>
 #include <cstring>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
 BinaryFile::BinaryFile(bool bArch /*= false*/)
 {
 	m_bArchive = bArch;  // Remember whether an archive member
 	m_iNumSections = 0;  // No sections yet
 	m_pSections = 0;     // No section data yet
+	indexedSections = 0;      // Not indexed
+	indexedNumSections = -1;
 }
 
 // This struct used to be initialised with a memset, but now that overwrites the virtual table (if compiled under gcc
@@ -57,6 +63,10 @@ SectionInfo *BinaryFile::GetSectionInfo(int idx) const
 
 int BinaryFile::GetSectionIndexByName(const char *sName)
 {
+	if (indexedSections == m_pSections && indexedNumSections == m_iNumSections) {
+		std::map<std::string, int>::const_iterator it = sectNames.find(sName);
+		return it == sectNames.end() ? -1 : it->second;
+	}
 	for (int i = 0; i < m_iNumSections; i++) {
 		if (strcmp(m_pSections[i].pSectionName, sName) == 0) {
 			return i;
@@ -67,6 +77,14 @@ int BinaryFile::GetSectionIndexByName(const char *sName)
 
 SectionInfo *BinaryFile::GetSectionInfoByAddr(ADDRESS uEntry) const
 {
+	if (indexedSections == m_pSections && indexedNumSections == m_iNumSections) {
+		// Find the last interval starting at or before uEntry
+		std::vector<ADDRESS>::const_iterator it = std::upper_bound(sectStarts.begin(), sectStarts.end(), uEntry);
+		if (it == sectStarts.begin() || it == sectStarts.end())
+			return NULL;
+		int i = sectCover[it - sectStarts.begin() - 1];
+		return i == -1 ? NULL : &m_pSections[i];
+	}
 	SectionInfo *pSect;
 	for (int i = 0; i < m_iNumSections; i++) {
 		pSect = &m_pSections[i];
@@ -80,6 +98,45 @@ SectionInfo *BinaryFile::GetSectionInfoByAddr(ADDRESS uEntry) const
 	return NULL;
 }
 
+/*==============================================================================
+ * FUNCTION:      BinaryFile::indexSections
+ * OVERVIEW:      Build the index used by GetSectionInfoByAddr() and GetSectionIndexByName(). Sections may overlap, so
+ *                  the address range is cut into intervals at every section start and end, and each interval records
+ *                  the lowest numbered section covering it. That is the section the linear search would have found.
+ * PARAMETERS:    <none>
+ * RETURNS:       <nothing>
+ *============================================================================*/
+void BinaryFile::indexSections()
+{
+	sectStarts.clear();
+	sectCover.clear();
+	sectNames.clear();
+	for (int i = 0; i < m_iNumSections; i++) {
+		SectionInfo &sect = m_pSections[i];
+		if (sect.pSectionName)
+			sectNames.insert(std::pair<std::string, int>(sect.pSectionName, i));  // Keeps the first of each name
+		// Empty sections (and any that wrap around the address space) contain no addresses
+		if (sect.uNativeAddr + sect.uSectionSize <= sect.uNativeAddr) continue;
+		sectStarts.push_back(sect.uNativeAddr);
+		sectStarts.push_back(sect.uNativeAddr + sect.uSectionSize);
+	}
+	std::sort(sectStarts.begin(), sectStarts.end());
+	sectStarts.erase(std::unique(sectStarts.begin(), sectStarts.end()), sectStarts.end());
+	if (!sectStarts.empty())
+		sectCover.resize(sectStarts.size() - 1, -1);
+	for (int i = 0; i < m_iNumSections; i++) {
+		SectionInfo &sect = m_pSections[i];
+		ADDRESS end = sect.uNativeAddr + sect.uSectionSize;
+		if (end <= sect.uNativeAddr) continue;
+		int j = std::lower_bound(sectStarts.begin(), sectStarts.end(), sect.uNativeAddr) - sectStarts.begin();
+		for (; sectStarts[j] < end; j++)
+			if (sectCover[j] == -1)
+				sectCover[j] = i;
+	}
+	indexedSections = m_pSections;
+	indexedNumSections = m_iNumSections;
+}
+
 SectionInfo *BinaryFile::GetSectionInfoByName(const char *sName)
 {
 	int i = GetSectionIndexByName(sName);
@@ -196,3 +253,30 @@ void BinaryFile::getTextLimits()
 		}
 	}
 }
+
+char *BinaryFile::mapFile(FILE *f, long offset, size_t size, char *addr /* = NULL */)
+{
+	if (size == 0) return NULL;
+	fflush(f);  // In case of any buffered writes
+	void *p = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | (addr ? MAP_FIXED : 0), fileno(f), offset);
+	if (p == MAP_FAILED) return NULL;
+	return (char *)p;
+}
+
+char *BinaryFile::mapZeroes(size_t size)
+{
+	if (size == 0) return NULL;
+	void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) return NULL;
+	return (char *)p;
+}
+
+void BinaryFile::unmap(char *addr, size_t size)
+{
+	if (addr) munmap(addr, size);
+}
+
+size_t BinaryFile::pageSize()
+{
+	return sysconf(_SC_PAGESIZE);
+}
@@ -149,6 +149,7 @@ BinaryFile *BinaryFileFactory::Load(const char *name)
 		return NULL;
 	}
 
+	pBF->indexSections();
 	pBF->getTextLimits();
 	return pBF;
 }
@@ -20,6 +20,7 @@
 
 #include "ElfBinaryFile.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include <cstring>
@@ -46,6 +47,7 @@ ElfBinaryFile::~ElfBinaryFile()
 void ElfBinaryFile::Init()
 {
 	m_pImage = 0;
+	m_bMapped = false;
 	m_pPhdrs = 0;    // No program headers
 	m_pShdrs = 0;    // No section headers
 	m_pStrings = 0;  // No strings
@@ -55,6 +57,7 @@ void ElfBinaryFile::Init()
 	m_uPltMax = 0;
 	m_iLastSize = 0;
 	m_pImportStubs = 0;
+	m_relocAddrs.clear();
 }
 
 // Hand decompiled from sparc library function
@@ -101,20 +104,26 @@ bool ElfBinaryFile::RealLoad(const char *sName)
 	}
 	m_lImageSize = ftell(m_fd);
 
-	// Allocate memory to hold the file
-	m_pImage = new char[m_lImageSize];
-	if (m_pImage == 0) {
-		fprintf(stderr, "Could not allocate %ld bytes for program image\n", m_lImageSize);
-		return false;
+	// Map the file. The sections point straight into the mapping; only the pages that applyRelocations() writes to
+	// are copied
+	m_pImage = mapFile(m_fd, 0, m_lImageSize);
+	m_bMapped = m_pImage != NULL;
+	if (!m_bMapped) {
+		// Allocate memory to hold the file
+		m_pImage = new char[m_lImageSize];
+		if (m_pImage == 0) {
+			fprintf(stderr, "Could not allocate %ld bytes for program image\n", m_lImageSize);
+			return false;
+		}
+
+		// Read the whole file in
+		fseek(m_fd, 0, SEEK_SET);
+		size_t size = fread(m_pImage, 1, m_lImageSize, m_fd);
+		if (size != (size_t)m_lImageSize)
+			fprintf(stderr, "WARNING! Only read %ud of %ld bytes of binary file!\n", size, m_lImageSize);
 	}
 	Elf32_Ehdr *pHeader = (Elf32_Ehdr *)m_pImage;  // Save a lot of casts
 
-	// Read the whole file in
-	fseek(m_fd, 0, SEEK_SET);
-	size_t size = fread(m_pImage, 1, m_lImageSize, m_fd);
-	if (size != (size_t)m_lImageSize)
-		fprintf(stderr, "WARNING! Only read %ud of %ld bytes of binary file!\n", size, m_lImageSize);
-
 	// Basic checks
 	if (strncmp(m_pImage, "\x7F""ELF", 4) != 0) {
 		fprintf(stderr, "Incorrect header: %02X %02X %02X %02X\n",
@@ -260,6 +269,7 @@ bool ElfBinaryFile::RealLoad(const char *sName)
 
 	// Apply relocations; important when the input program is not compiled with -fPIC
 	applyRelocations();
+	buildRelocIndex();
 
 	return true;  // Success
 }
@@ -267,7 +277,10 @@ bool ElfBinaryFile::RealLoad(const char *sName)
 // Clean up and unload the binary image
 void ElfBinaryFile::UnLoad()
 {
-	if (m_pImage) delete [] m_pImage;
+	if (m_bMapped)
+		unmap(m_pImage, m_lImageSize);
+	else if (m_pImage)
+		delete [] m_pImage;
 	fclose(m_fd);
 	Init();  // Set all internal state to 0
 }
@@ -1172,10 +1185,12 @@ void ElfBinaryFile::applyRelocations()
 	}
 }
 
-bool ElfBinaryFile::IsRelocationAt(ADDRESS uNative)
+// The decoder asks about every immediate and displacement, so find the relocated words once, at load time, rather
+// than walking the relocation sections for each
+void ElfBinaryFile::buildRelocIndex()
 {
-	//int nextFakeLibAddr = -2;  // See R_386_PC32 below; -1 sometimes used for main
-	if (m_pImage == 0) return false;  // No file loaded
+	m_relocAddrs.clear();
+	if (m_pImage == 0) return;  // No file loaded
 	int machine = elfRead2(&((Elf32_Ehdr *)m_pImage)->e_machine);
 	int e_type = elfRead2(&((Elf32_Ehdr *)m_pImage)->e_type);
 	switch (machine) {
@@ -1217,11 +1232,12 @@ bool ElfBinaryFile::IsRelocationAt(ADDRESS uNative)
 							pRelWord = destNatOrigin + r_offset;
 						else {
 							SectionInfo *destSec = GetSectionInfoByAddr(r_offset);
+							if (destSec == NULL)
+								continue;
 							pRelWord = destSec->uNativeAddr + r_offset;
 							destNatOrigin = 0;
 						}
-						if (uNative == pRelWord)
-							return true;
+						m_relocAddrs.push_back(pRelWord);
 					}
 				}
 			}
@@ -1229,7 +1245,13 @@ bool ElfBinaryFile::IsRelocationAt(ADDRESS uNative)
 	default:
 		break;  // Not implemented
 	}
-	return false;
+	std::sort(m_relocAddrs.begin(), m_relocAddrs.end());
+	m_relocAddrs.erase(std::unique(m_relocAddrs.begin(), m_relocAddrs.end()), m_relocAddrs.end());
+}
+
+bool ElfBinaryFile::IsRelocationAt(ADDRESS uNative)
+{
+	return std::binary_search(m_relocAddrs.begin(), m_relocAddrs.end(), uNative);
 }
 
 const char *ElfBinaryFile::getFilenameSymbolFor(const char *sym)
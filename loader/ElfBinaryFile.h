@@ -203,6 +203,8 @@ public:
 	        void        writeObjectFile(std::string &path, const char *name, void *ptxt, int txtsz, RelocMap &reloc);
 	// Apply relocations; important when compiled without -fPIC
 	        void        applyRelocations();
+	// Fill m_relocAddrs, for IsRelocationAt()
+	        void        buildRelocIndex();
 
 //
 //  --  --  --  --  --  --  --  --  --  --  --
@@ -261,6 +263,7 @@ private:
 	        FILE       *m_fd;                           // File stream
 	        long        m_lImageSize;                   // Size of image in bytes
 	        char       *m_pImage;                       // Pointer to the loaded image
+	        bool        m_bMapped;                      // True if m_pImage is mapped rather than allocated
 	        Elf32_Phdr *m_pPhdrs;                       // Pointer to program headers
 	        Elf32_Shdr *m_pShdrs;                       // Array of section header structs
 	        char       *m_pStrings;                     // Pointer to the string section
@@ -283,6 +286,7 @@ private:
 	        ADDRESS     next_extern;                    // where the next extern will be placed
 	        int        *m_sh_link;                      // pointer to array of sh_link values
 	        int        *m_sh_info;                      // pointer to array of sh_info values
+	        std::vector<ADDRESS> m_relocAddrs;          // Sorted native addresses of the words relocated
 };
 
 #endif
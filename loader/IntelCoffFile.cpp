@@ -4,6 +4,8 @@
 
 #include "IntelCoffFile.h"
 
+#include <algorithm>
+
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
@@ -294,6 +296,9 @@ bool IntelCoffFile::RealLoad(const char *sName)
 #endif
 	}
 
+	std::sort(m_Relocations.begin(), m_Relocations.end());
+	m_Relocations.erase(std::unique(m_Relocations.begin(), m_Relocations.end()), m_Relocations.end());
+
 	// TODO: Perform relocation
 	// TODO: Define symbols (internal, exported, imported)
 
@@ -398,10 +403,7 @@ bool IntelCoffFile::IsDynamicLinkedProc(ADDRESS uNative)
 
 bool IntelCoffFile::IsRelocationAt(ADDRESS uNative)
 {
-	for (std::list<ADDRESS>::iterator it = m_Relocations.begin(); it != m_Relocations.end(); it++) {
-		if (*it == uNative) return true;
-	}
-	return false;
+	return std::binary_search(m_Relocations.begin(), m_Relocations.end(), uNative);
 }
 
 std::map<ADDRESS, std::string> &IntelCoffFile::getSymbols()
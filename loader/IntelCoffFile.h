@@ -65,7 +65,7 @@ private:
 	const char *m_pFilename;
 	FILE *m_fd;
 	std::list<SectionInfo *> m_EntryPoints;
-	std::list<ADDRESS> m_Relocations;
+	std::vector<ADDRESS> m_Relocations;  // Sorted once loaded, for IsRelocationAt()
 	struct coff_header m_Header;
 
 	SectionInfo *AddSection(SectionInfo *);
@@ -29,6 +29,7 @@
 #include <dlfcn.h>          // dlopen, dlsym
 
 #include <iostream>         // For cout
+#include <cstring>          // For strcmp
 #include <string>
 
 /*==============================================================================
@@ -567,3 +568,71 @@ void LoaderTest::testElfHash()
 	unsigned exp = 0x737fe;
 	CPPUNIT_ASSERT_EQUAL(exp, act);
 }
+
+/*==============================================================================
+ * FUNCTION:        LoaderTest::testSectionIndex
+ * OVERVIEW:        Test that the indexed section lookups agree with a linear search of the section table
+ *============================================================================*/
+void LoaderTest::testSectionIndex()
+{
+	BinaryFileFactory bff;
+	BinaryFile *pBF = bff.Load(HELLO_PENTIUM);
+	CPPUNIT_ASSERT(pBF != NULL);
+	int n = pBF->GetNumSections();
+	for (int i = 0; i < n; i++) {
+		SectionInfo *si = pBF->GetSectionInfo(i);
+		// Probe either side of both ends of the section
+		ADDRESS probes[4] = {
+			si->uNativeAddr - 1, si->uNativeAddr,
+			si->uNativeAddr + si->uSectionSize - 1, si->uNativeAddr + si->uSectionSize
+		};
+		for (int p = 0; p < 4; p++) {
+			SectionInfo *expected = NULL;
+			for (int j = 0; j < n && expected == NULL; j++) {
+				SectionInfo *sj = pBF->GetSectionInfo(j);
+				if (probes[p] >= sj->uNativeAddr && probes[p] < sj->uNativeAddr + sj->uSectionSize)
+					expected = sj;
+			}
+			CPPUNIT_ASSERT_EQUAL(expected, pBF->GetSectionInfoByAddr(probes[p]));
+		}
+		int first = 0;
+		while (strcmp(pBF->GetSectionInfo(first)->pSectionName, si->pSectionName) != 0)
+			first++;
+		CPPUNIT_ASSERT_EQUAL(first, pBF->GetSectionIndexByName(si->pSectionName));
+	}
+	CPPUNIT_ASSERT_EQUAL(-1, pBF->GetSectionIndexByName(".no_such_section"));
+	pBF->UnLoad();
+	bff.UnLoad();
+}
+
+/*==============================================================================
+ * FUNCTION:        LoaderTest::testRelocIndex
+ * OVERVIEW:        Test that IsRelocationAt finds the word of each entry of the relocation sections, and not code
+ *============================================================================*/
+void LoaderTest::testRelocIndex()
+{
+	BinaryFileFactory bff;
+	BinaryFile *pBF = bff.Load(HELLO_PENTIUM);
+	CPPUNIT_ASSERT(pBF != NULL);
+	int numRelocs = 0;
+	for (int i = 0; i < pBF->GetNumSections(); i++) {
+		SectionInfo *si = pBF->GetSectionInfo(i);
+		if (si->uType != 9)  // SHT_REL
+			continue;
+		const unsigned char *p = (const unsigned char *)si->uHostAddr;
+		for (unsigned u = 0; u < si->uSectionSize; u += 8) {
+			ADDRESS r_offset = p[u] | (p[u + 1] << 8) | (p[u + 2] << 16) | ((ADDRESS)p[u + 3] << 24);
+			SectionInfo *dest = pBF->GetSectionInfoByAddr(r_offset);
+			if (dest == NULL)
+				continue;
+			// Not an executable's r_offset as such, but the address the loader has always checked for
+			ADDRESS a = dest->uNativeAddr + r_offset;
+			CPPUNIT_ASSERT(pBF->IsRelocationAt(a));
+			numRelocs++;
+		}
+	}
+	CPPUNIT_ASSERT(numRelocs > 0);
+	CPPUNIT_ASSERT(!pBF->IsRelocationAt(pBF->GetMainEntryPoint()));
+	pBF->UnLoad();
+	bff.UnLoad();
+}
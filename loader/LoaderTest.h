@@ -14,6 +14,8 @@ class LoaderTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testMicroDis2);
 
 	CPPUNIT_TEST(testElfHash);
+	CPPUNIT_TEST(testSectionIndex);
+	CPPUNIT_TEST(testRelocIndex);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -29,4 +31,6 @@ public:
 	void testMicroDis2();
 
 	void testElfHash();
+	void testSectionIndex();
+	void testRelocIndex();
 };
@@ -96,7 +96,7 @@ typedef char ct_failure[sizeof (SectionInfo) == sizeof (PESectionInfo) ? 1 : -1]
 }
 
 
-Win32BinaryFile::Win32BinaryFile() : m_pFilename(NULL), mingw_main(false)
+Win32BinaryFile::Win32BinaryFile() : base(NULL), m_imageSize(0), m_bMapped(false), m_pFilename(NULL), mingw_main(false)
 {
 }
 
@@ -404,7 +404,13 @@ bool Win32BinaryFile::RealLoad(const char *sName)
 	fread(&tmphdr, sizeof tmphdr, 1, fp);
 	// Note: all tmphdr fields will be little endian
 
-	base = (char *)malloc(LMMH(tmphdr.ImageSize));
+	// Map zeroes for the image, then map the sections over it where the file layout allows, so that only relocated and
+	// partial pages need copies
+	m_imageSize = LMMH(tmphdr.ImageSize);
+	base = mapZeroes(m_imageSize);
+	m_bMapped = base != NULL;
+	if (!m_bMapped)
+		base = (char *)malloc(m_imageSize);
 
 	if (!base) {
 		fprintf(stderr, "Cannot allocate memory for copy of image\n");
@@ -453,9 +459,7 @@ bool Win32BinaryFile::RealLoad(const char *sName)
 		sect.bData     = Flags & IMAGE_SCN_CNT_INITIALIZED_DATA   ? 1 : 0;
 		sect.bReadOnly = Flags & IMAGE_SCN_MEM_WRITE              ? 0 : 1;
 		// TODO: Check for unreadable sections (!IMAGE_SCN_MEM_READ)?
-		fseek(fp, LMMH(o->PhysicalOffset), SEEK_SET);
-		memset(base + LMMH(o->RVA), 0, LMMH(o->VirtualSize));
-		fread(base + LMMH(o->RVA), LMMH(o->PhysicalSize), 1, fp);
+		loadSection(fp, LMMH(o->RVA), LMMH(o->PhysicalOffset), LMMH(o->PhysicalSize), LMMH(o->VirtualSize));
 		s_sectionObjects[static_cast<const PESectionInfo *>(&sect)] = o;
 	}
 
@@ -554,6 +558,52 @@ void Win32BinaryFile::findJumps(ADDRESS curr)
 // Clean up and unload the binary image
 void Win32BinaryFile::UnLoad()
 {
+	if (m_bMapped)
+		unmap(base, m_imageSize);
+	else
+		free(base);
+	base = NULL;
+}
+
+/*==============================================================================
+ * FUNCTION:        Win32BinaryFile::loadSection
+ * OVERVIEW:        Load the section at rva in the image from the file. Whole pages are mapped straight from the file
+ *                  when the offset and rva are both page aligned; the rest is read in. Any space after the file's
+ *                  data up to the virtual size, or past the end of a truncated file, is zeroed. The zeroes mapped for
+ *                  the image can't be relied on for this, as an earlier section's data may have spilled over them
+ * PARAMETERS:      fp: the file
+ *                  rva: offset of the section in the image
+ *                  offset: offset of the section's data in the file
+ *                  size: size of the section's data in the file
+ *                  vsize: size of the section in the image
+ * RETURNS:         <nothing>
+ *============================================================================*/
+void Win32BinaryFile::loadSection(FILE *fp, DWord rva, DWord offset, DWord size, DWord vsize)
+{
+	if (rva > m_imageSize) return;
+	if (rva + size > m_imageSize)
+		size = m_imageSize - rva;
+	DWord end = vsize < m_imageSize - rva ? vsize : m_imageSize - rva;  // Of the section in the image
+	DWord done = 0;
+	size_t page = pageSize();
+	if (m_bMapped && rva % page == 0 && offset % page == 0) {
+		// Map the whole pages in the file; a partial last page would show the file's next bytes instead of zeroes, and
+		// a page past the end of a truncated file would fault when touched
+		fseek(fp, 0, SEEK_END);
+		long fileLength = ftell(fp);
+		DWord avail = (long)offset < fileLength ? fileLength - offset : 0;
+		if (avail > size)
+			avail = size;
+		done = avail - avail % page;
+		if (done && mapFile(fp, offset, done, base + rva) == NULL)
+			done = 0;
+	}
+	if (done < size) {
+		fseek(fp, offset + done, SEEK_SET);
+		done += fread(base + rva + done, 1, size - done, fp);
+	}
+	if (done < end)
+		memset(base + rva + done, 0, end - done);
 }
 
 bool Win32BinaryFile::PostLoad(void *handle)
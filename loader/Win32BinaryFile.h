@@ -203,6 +203,7 @@ private:
 
 	virtual bool        PostLoad(void *handle);  // Called after archive member loaded
 	        void        findJumps(ADDRESS curr);  // Find names for jumps to IATs
+	        void        loadSection(FILE *fp, DWord rva, DWord offset, DWord size, DWord vsize);
 
 	        Header     *m_pHeader;      // Pointer to header
 	        PEHeader   *m_pPEHeader;    // Pointer to pe header
@@ -210,6 +211,8 @@ private:
 	        int         m_cReloc;       // Number of relocation entries
 	        DWord      *m_pRelocTable;  // The relocation table
 	        char       *base;           // Beginning of the loaded image
+	        size_t      m_imageSize;    // Size of the image at base
+	        bool        m_bMapped;      // True if base is mapped rather than allocated
 	// Map from address of dynamic pointers to library procedure names:
 	        std::map<ADDRESS, std::string> dlprocptrs;
 	        const char *m_pFilename;
@@ -0,0 +1,146 @@
+/**
+ * \file
+ * \brief Implementation of the Profiler class.
+ *
+ * \copyright
+ * See the file "LICENSE.TERMS" for information on usage and redistribution of
+ * this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ */
+
+#include "profiler.h"
+
+#include "proc.h"
+
+#include <fstream>
+#include <iomanip>
+
+#include <sys/time.h>  // For gettimeofday()
+
+#include <cstdio>
+
+unsigned long Profiler::numAllocs = 0;
+unsigned long Profiler::numBytes = 0;
+
+double Profiler::now()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void Profiler::alert_start_phase(UserProc *p, const char *phase)
+{
+	std::pair<UserProc *, std::string> key(p, phase);
+	std::map<std::pair<UserProc *, std::string>, int>::iterator rr = rowNums.find(key);
+	int row;
+	if (rr == rowNums.end()) {
+		row = rows.size();
+		rowNums[key] = row;
+		rows.push_back(Totals());
+		rows.back().proc = p ? p->getName() : "";
+		rows.back().phase = phase;
+	} else
+		row = rr->second;
+	Frame f;
+	f.row = row;
+	f.allocs = numAllocs;
+	f.bytes = numBytes;
+	f.childSecs = 0;
+	f.childAllocs = f.childBytes = 0;
+	f.start = now();  // Last, so the bookkeeping above is not timed
+	stack.push_back(f);
+}
+
+// End the innermost phase at time end, and return its row
+int Profiler::endFrame(double end)
+{
+	Frame f = stack.back();
+	stack.pop_back();
+	double secs = end - f.start;
+	unsigned long allocs = numAllocs - f.allocs;
+	unsigned long bytes = numBytes - f.bytes;
+	Totals &t = rows[f.row];
+	t.calls++;
+	t.selfSecs += secs - f.childSecs;
+	t.selfAllocs += allocs - f.childAllocs;
+	t.selfBytes += bytes - f.childBytes;
+	bool outermost = true;
+	for (unsigned i = 0; i < stack.size(); i++)
+		if (stack[i].row == f.row)
+			outermost = false;
+	if (outermost) {
+		t.secs += secs;
+		t.allocs += allocs;
+		t.bytes += bytes;
+	}
+	if (!stack.empty()) {
+		stack.back().childSecs += secs;
+		stack.back().childAllocs += allocs;
+		stack.back().childBytes += bytes;
+	}
+	return f.row;
+}
+
+void Profiler::alert_end_phase(UserProc *p, const char *phase)
+{
+	double end = now();
+	std::map<std::pair<UserProc *, std::string>, int>::iterator rr =
+		rowNums.find(std::pair<UserProc *, std::string>(p, phase));
+	if (rr == rowNums.end())
+		return;  // Never started
+	// Phases should end in the reverse order that they start; if an inner one didn't end, end it here too
+	while (!stack.empty() && endFrame(end) != rr->second)
+		;
+}
+
+// Quote s for a JSON string, or a CSV field
+static std::string quote(const std::string &s, bool csv)
+{
+	std::string ret("\"");
+	for (unsigned i = 0; i < s.size(); i++) {
+		char c = s[i];
+		if (c == '"')
+			ret += csv ? "\"\"" : "\\\"";
+		else if (c == '\\' && !csv)
+			ret += "\\\\";
+		else if ((unsigned char)c < ' ' && !csv) {
+			char buf[8];
+			sprintf(buf, "\\u%04x", c);
+			ret += buf;
+		} else
+			ret += c;
+	}
+	return ret + "\"";
+}
+
+bool Profiler::writeReport()
+{
+	double end = now();
+	while (!stack.empty())
+		endFrame(end);
+
+	std::ofstream out(fileName.c_str());
+	if (!out)
+		return false;
+	bool csv = fileName.size() >= 4 && fileName.compare(fileName.size() - 4, 4, ".csv") == 0;
+	out << std::fixed << std::setprecision(6);
+	if (csv)
+		out << "proc,phase,calls,seconds,selfSeconds,allocs,selfAllocs,bytes,selfBytes\n";
+	else
+		out << "{\n\t\"phases\": [";
+	for (unsigned i = 0; i < rows.size(); i++) {
+		Totals &t = rows[i];
+		if (csv)
+			out << quote(t.proc, true) << "," << t.phase << "," << t.calls << "," << t.secs << "," << t.selfSecs
+			    << "," << t.allocs << "," << t.selfAllocs << "," << t.bytes << "," << t.selfBytes << "\n";
+		else
+			out << (i ? "," : "") << "\n\t\t{ \"proc\": " << quote(t.proc, false)
+			    << ", \"phase\": " << quote(t.phase, false) << ", \"calls\": " << t.calls
+			    << ", \"seconds\": " << t.secs << ", \"selfSeconds\": " << t.selfSecs
+			    << ", \"allocs\": " << t.allocs << ", \"selfAllocs\": " << t.selfAllocs
+			    << ", \"bytes\": " << t.bytes << ", \"selfBytes\": " << t.selfBytes << " }";
+	}
+	if (!csv)
+		out << "\n\t]\n}\n";
+	return out.good();
+}
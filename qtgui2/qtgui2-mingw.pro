@@ -23,8 +23,10 @@ RESOURCES += boomerang.qrc
 
 OBJECTS += ../boomerang.o \ 
 		../log.o \
+		../profiler.o \
 		../db/prog.o \
 		../db/proc.o \
+		../db/proccache.o \
 		../db/statement.o \
 		../db/exp.o \
 		../db/cfg.o \
@@ -38,6 +40,8 @@ OBJECTS += ../boomerang.o \
 		../db/insnameelem.o \
 		../db/table.o \
 		../db/sslinst.o \
+		../db/serializer.o \
+		../db/snapshot.o \
 		../db/sslparser.o \
 		../db/sslscanner.o \
 		../db/register.o \
@@ -19,6 +19,7 @@
 #include "CfgTest.h"
 
 #include "prog.h"
+#include "boomerang.h"
 
 #include <cppunit/ui/text/TestRunner.h>
 
@@ -26,6 +27,9 @@
 
 int main(int argc, char *argv[])
 {
+	// Parse the .ssl and signature files rather than write their precompiled forms into the source tree
+	Boomerang::get()->noPrecompiled = true;
+
 	CppUnit::TextUi::TestRunner runner;
 
 	runner.addTest(ExpTest::suite());
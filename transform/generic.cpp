@@ -211,6 +211,24 @@ bool GenericExpTransformer::checkCond(Exp *cond, Exp *bindings)
 	return false;
 }
 
+// Only expressions with the same root operator as the match pattern can match it, unless the root is a variable or
+// a wildcard
+OPER GenericExpTransformer::getOper()
+{
+	switch (match->getOper()) {
+	case opVar:
+	case opWild:
+	case opWildMemOf:
+	case opWildRegOf:
+	case opWildAddrOf:
+	case opWildIntConst:
+	case opWildStrConst:
+		return opWild;
+	default:
+		return match->getOper();
+	}
+}
+
 Exp *GenericExpTransformer::applyTo(Exp *e, bool &bMod)
 {
 	bool change;
@@ -18,6 +18,7 @@ protected:
 	Exp *applyFuncs(Exp *rhs);
 public:
 	GenericExpTransformer(Exp *match, Exp *where, Exp *become) : match(match), where(where), become(become) {}
+	virtual OPER getOper();
 	virtual Exp *applyTo(Exp *e, bool &bMod);
 };
 
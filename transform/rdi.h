@@ -14,6 +14,7 @@ class RDIExpTransformer : public ExpTransformer
 {
 public:
 	RDIExpTransformer() {}
+	virtual OPER getOper() { return opAddrOf; }
 	virtual Exp *applyTo(Exp *e, bool &bMod);
 };
 
@@ -25,19 +25,61 @@
 #include <sstream>          // Need gcc 3.0 or better
 
 std::list<ExpTransformer *> ExpTransformer::transformers;
+std::map<OPER, std::vector<ExpTransformer *> > ExpTransformer::byOper;
+bool ExpTransformer::indexed = false;
 
 ExpTransformer::ExpTransformer()
 {
+	seq = transformers.size();
 	transformers.push_back(this);
+	indexed = false;  // Can't ask for getOper() until the derived class is constructed
 }
 
-std::list<Exp *> cache;
+void ExpTransformer::index()
+{
+	byOper.clear();
+	for (std::list<ExpTransformer *>::iterator it = transformers.begin(); it != transformers.end(); it++)
+		byOper[(*it)->getOper()].push_back(*it);
+	indexed = true;
+}
+
+// The first transformer created at or after seq that can apply to an expression with operator op, or NULL
+ExpTransformer *ExpTransformer::next(OPER op, int seq)
+{
+	ExpTransformer *best = NULL;
+	OPER keys[2] = { op, opWild };
+	for (int k = (op == opWild) ? 1 : 0; k < 2; k++) {
+		std::map<OPER, std::vector<ExpTransformer *> >::iterator mm = byOper.find(keys[k]);
+		if (mm == byOper.end())
+			continue;
+		std::vector<ExpTransformer *>::iterator it = std::lower_bound(mm->second.begin(), mm->second.end(), seq, seqLess);
+		if (it != mm->second.end() && (best == NULL || (*it)->seq < best->seq))
+			best = *it;
+	}
+	return best;
+}
+
+bool ExpTransformer::seqLess(ExpTransformer *t, int seq)
+{
+	return t->seq < seq;
+}
+
+// Results of applyAllTo, keyed by the hash of the original expression
+static std::multimap<unsigned, std::pair<Exp *, Exp *> > cache;
+
+void ExpTransformer::clearCache()
+{
+	cache.clear();
+}
 
 Exp *ExpTransformer::applyAllTo(Exp *p, bool &bMod)
 {
-	for (std::list<Exp *>::iterator it = cache.begin(); it != cache.end(); it++)
-		if (*(*it)->getSubExp1() == *p)
-			return (*it)->getSubExp2()->clone();
+	unsigned h = p->hash();
+	std::pair<std::multimap<unsigned, std::pair<Exp *, Exp *> >::iterator,
+	          std::multimap<unsigned, std::pair<Exp *, Exp *> >::iterator> range = cache.equal_range(h);
+	for (std::multimap<unsigned, std::pair<Exp *, Exp *> >::iterator it = range.first; it != range.second; it++)
+		if (*it->second.first == *p)
+			return it->second.second->clone();
 
 	Exp *e = p->clone();
 	Exp *subs[3];
@@ -62,16 +104,19 @@ Exp *ExpTransformer::applyAllTo(Exp *p, bool &bMod)
 #if 0
 	LOG << "applyAllTo called on " << e << "\n";
 #endif
+	if (!indexed)
+		index();
 	bool mod;
 	//do {
 		mod = false;
-		for (std::list<ExpTransformer *>::iterator it = transformers.begin(); it != transformers.end(); it++) {
-			e = (*it)->applyTo(e, mod);
+		// Each transformer in order of creation, skipping those that can't match the (current) root operator
+		for (ExpTransformer *t = next(e->getOper(), 0); t; t = next(e->getOper(), t->seq + 1)) {
+			e = t->applyTo(e, mod);
 			bMod |= mod;
 		}
 	//} while (mod);
 
-	cache.push_back(new Binary(opEquals, p->clone(), e->clone()));
+	cache.insert(std::make_pair(h, std::make_pair(p->clone(), e->clone())));
 	return e;
 }
 
@@ -17,6 +17,8 @@
 
 #include <iostream>
 
+#include <cstdio>
+
 /*==============================================================================
  * FUNCTION:        TypeTest::testTypeLong
  * OVERVIEW:        Test type unsigned long
@@ -107,6 +109,48 @@ void TypeTest::testCompound()
 	delete pFE;
 }
 
+/*==============================================================================
+ * FUNCTION:        TypeTest::testPrecompiledSigs
+ * OVERVIEW:        Test that signatures read from the precompiled form of a signature file are the same as parsed
+ *============================================================================*/
+void TypeTest::testPrecompiledSigs()
+{
+	BinaryFileFactory bff;
+	BinaryFile *pBF = bff.Load(HELLO_WINDOWS);
+	FrontEnd *pFE = new PentiumFrontEnd(pBF, new Prog, &bff);
+	Boomerang *boo = Boomerang::get();
+	boo->setLogger(new FileLogger());
+	bool save = boo->noPrecompiled;
+	boo->noPrecompiled = false;
+	std::string sigFile = boo->getProgPath() + "signatures/windows.h";
+	std::string dbFile = sigFile + ".pentium-pascal.sigdb";
+
+	// Parsing writes the precompiled form
+	remove(dbFile.c_str());
+	pFE->readLibrarySignatures(sigFile.c_str(), CONV_PASCAL);
+	FILE *f = fopen(dbFile.c_str(), "rb");
+	CPPUNIT_ASSERT(f != NULL);
+	fclose(f);
+	const char *names[] = { "BeginPaint", "CreateWindowExA", "MessageBoxA" };
+	std::string expected[3];
+	for (int i = 0; i < 3; i++)
+		expected[i] = pFE->getLibSignature(names[i])->prints();
+
+	// Reading it makes new, equal signatures
+	Signature *parsed = pFE->getLibSignature("BeginPaint");
+	pFE->readLibrarySignatures(sigFile.c_str(), CONV_PASCAL);
+	CPPUNIT_ASSERT(pFE->getLibSignature("BeginPaint") != parsed);
+	for (int i = 0; i < 3; i++) {
+		std::string actual(pFE->getLibSignature(names[i])->prints());
+		CPPUNIT_ASSERT_EQUAL(expected[i], actual);
+	}
+	CPPUNIT_ASSERT(*pFE->getLibSignature("BeginPaint") == *parsed);
+	CPPUNIT_ASSERT(Type::getNamedType("LPPAINTSTRUCT") != NULL);
+
+	boo->noPrecompiled = save;
+	delete pFE;
+}
+
 /*==============================================================================
  * FUNCTION:        TypeTest::testDataInterval
  * OVERVIEW:        Test the DataIntervalMap class
@@ -8,6 +8,7 @@ class TypeTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(testTypeLong);
 	CPPUNIT_TEST(testNotEqual);
 	CPPUNIT_TEST(testCompound);
+	CPPUNIT_TEST(testPrecompiledSigs);
 	CPPUNIT_TEST(testDataInterval);
 	CPPUNIT_TEST(testDataIntervalOverlaps);
 	CPPUNIT_TEST_SUITE_END();
@@ -18,6 +19,7 @@ public:
 	void testTypeLong();
 	void testNotEqual();
 	void testCompound();
+	void testPrecompiledSigs();
 
 	void testDataInterval();
 	void testDataIntervalOverlaps();